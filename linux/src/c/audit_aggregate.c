@@ -0,0 +1,71 @@
+#include "audit_aggregate.h"
+#include <string.h>
+
+void audit_aggregator_init(audit_aggregator_t* agg, uint32_t window_ms) {
+    memset(agg, 0, sizeof(*agg));
+    agg->window_ms = window_ms > 0 ? window_ms : 1;
+}
+
+static audit_agg_slot_t* find_slot(audit_aggregator_t* agg, uint32_t pseudo_id) {
+    uint32_t mask = AUDIT_AGG_MAX_DEVICES * 2 - 1;
+    uint32_t h = (pseudo_id * 2654435761u) & mask;
+    while (agg->map[h]) {
+        audit_agg_slot_t* slot = &agg->slots[agg->map[h] - 1];
+        if (slot->pseudo_id == pseudo_id) return slot;
+        h = (h + 1) & mask;
+    }
+    // Devices are few and long-lived, so slots are never released
+    if (agg->count == AUDIT_AGG_MAX_DEVICES) return NULL;
+    audit_agg_slot_t* slot = &agg->slots[agg->count++];
+    memset(slot, 0, sizeof(*slot));
+    slot->pseudo_id = pseudo_id;
+    agg->map[h] = (uint16_t)agg->count;
+    return slot;
+}
+
+static void emit_slot(audit_aggregator_t* agg, audit_agg_slot_t* slot, audit_window_emit_fn emit, void* ctx) {
+    if (!slot->open) return;
+    slot->window.window_ms = agg->window_ms;
+    emit(slot->start_ms, slot->pseudo_id, &slot->window, ctx);
+    slot->open = false;
+}
+
+bool audit_aggregator_add(audit_aggregator_t* agg, int64_t ts_ms, uint32_t pseudo_id, int32_t dx, int32_t dy,
+                          audit_window_emit_fn emit, void* ctx) {
+    audit_agg_slot_t* slot = find_slot(agg, pseudo_id);
+    if (!slot) return false;
+    int64_t start = ts_ms - ((ts_ms % agg->window_ms) + agg->window_ms) % agg->window_ms;
+    // Late events (producers interleave slightly) fold into the open window
+    if (slot->open && start > slot->start_ms) emit_slot(agg, slot, emit, ctx);
+    audit_window_t* w = &slot->window;
+    if (!slot->open) {
+        memset(w, 0, sizeof(*w));
+        w->min_dx = w->max_dx = dx;
+        w->min_dy = w->max_dy = dy;
+        slot->start_ms = start;
+        slot->last_ts_ms = ts_ms;
+        slot->open = true;
+    }
+    int64_t gap = ts_ms - slot->last_ts_ms;
+    if (gap > 0) w->active_ms += (uint32_t)(gap < AUDIT_AGG_ACTIVE_GAP_MS ? gap : AUDIT_AGG_ACTIVE_GAP_MS);
+    if (ts_ms > slot->last_ts_ms) slot->last_ts_ms = ts_ms;
+    w->count++;
+    w->sum_dx += dx;
+    w->sum_dy += dy;
+    if (dx < w->min_dx) w->min_dx = dx;
+    if (dx > w->max_dx) w->max_dx = dx;
+    if (dy < w->min_dy) w->min_dy = dy;
+    if (dy > w->max_dy) w->max_dy = dy;
+    return true;
+}
+
+void audit_aggregator_flush(audit_aggregator_t* agg, int64_t now_ms, audit_window_emit_fn emit, void* ctx) {
+    for (uint32_t i = 0; i < agg->count; i++) {
+        audit_agg_slot_t* slot = &agg->slots[i];
+        if (slot->open && slot->start_ms + agg->window_ms <= now_ms) emit_slot(agg, slot, emit, ctx);
+    }
+}
+
+void audit_aggregator_flush_all(audit_aggregator_t* agg, audit_window_emit_fn emit, void* ctx) {
+    for (uint32_t i = 0; i < agg->count; i++) emit_slot(agg, &agg->slots[i], emit, ctx);
+}
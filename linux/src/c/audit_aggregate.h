@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "audit_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Incremental per-device aggregation of input records into fixed windows
+// aligned to multiples of window_ms. Runs on the logger thread only.
+
+#define AUDIT_AGG_MAX_DEVICES 1024
+// Gaps between events longer than this count as idle in active_ms
+#define AUDIT_AGG_ACTIVE_GAP_MS 50
+
+typedef struct {
+    uint32_t pseudo_id;
+    bool open;
+    int64_t start_ms;
+    int64_t last_ts_ms;
+    audit_window_t window;
+} audit_agg_slot_t;
+
+typedef void (*audit_window_emit_fn)(int64_t start_ms, uint32_t pseudo_id, const audit_window_t* window, void* ctx);
+
+typedef struct {
+    uint32_t window_ms;
+    uint32_t count;
+    audit_agg_slot_t slots[AUDIT_AGG_MAX_DEVICES];
+    uint16_t map[AUDIT_AGG_MAX_DEVICES * 2];  // open-addressed id -> slot + 1 (0 = empty)
+} audit_aggregator_t;
+
+void audit_aggregator_init(audit_aggregator_t* agg, uint32_t window_ms);
+// Fold one event in; closes (emits) the device's previous window if the event
+// starts a newer one. Returns false if the device table is full.
+bool audit_aggregator_add(audit_aggregator_t* agg, int64_t ts_ms, uint32_t pseudo_id, int32_t dx, int32_t dy,
+                          audit_window_emit_fn emit, void* ctx);
+// Emit every open window that ended at or before now_ms
+void audit_aggregator_flush(audit_aggregator_t* agg, int64_t now_ms, audit_window_emit_fn emit, void* ctx);
+// Emit every open window (shutdown, rotation)
+void audit_aggregator_flush_all(audit_aggregator_t* agg, audit_window_emit_fn emit, void* ctx);
+
+#ifdef __cplusplus
+}
+#endif
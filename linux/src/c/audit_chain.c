@@ -0,0 +1,122 @@
+#include "audit_chain.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+
+static void put_u32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i)); }
+static void put_u64(uint8_t* p, uint64_t v) { for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i)); }
+static uint32_t get_u32(const uint8_t* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint64_t get_u64(const uint8_t* p) { uint64_t v = 0; for (int i = 7; i >= 0; i--) v = (v << 8) | p[i]; return v; }
+
+static bool write_full(int fd, const uint8_t* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) { if (errno == EINTR) continue; return false; }
+        buf += n; len -= (size_t)n;
+    }
+    return true;
+}
+
+// Entry fields that are covered by the digest (everything but the digest)
+static void put_fields(uint8_t* p, const audit_chain_entry_t* e) {
+    put_u64(p, e->offset);
+    put_u32(p + 8, e->length);
+    put_u32(p + 12, e->records);
+    put_u64(p + 16, (uint64_t)e->first_ts_ms);
+    put_u64(p + 24, (uint64_t)e->last_ts_ms);
+}
+
+bool audit_chain_hash_init(audit_chain_hash_t* h) {
+    h->md = EVP_MD_CTX_new();
+    return h->md != NULL;
+}
+
+void audit_chain_hash_free(audit_chain_hash_t* h) {
+    EVP_MD_CTX_free(h->md);
+    h->md = NULL;
+}
+
+void audit_chain_hash_begin(audit_chain_hash_t* h, const uint8_t prev[AUDIT_DIGEST_BYTES], const audit_chain_entry_t* entry) {
+    uint8_t fields[AUDIT_CHAIN_ENTRY_BYTES - AUDIT_DIGEST_BYTES];
+    put_fields(fields, entry);
+    EVP_DigestInit_ex(h->md, EVP_sha256(), NULL);
+    EVP_DigestUpdate(h->md, prev, AUDIT_DIGEST_BYTES);
+    EVP_DigestUpdate(h->md, fields, sizeof(fields));
+}
+
+void audit_chain_hash_update(audit_chain_hash_t* h, const uint8_t* data, size_t len) {
+    if (len > 0) EVP_DigestUpdate(h->md, data, len);
+}
+
+void audit_chain_hash_final(audit_chain_hash_t* h, uint8_t out[AUDIT_DIGEST_BYTES]) {
+    unsigned int n = 0;
+    EVP_DigestFinal_ex(h->md, out, &n);
+}
+
+void audit_chain_writer_open(audit_chain_writer_t* w, const char* path) {
+    w->fd = -1;
+    if (!w->hash.md && !audit_chain_hash_init(&w->hash)) return;
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return; }
+    uint8_t header[AUDIT_CHAIN_HEADER_BYTES];
+    if (st.st_size < AUDIT_CHAIN_HEADER_BYTES) {
+        // New (or torn before its header was complete): start from the current head
+        put_u32(header, AUDIT_CHAIN_MAGIC);
+        put_u32(header + 4, 1);
+        memcpy(header + 8, w->head, AUDIT_DIGEST_BYTES);
+        if (ftruncate(fd, 0) != 0 || !write_full(fd, header, sizeof(header))) { close(fd); return; }
+        w->fd = fd;
+        return;
+    }
+    if (pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        get_u32(header) != AUDIT_CHAIN_MAGIC || get_u32(header + 4) != 1) {
+        close(fd);
+        return;
+    }
+    // A crash can leave a partial entry; later entries must stay aligned
+    uint64_t entries = ((uint64_t)st.st_size - AUDIT_CHAIN_HEADER_BYTES) / AUDIT_CHAIN_ENTRY_BYTES;
+    off_t whole = (off_t)(AUDIT_CHAIN_HEADER_BYTES + entries * AUDIT_CHAIN_ENTRY_BYTES);
+    if (whole != st.st_size && ftruncate(fd, whole) != 0) { close(fd); return; }
+    if (entries == 0) memcpy(w->head, header + 8, AUDIT_DIGEST_BYTES);
+    else if (pread(fd, w->head, AUDIT_DIGEST_BYTES, whole - AUDIT_DIGEST_BYTES) != AUDIT_DIGEST_BYTES) { close(fd); return; }
+    w->fd = fd;
+}
+
+void audit_chain_writer_close(audit_chain_writer_t* w) {
+    if (w->fd >= 0) close(w->fd);
+    w->fd = -1;
+}
+
+void audit_chain_append(audit_chain_writer_t* w, uint64_t offset, const uint8_t* data, size_t len,
+                        uint32_t records, int64_t first_ts_ms, int64_t last_ts_ms) {
+    if (w->fd < 0 || len == 0) return;
+    audit_chain_entry_t e = { offset, (uint32_t)len, records, first_ts_ms, last_ts_ms, { 0 } };
+    audit_chain_hash_begin(&w->hash, w->head, &e);
+    audit_chain_hash_update(&w->hash, data, len);
+    audit_chain_hash_final(&w->hash, e.digest);
+    uint8_t buf[AUDIT_CHAIN_ENTRY_BYTES];
+    put_fields(buf, &e);
+    memcpy(buf + AUDIT_CHAIN_ENTRY_BYTES - AUDIT_DIGEST_BYTES, e.digest, AUDIT_DIGEST_BYTES);
+    if (write_full(w->fd, buf, sizeof(buf))) memcpy(w->head, e.digest, AUDIT_DIGEST_BYTES);
+}
+
+size_t audit_chain_open(const uint8_t* buf, size_t len, uint8_t prev[AUDIT_DIGEST_BYTES]) {
+    if (len < AUDIT_CHAIN_HEADER_BYTES || get_u32(buf) != AUDIT_CHAIN_MAGIC || get_u32(buf + 4) != 1) return (size_t)-1;
+    memcpy(prev, buf + 8, AUDIT_DIGEST_BYTES);
+    return (len - AUDIT_CHAIN_HEADER_BYTES) / AUDIT_CHAIN_ENTRY_BYTES;
+}
+
+void audit_chain_entry(const uint8_t* buf, size_t i, audit_chain_entry_t* entry) {
+    const uint8_t* e = buf + AUDIT_CHAIN_HEADER_BYTES + i * AUDIT_CHAIN_ENTRY_BYTES;
+    entry->offset = get_u64(e);
+    entry->length = get_u32(e + 8);
+    entry->records = get_u32(e + 12);
+    entry->first_ts_ms = (int64_t)get_u64(e + 16);
+    entry->last_ts_ms = (int64_t)get_u64(e + 24);
+    memcpy(entry->digest, e + 32, AUDIT_DIGEST_BYTES);
+}
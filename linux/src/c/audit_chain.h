@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Hash chain over logger batches (<log file>.chain). Each batch the logger
+// writes gets one entry whose digest covers the previous entry's digest, the
+// entry's own fields and the batch bytes:
+//
+//   digest_i = SHA-256(digest_{i-1} || offset, length, records, first/last ts || batch)
+//
+//   header   magic "TBMC", version, digest the chain continues from (40 bytes)
+//   entries  offset u64, length u32, records u32, first/last ts i64, digest[32]
+//
+// The chain carries over rotation: a new file's header holds the last digest
+// of the file before it. Editing, removing or reordering log bytes breaks the
+// digest of the batch that held them; rewriting the chain to match means
+// rewriting every later entry up to the current head.
+
+#define AUDIT_CHAIN_MAGIC 0x434D4254u // "TBMC"
+#define AUDIT_CHAIN_SUFFIX ".chain"
+#define AUDIT_CHAIN_HEADER_BYTES 40
+#define AUDIT_CHAIN_ENTRY_BYTES 64
+#define AUDIT_DIGEST_BYTES 32
+
+typedef struct {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t records;
+    int64_t first_ts_ms;
+    int64_t last_ts_ms;
+    uint8_t digest[AUDIT_DIGEST_BYTES];
+} audit_chain_entry_t;
+
+// Incremental SHA-256 of one entry (libcrypto)
+typedef struct {
+    void* md;
+} audit_chain_hash_t;
+
+bool audit_chain_hash_init(audit_chain_hash_t* h);
+void audit_chain_hash_free(audit_chain_hash_t* h);
+// Start an entry: hashes the previous digest and the entry's fields
+void audit_chain_hash_begin(audit_chain_hash_t* h, const uint8_t prev[AUDIT_DIGEST_BYTES], const audit_chain_entry_t* entry);
+void audit_chain_hash_update(audit_chain_hash_t* h, const uint8_t* data, size_t len);
+void audit_chain_hash_final(audit_chain_hash_t* h, uint8_t out[AUDIT_DIGEST_BYTES]);
+
+// Chain appender used by the logger. head survives close, so reopening for
+// the next file continues the chain.
+typedef struct {
+    int fd;
+    uint8_t head[AUDIT_DIGEST_BYTES];
+    audit_chain_hash_t hash;
+} audit_chain_writer_t;
+
+// Attach to a chain file. A new file starts from w->head; an existing one
+// (restart) is trimmed to whole entries and its last digest becomes the head.
+// fd < 0 on failure.
+void audit_chain_writer_open(audit_chain_writer_t* w, const char* path);
+void audit_chain_writer_close(audit_chain_writer_t* w);
+// Hash a batch that was written at `offset` and append its entry
+void audit_chain_append(audit_chain_writer_t* w, uint64_t offset, const uint8_t* data, size_t len,
+                        uint32_t records, int64_t first_ts_ms, int64_t last_ts_ms);
+
+// Reader over a mapped chain file; returns the entry count and the digest the
+// chain starts from, or (size_t)-1 if the header is invalid
+size_t audit_chain_open(const uint8_t* buf, size_t len, uint8_t prev[AUDIT_DIGEST_BYTES]);
+void audit_chain_entry(const uint8_t* buf, size_t i, audit_chain_entry_t* entry);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,247 @@
+#include "audit_compress.h"
+#include "audit_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define HEADER_BYTES 8
+#define INDEX_ENTRY_BYTES 32
+#define TRAILER_BYTES 16
+// zlib level 1 keeps the worker fast; audit text and varint records still
+// compress well at this level
+#define ZLIB_LEVEL 1
+#define ZSTD_LEVEL 3
+
+static void put_u16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_u32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i)); }
+static void put_u64(uint8_t* p, uint64_t v) { for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i)); }
+static uint16_t get_u16(const uint8_t* p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t get_u32(const uint8_t* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint64_t get_u64(const uint8_t* p) { uint64_t v = 0; for (int i = 7; i >= 0; i--) v = (v << 8) | p[i]; return v; }
+
+uint16_t audit_compress_codec(void) {
+#ifdef HAVE_ZSTD
+    return AUDIT_CODEC_ZSTD;
+#else
+    return AUDIT_CODEC_ZLIB;
+#endif
+}
+
+const char* audit_compress_codec_name(uint16_t codec) {
+    switch (codec) {
+    case AUDIT_CODEC_ZLIB: return "zlib";
+    case AUDIT_CODEC_ZSTD: return "zstd";
+    default: return "unknown";
+    }
+}
+
+static size_t codec_bound(uint16_t codec, size_t raw_len) {
+#ifdef HAVE_ZSTD
+    if (codec == AUDIT_CODEC_ZSTD) return ZSTD_compressBound(raw_len);
+#endif
+    (void)codec;
+    return compressBound((uLong)raw_len);
+}
+
+static size_t codec_compress(uint16_t codec, uint8_t* dst, size_t cap, const uint8_t* src, size_t len) {
+#ifdef HAVE_ZSTD
+    if (codec == AUDIT_CODEC_ZSTD) {
+        size_t n = ZSTD_compress(dst, cap, src, len, ZSTD_LEVEL);
+        return ZSTD_isError(n) ? 0 : n;
+    }
+#endif
+    (void)codec;
+    uLongf n = (uLongf)cap;
+    return compress2(dst, &n, src, (uLong)len, ZLIB_LEVEL) == Z_OK ? (size_t)n : 0;
+}
+
+static bool codec_decompress(uint16_t codec, uint8_t* dst, size_t raw_len, const uint8_t* src, size_t len) {
+#ifdef HAVE_ZSTD
+    if (codec == AUDIT_CODEC_ZSTD) return ZSTD_decompress(dst, raw_len, src, len) == raw_len;
+#endif
+    if (codec != AUDIT_CODEC_ZLIB) return false;
+    uLongf n = (uLongf)raw_len;
+    return uncompress(dst, &n, src, (uLong)len) == Z_OK && n == raw_len;
+}
+
+static bool write_full(int fd, const uint8_t* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) { if (errno == EINTR) continue; return false; }
+        buf += n; len -= (size_t)n;
+    }
+    return true;
+}
+
+// Frame boundary for a binary log: whole segments up to the target size.
+// A damaged tail becomes one frame with an open time range.
+static size_t cut_binary(const uint8_t* p, size_t len, int64_t* first, int64_t* last) {
+    size_t off = 0;
+    *first = INT64_MAX; *last = INT64_MIN;
+    while (off < len) {
+        audit_segment_t seg;
+        size_t size = audit_segment_open(&seg, p + off, len - off);
+        if (size == 0) {
+            if (off == 0) { *first = INT64_MIN; *last = INT64_MAX; return len; }
+            break;
+        }
+        if (off > 0 && off + size > AUDIT_ZFRAME_TARGET) break;
+        if (seg.header.record_count) {
+            if (seg.header.first_ts_ms < *first) *first = seg.header.first_ts_ms;
+            if (seg.header.last_ts_ms > *last) *last = seg.header.last_ts_ms;
+        }
+        off += size;
+    }
+    return off;
+}
+
+// Frame boundary for a text log: whole lines up to the target size
+static size_t cut_text(const uint8_t* p, size_t len, int64_t* first, int64_t* last) {
+    size_t off = 0;
+    *first = INT64_MAX; *last = INT64_MIN;
+    while (off < len) {
+        const uint8_t* nl = memchr(p + off, '\n', len - off);
+        size_t line_end = nl ? (size_t)(nl - p) + 1 : len;
+        if (off > 0 && line_end > AUDIT_ZFRAME_TARGET) break;
+        char* after = NULL;
+        long long ts = strtoll((const char*)p + off, &after, 10);
+        if (after != (const char*)p + off) {
+            if (ts < *first) *first = ts;
+            if (ts > *last) *last = ts;
+        }
+        off = line_end;
+    }
+    return off;
+}
+
+static bool compress_stream(const uint8_t* src, size_t len, int out_fd) {
+    uint16_t codec = audit_compress_codec();
+    bool binary = audit_is_binary(src, len);
+    uint8_t header[HEADER_BYTES];
+    put_u32(header, AUDIT_ZFILE_MAGIC);
+    put_u16(header + 4, 1);
+    put_u16(header + 6, codec);
+    if (!write_full(out_fd, header, HEADER_BYTES)) return false;
+
+    uint8_t* index = NULL;
+    size_t index_cap = 0;
+    uint32_t frames = 0;
+    uint8_t* buf = NULL;
+    size_t buf_cap = 0;
+    uint64_t out_off = HEADER_BYTES;
+    bool ok = true;
+
+    for (size_t off = 0; ok && off < len;) {
+        int64_t first, last;
+        size_t raw = binary ? cut_binary(src + off, len - off, &first, &last)
+                            : cut_text(src + off, len - off, &first, &last);
+        if (raw == 0) raw = len - off;
+        if (first > last) { first = INT64_MIN; last = INT64_MAX; } // no timestamps seen
+
+        size_t bound = codec_bound(codec, raw);
+        if (bound > buf_cap) {
+            uint8_t* grown = realloc(buf, bound);
+            if (!grown) { ok = false; break; }
+            buf = grown; buf_cap = bound;
+        }
+        size_t clen = codec_compress(codec, buf, buf_cap, src + off, raw);
+        if (clen == 0 || raw > UINT32_MAX) { ok = false; break; }
+        if ((size_t)(frames + 1) * INDEX_ENTRY_BYTES > index_cap) {
+            size_t cap = index_cap ? index_cap * 2 : 64 * INDEX_ENTRY_BYTES;
+            uint8_t* grown = realloc(index, cap);
+            if (!grown) { ok = false; break; }
+            index = grown; index_cap = cap;
+        }
+        uint8_t* e = index + (size_t)frames * INDEX_ENTRY_BYTES;
+        put_u64(e, out_off);
+        put_u32(e + 8, (uint32_t)clen);
+        put_u32(e + 12, (uint32_t)raw);
+        put_u64(e + 16, (uint64_t)first);
+        put_u64(e + 24, (uint64_t)last);
+        frames++;
+        ok = write_full(out_fd, buf, clen);
+        out_off += clen;
+        off += raw;
+    }
+
+    if (ok) {
+        uint8_t trailer[TRAILER_BYTES];
+        put_u64(trailer, out_off);
+        put_u32(trailer + 8, frames);
+        put_u32(trailer + 12, AUDIT_ZFILE_MAGIC);
+        ok = (frames == 0 || write_full(out_fd, index, (size_t)frames * INDEX_ENTRY_BYTES)) &&
+             write_full(out_fd, trailer, TRAILER_BYTES);
+    }
+    free(index);
+    free(buf);
+    return ok;
+}
+
+bool audit_compress_file(const char* src, const char* dst) {
+    int in_fd = open(src, O_RDONLY | O_CLOEXEC);
+    if (in_fd < 0) return false;
+    struct stat st;
+    if (fstat(in_fd, &st) != 0) { close(in_fd); return false; }
+    size_t len = (size_t)st.st_size;
+    const uint8_t* data = NULL;
+    if (len > 0) {
+        void* map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, in_fd, 0);
+        if (map == MAP_FAILED) { close(in_fd); return false; }
+        madvise(map, len, MADV_SEQUENTIAL);
+        data = map;
+    }
+    close(in_fd);
+
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", dst);
+    int out_fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    bool ok = out_fd >= 0 && compress_stream(data, len, out_fd) && fdatasync(out_fd) == 0;
+    if (out_fd >= 0 && close(out_fd) != 0) ok = false;
+    if (data) munmap((void*)data, len);
+    if (ok) ok = rename(tmp, dst) == 0;
+    if (!ok) unlink(tmp);
+    return ok;
+}
+
+bool audit_zfile_is_compressed(const uint8_t* buf, size_t len) {
+    return len >= HEADER_BYTES + TRAILER_BYTES && get_u32(buf) == AUDIT_ZFILE_MAGIC;
+}
+
+bool audit_zfile_open(audit_zfile_t* zf, const uint8_t* buf, size_t len) {
+    if (!audit_zfile_is_compressed(buf, len) || get_u16(buf + 4) != 1) return false;
+    const uint8_t* trailer = buf + len - TRAILER_BYTES;
+    if (get_u32(trailer + 12) != AUDIT_ZFILE_MAGIC) return false;  // incomplete file
+    uint64_t index_off = get_u64(trailer);
+    uint32_t frames = get_u32(trailer + 8);
+    if (index_off < HEADER_BYTES || index_off + (uint64_t)frames * INDEX_ENTRY_BYTES != len - TRAILER_BYTES) return false;
+    zf->base = buf;
+    zf->len = len;
+    zf->codec = get_u16(buf + 6);
+    zf->frame_count = frames;
+    zf->index = buf + index_off;
+    return true;
+}
+
+bool audit_zfile_frame(const audit_zfile_t* zf, uint32_t index, audit_zframe_t* frame) {
+    if (index >= zf->frame_count) return false;
+    const uint8_t* e = zf->index + (size_t)index * INDEX_ENTRY_BYTES;
+    frame->offset = get_u64(e);
+    frame->compressed_len = get_u32(e + 8);
+    frame->raw_len = get_u32(e + 12);
+    frame->first_ts_ms = (int64_t)get_u64(e + 16);
+    frame->last_ts_ms = (int64_t)get_u64(e + 24);
+    return frame->offset + frame->compressed_len <= (uint64_t)(zf->index - zf->base);
+}
+
+bool audit_zfile_decompress(const audit_zfile_t* zf, const audit_zframe_t* frame, uint8_t* out) {
+    return codec_decompress(zf->codec, out, frame->raw_len, zf->base + frame->offset, frame->compressed_len);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Seekable compressed container for rotated audit segments.
+//
+//   header   magic "TBMZ", version, codec (8 bytes)
+//   frames   independently compressed runs of the source file, cut on
+//            binary segment or text line boundaries
+//   index    frame_count x { offset, compressed len, raw len, first/last ts }
+//   trailer  index offset, frame count, magic (16 bytes)
+//
+// A time-range reader maps the file, reads the index from the trailer and
+// decompresses only the frames whose [first_ts, last_ts] overlaps the range.
+
+#define AUDIT_ZFILE_MAGIC 0x5A4D4254u // "TBMZ"
+#define AUDIT_ZFILE_SUFFIX ".z"
+// Uncompressed bytes per frame (a frame never splits a record)
+#define AUDIT_ZFRAME_TARGET (256 * 1024)
+
+enum {
+    AUDIT_CODEC_ZLIB = 1,
+    AUDIT_CODEC_ZSTD = 2
+};
+
+typedef struct {
+    uint64_t offset;
+    uint32_t compressed_len;
+    uint32_t raw_len;
+    int64_t first_ts_ms;
+    int64_t last_ts_ms;
+} audit_zframe_t;
+
+typedef struct {
+    const uint8_t* base;
+    size_t len;
+    uint16_t codec;
+    uint32_t frame_count;
+    const uint8_t* index;
+} audit_zfile_t;
+
+// Codec used for new files: zstd when built with HAVE_ZSTD, zlib otherwise
+uint16_t audit_compress_codec(void);
+const char* audit_compress_codec_name(uint16_t codec);
+
+// Compress src into dst (written as dst.tmp, synced, renamed into place)
+bool audit_compress_file(const char* src, const char* dst);
+
+// Reader over a mapped container
+bool audit_zfile_is_compressed(const uint8_t* buf, size_t len);
+bool audit_zfile_open(audit_zfile_t* zf, const uint8_t* buf, size_t len);
+bool audit_zfile_frame(const audit_zfile_t* zf, uint32_t index, audit_zframe_t* frame);
+// Decompress a frame into out (at least frame->raw_len bytes)
+bool audit_zfile_decompress(const audit_zfile_t* zf, const audit_zframe_t* frame, uint8_t* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,216 @@
+#include "audit_crypto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/crypto.h>
+
+#define HEADER_BYTES 40
+#define TAG_BYTES 16
+#define SALT_BYTES 16
+#define NONCE_PREFIX_BYTES 8
+#define KDF_PBKDF2_SHA256 1
+#define KDF_ITERATIONS 200000
+#define FINAL_FLAG 0x80000000u
+// Upper bound accepted from a header, so a corrupt file cannot demand huge buffers
+#define MAX_CHUNK (16 * 1024 * 1024)
+
+typedef struct {
+    uint8_t bytes[HEADER_BYTES];
+    uint32_t iterations;
+    uint32_t chunk_size;
+    const uint8_t* salt;
+    const uint8_t* nonce_prefix;
+} crypto_header_t;
+
+static void put_u32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i)); }
+static uint32_t get_u32(const uint8_t* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+
+static bool read_full(int fd, uint8_t* buf, size_t len, size_t* got) {
+    *got = 0;
+    while (*got < len) {
+        ssize_t n = read(fd, buf + *got, len - *got);
+        if (n < 0) { if (errno == EINTR) continue; return false; }
+        if (n == 0) break;
+        *got += (size_t)n;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const uint8_t* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) { if (errno == EINTR) continue; return false; }
+        buf += n; len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool derive_key(const char* passphrase, const crypto_header_t* h, uint8_t key[32]) {
+    return PKCS5_PBKDF2_HMAC(passphrase, (int)strlen(passphrase), h->salt, SALT_BYTES,
+                             (int)h->iterations, EVP_sha256(), 32, key) == 1;
+}
+
+static void chunk_nonce(const crypto_header_t* h, uint32_t index, uint8_t nonce[12]) {
+    memcpy(nonce, h->nonce_prefix, NONCE_PREFIX_BYTES);
+    nonce[8] = (uint8_t)(index >> 24); nonce[9] = (uint8_t)(index >> 16);
+    nonce[10] = (uint8_t)(index >> 8); nonce[11] = (uint8_t)index;
+}
+
+// Seal or open one chunk in place; the length word is authenticated with the header
+static bool gcm_chunk(EVP_CIPHER_CTX* ctx, bool encrypt, const uint8_t key[32], const crypto_header_t* h,
+                      uint32_t index, const uint8_t len_word[4], uint8_t* data, uint32_t len, uint8_t tag[TAG_BYTES]) {
+    uint8_t nonce[12];
+    chunk_nonce(h, index, nonce);
+    int out_len = 0;
+    if (EVP_CipherInit_ex(ctx, EVP_aes_256_gcm(), NULL, key, nonce, encrypt ? 1 : 0) != 1) return false;
+    if (EVP_CipherUpdate(ctx, NULL, &out_len, h->bytes, HEADER_BYTES) != 1) return false;
+    if (EVP_CipherUpdate(ctx, NULL, &out_len, len_word, 4) != 1) return false;
+    if (len > 0 && EVP_CipherUpdate(ctx, data, &out_len, data, (int)len) != 1) return false;
+    if (!encrypt && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, TAG_BYTES, tag) != 1) return false;
+    if (EVP_CipherFinal_ex(ctx, data + len, &out_len) != 1) return false;
+    if (encrypt && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, TAG_BYTES, tag) != 1) return false;
+    return true;
+}
+
+bool audit_crypto_encrypt_fd(int in_fd, int out_fd, uint64_t max_bytes, const char* passphrase) {
+    if (!passphrase || !passphrase[0]) return false;
+    crypto_header_t h;
+    memset(&h, 0, sizeof(h));
+    h.iterations = KDF_ITERATIONS;
+    h.chunk_size = AUDIT_CRYPTO_CHUNK;
+    put_u32(h.bytes + 0, AUDIT_CRYPTO_MAGIC);
+    h.bytes[4] = 1; h.bytes[5] = 0;                   // version
+    h.bytes[6] = KDF_PBKDF2_SHA256; h.bytes[7] = 0;
+    put_u32(h.bytes + 8, h.iterations);
+    put_u32(h.bytes + 12, h.chunk_size);
+    if (RAND_bytes(h.bytes + 16, SALT_BYTES + NONCE_PREFIX_BYTES) != 1) return false;
+    h.salt = h.bytes + 16;
+    h.nonce_prefix = h.bytes + 32;
+
+    uint8_t key[32];
+    uint8_t* buf = malloc(AUDIT_CRYPTO_CHUNK + TAG_BYTES);
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    bool ok = buf && ctx && derive_key(passphrase, &h, key) && write_full(out_fd, h.bytes, HEADER_BYTES);
+
+    uint64_t remaining = max_bytes ? max_bytes : UINT64_MAX;
+    // Read one chunk ahead so the last chunk can carry the final flag
+    size_t len = 0;
+    if (ok) {
+        size_t want = remaining < AUDIT_CRYPTO_CHUNK ? (size_t)remaining : AUDIT_CRYPTO_CHUNK;
+        ok = read_full(in_fd, buf, want, &len);
+        remaining -= len;
+    }
+    for (uint32_t index = 0; ok; index++) {
+        bool final = len < AUDIT_CRYPTO_CHUNK || remaining == 0;
+        uint8_t peek = 0;
+        size_t peeked = 0;
+        if (!final) {
+            // A full chunk is final only if nothing follows it
+            ok = read_full(in_fd, &peek, 1, &peeked);
+            if (!ok) break;
+            final = (peeked == 0);
+        }
+        uint8_t len_word[4];
+        put_u32(len_word, (uint32_t)len | (final ? FINAL_FLAG : 0));
+        ok = gcm_chunk(ctx, true, key, &h, index, len_word, buf, (uint32_t)len, buf + len) &&
+             write_full(out_fd, len_word, 4) && write_full(out_fd, buf, len + TAG_BYTES);
+        if (!ok || final) break;
+        buf[0] = peek;
+        remaining -= 1;
+        size_t want = remaining < AUDIT_CRYPTO_CHUNK - 1 ? (size_t)remaining : AUDIT_CRYPTO_CHUNK - 1;
+        size_t got = 0;
+        ok = read_full(in_fd, buf + 1, want, &got);
+        len = got + 1;
+        remaining -= got;
+    }
+
+    OPENSSL_cleanse(key, sizeof(key));
+    if (buf) { OPENSSL_cleanse(buf, AUDIT_CRYPTO_CHUNK + TAG_BYTES); free(buf); }
+    EVP_CIPHER_CTX_free(ctx);
+    return ok;
+}
+
+bool audit_crypto_decrypt_fd(int in_fd, int out_fd, const char* passphrase) {
+    if (!passphrase) return false;
+    crypto_header_t h;
+    size_t got = 0;
+    if (!read_full(in_fd, h.bytes, HEADER_BYTES, &got) || got != HEADER_BYTES) return false;
+    if (get_u32(h.bytes) != AUDIT_CRYPTO_MAGIC || h.bytes[4] != 1 || h.bytes[6] != KDF_PBKDF2_SHA256) return false;
+    h.iterations = get_u32(h.bytes + 8);
+    h.chunk_size = get_u32(h.bytes + 12);
+    h.salt = h.bytes + 16;
+    h.nonce_prefix = h.bytes + 32;
+    if (h.chunk_size == 0 || h.chunk_size > MAX_CHUNK || h.iterations == 0) return false;
+
+    uint8_t key[32];
+    uint8_t* buf = malloc((size_t)h.chunk_size + TAG_BYTES);
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    bool ok = buf && ctx && derive_key(passphrase, &h, key);
+    bool saw_final = false;
+    for (uint32_t index = 0; ok && !saw_final; index++) {
+        uint8_t len_word[4];
+        ok = read_full(in_fd, len_word, 4, &got) && got == 4;
+        if (!ok) break;
+        uint32_t word = get_u32(len_word);
+        uint32_t len = word & ~FINAL_FLAG;
+        saw_final = (word & FINAL_FLAG) != 0;
+        ok = len <= h.chunk_size && read_full(in_fd, buf, (size_t)len + TAG_BYTES, &got) && got == (size_t)len + TAG_BYTES;
+        // Plaintext is released only after its tag verified
+        ok = ok && gcm_chunk(ctx, false, key, &h, index, len_word, buf, len, buf + len) && write_full(out_fd, buf, len);
+    }
+    if (ok) {
+        // Nothing may follow the final chunk
+        uint8_t extra;
+        ok = read_full(in_fd, &extra, 1, &got) && got == 0;
+    }
+
+    OPENSSL_cleanse(key, sizeof(key));
+    if (buf) { OPENSSL_cleanse(buf, (size_t)h.chunk_size + TAG_BYTES); free(buf); }
+    EVP_CIPHER_CTX_free(ctx);
+    return ok && saw_final;
+}
+
+typedef bool (*crypto_stream_fn)(int in_fd, int out_fd, const char* passphrase);
+
+static bool encrypt_stream(int in_fd, int out_fd, const char* passphrase) {
+    return audit_crypto_encrypt_fd(in_fd, out_fd, 0, passphrase);
+}
+
+static bool transform_file(const char* src, const char* dst, const char* passphrase, crypto_stream_fn fn) {
+    int in_fd = open(src, O_RDONLY | O_CLOEXEC);
+    if (in_fd < 0) return false;
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", dst);
+    int out_fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out_fd < 0) { close(in_fd); return false; }
+    posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    bool ok = fn(in_fd, out_fd, passphrase) && fdatasync(out_fd) == 0;
+    close(in_fd);
+    if (close(out_fd) != 0) ok = false;
+    if (ok) ok = rename(tmp, dst) == 0;
+    if (!ok) unlink(tmp);
+    return ok;
+}
+
+bool audit_crypto_encrypt_file(const char* src, const char* dst, const char* passphrase) {
+    return transform_file(src, dst, passphrase, encrypt_stream);
+}
+
+bool audit_crypto_decrypt_file(const char* src, const char* dst, const char* passphrase) {
+    return transform_file(src, dst, passphrase, audit_crypto_decrypt_fd);
+}
+
+bool audit_crypto_is_encrypted(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    uint8_t magic[4];
+    size_t got = 0;
+    bool ok = read_full(fd, magic, 4, &got) && got == 4 && get_u32(magic) == AUDIT_CRYPTO_MAGIC;
+    close(fd);
+    return ok;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Streaming authenticated encryption for audit files (AES-256-GCM, libcrypto).
+//
+//   header  magic "TBME", version, kdf id, kdf iterations, chunk size,
+//           16-byte salt, 8-byte nonce prefix (40 bytes, little endian)
+//   chunks  u32 length (bit 31 marks the final chunk), ciphertext, 16-byte tag
+//
+// The key is PBKDF2-HMAC-SHA256(passphrase, salt). Chunk i uses the nonce
+// prefix || big-endian i, and the header plus the length word are
+// authenticated with every chunk. Reordered, truncated or spliced files fail
+// to decrypt. Memory use is one chunk in each direction, whatever the file size.
+
+#define AUDIT_CRYPTO_MAGIC 0x454D4254u // "TBME"
+#define AUDIT_CRYPTO_CHUNK (64 * 1024)
+#define AUDIT_CRYPTO_SUFFIX ".enc"
+
+// Encrypt at most max_bytes from in_fd (0 = until EOF) to out_fd
+bool audit_crypto_encrypt_fd(int in_fd, int out_fd, uint64_t max_bytes, const char* passphrase);
+bool audit_crypto_decrypt_fd(int in_fd, int out_fd, const char* passphrase);
+
+// File helpers: the output is written to dst.tmp (0600), synced and renamed into place
+bool audit_crypto_encrypt_file(const char* src, const char* dst, const char* passphrase);
+bool audit_crypto_decrypt_file(const char* src, const char* dst, const char* passphrase);
+
+// True if the file at path starts with the encrypted header
+bool audit_crypto_is_encrypted(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
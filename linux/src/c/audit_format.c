@@ -0,0 +1,264 @@
+#include "audit_format.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Headroom so a record never overruns the payload buffer (max encoded record)
+#define MAX_RECORD_BYTES 128
+
+static uint64_t zigzag64(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static int64_t unzigzag64(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+static uint8_t* put_varint(uint8_t* p, uint64_t v) {
+    while (v >= 0x80) { *p++ = (uint8_t)(v | 0x80); v >>= 7; }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static bool get_varint(const uint8_t** p, const uint8_t* end, uint64_t* out) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && *p < end; shift += 7) {
+        uint8_t b = *(*p)++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) { *out = v; return true; }
+    }
+    return false;
+}
+
+static void put_u32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i)); }
+static void put_u16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_i64(uint8_t* p, int64_t v) { for (int i = 0; i < 8; i++) p[i] = (uint8_t)((uint64_t)v >> (8 * i)); }
+static uint32_t get_u32(const uint8_t* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint16_t get_u16(const uint8_t* p) { return (uint16_t)(p[0] | p[1] << 8); }
+static int64_t get_i64(const uint8_t* p) { uint64_t v = 0; for (int i = 7; i >= 0; i--) v = (v << 8) | p[i]; return (int64_t)v; }
+
+#define HEADER_BYTES 48
+
+bool audit_encoder_init(audit_encoder_t* enc, size_t payload_cap) {
+    memset(enc, 0, sizeof(*enc));
+    enc->payload_cap = payload_cap > 4096 ? payload_cap : 4096;
+    enc->payload = malloc(enc->payload_cap);
+    return enc->payload != NULL;
+}
+
+void audit_encoder_free(audit_encoder_t* enc) {
+    free(enc->payload);
+    enc->payload = NULL;
+}
+
+void audit_encoder_reset(audit_encoder_t* enc) {
+    enc->payload_len = 0;
+    enc->dict_count = 0;
+    enc->record_count = 0;
+    enc->base_ts = enc->first_ts = enc->last_ts = enc->prev_ts = 0;
+    memset(enc->slot_used, 0, sizeof(enc->slot_used));
+}
+
+bool audit_encoder_full(const audit_encoder_t* enc) {
+    return enc->payload_len + MAX_RECORD_BYTES > enc->payload_cap || enc->dict_count >= AUDIT_MAX_DICT;
+}
+
+static void begin_record(audit_encoder_t* enc, int64_t ts_ms, uint32_t kind) {
+    if (enc->record_count == 0) {
+        enc->base_ts = enc->first_ts = enc->last_ts = enc->prev_ts = ts_ms;
+    }
+    // Producers on different threads may interleave slightly out of order,
+    // hence a signed (zigzag) delta
+    uint64_t tag = zigzag64(ts_ms - enc->prev_ts) << 3 | kind;
+    enc->payload_len = (size_t)(put_varint(enc->payload + enc->payload_len, tag) - enc->payload);
+    enc->prev_ts = ts_ms;
+    if (ts_ms < enc->first_ts) enc->first_ts = ts_ms;
+    if (ts_ms > enc->last_ts) enc->last_ts = ts_ms;
+    enc->record_count++;
+}
+
+static uint32_t dict_index(audit_encoder_t* enc, uint32_t pseudo_id) {
+    uint32_t mask = AUDIT_MAX_DICT * 2 - 1;
+    uint32_t h = (pseudo_id * 2654435761u) & mask;
+    while (enc->slot_used[h]) {
+        if (enc->slot_keys[h] == pseudo_id) return enc->slot_index[h];
+        h = (h + 1) & mask;
+    }
+    enc->slot_used[h] = true;
+    enc->slot_keys[h] = pseudo_id;
+    enc->slot_index[h] = (uint16_t)enc->dict_count;
+    enc->dict[enc->dict_count] = pseudo_id;
+    return enc->dict_count++;
+}
+
+void audit_encoder_add_input(audit_encoder_t* enc, int64_t ts_ms, uint32_t pseudo_id, int32_t dx, int32_t dy) {
+    uint32_t index = dict_index(enc, pseudo_id);
+    begin_record(enc, ts_ms, AUDIT_KIND_MOUSE_INPUT);
+    uint8_t* p = enc->payload + enc->payload_len;
+    p = put_varint(p, index);
+    p = put_varint(p, zigzag64(dx));
+    p = put_varint(p, zigzag64(dy));
+    enc->payload_len = (size_t)(p - enc->payload);
+}
+
+void audit_encoder_add_dropped(audit_encoder_t* enc, int64_t ts_ms, uint64_t count) {
+    begin_record(enc, ts_ms, AUDIT_KIND_DROPPED);
+    enc->payload_len = (size_t)(put_varint(enc->payload + enc->payload_len, count) - enc->payload);
+}
+
+void audit_encoder_add_window(audit_encoder_t* enc, int64_t ts_ms, uint32_t pseudo_id, const audit_window_t* w) {
+    uint32_t index = dict_index(enc, pseudo_id);
+    begin_record(enc, ts_ms, AUDIT_KIND_MOUSE_WINDOW);
+    uint8_t* p = enc->payload + enc->payload_len;
+    p = put_varint(p, index);
+    p = put_varint(p, w->window_ms);
+    p = put_varint(p, w->count);
+    p = put_varint(p, zigzag64(w->sum_dx));
+    p = put_varint(p, zigzag64(w->sum_dy));
+    p = put_varint(p, zigzag64(w->min_dx));
+    p = put_varint(p, zigzag64(w->max_dx));
+    p = put_varint(p, zigzag64(w->min_dy));
+    p = put_varint(p, zigzag64(w->max_dy));
+    p = put_varint(p, w->active_ms);
+    enc->payload_len = (size_t)(p - enc->payload);
+}
+
+size_t audit_encoder_segment_size(const audit_encoder_t* enc) {
+    return HEADER_BYTES + (size_t)enc->dict_count * 4 + enc->payload_len;
+}
+
+size_t audit_encoder_finish(audit_encoder_t* enc, uint8_t* out) {
+    size_t header_len = HEADER_BYTES + (size_t)enc->dict_count * 4;
+    put_u32(out + 0, AUDIT_SEGMENT_MAGIC);
+    put_u16(out + 4, AUDIT_SEGMENT_VERSION);
+    put_u16(out + 6, 0);
+    put_u32(out + 8, (uint32_t)header_len);
+    put_u32(out + 12, (uint32_t)enc->payload_len);
+    put_u32(out + 16, enc->record_count);
+    put_u32(out + 20, enc->dict_count);
+    put_i64(out + 24, enc->base_ts);
+    put_i64(out + 32, enc->first_ts);
+    put_i64(out + 40, enc->last_ts);
+    for (uint32_t i = 0; i < enc->dict_count; i++) put_u32(out + HEADER_BYTES + 4 * i, enc->dict[i]);
+    memcpy(out + header_len, enc->payload, enc->payload_len);
+    size_t total = header_len + enc->payload_len;
+    audit_encoder_reset(enc);
+    return total;
+}
+
+bool audit_is_binary(const uint8_t* buf, size_t len) {
+    return len >= HEADER_BYTES && get_u32(buf) == AUDIT_SEGMENT_MAGIC;
+}
+
+size_t audit_segment_open(audit_segment_t* seg, const uint8_t* buf, size_t len) {
+    if (!audit_is_binary(buf, len)) return 0;
+    audit_segment_header_t* h = &seg->header;
+    h->magic = get_u32(buf);
+    h->version = get_u16(buf + 4);
+    h->flags = get_u16(buf + 6);
+    h->header_len = get_u32(buf + 8);
+    h->payload_len = get_u32(buf + 12);
+    h->record_count = get_u32(buf + 16);
+    h->dict_count = get_u32(buf + 20);
+    h->base_ts_ms = get_i64(buf + 24);
+    h->first_ts_ms = get_i64(buf + 32);
+    h->last_ts_ms = get_i64(buf + 40);
+    if (h->version != AUDIT_SEGMENT_VERSION) return 0;
+    if (h->header_len < HEADER_BYTES + (uint64_t)h->dict_count * 4) return 0;
+    uint64_t total = (uint64_t)h->header_len + h->payload_len;
+    if (total > len) return 0;
+
+    seg->dict_bytes = buf + HEADER_BYTES;
+    seg->payload = buf + h->header_len;
+    seg->cursor = seg->payload;
+    seg->end = seg->payload + h->payload_len;
+    seg->ts = h->base_ts_ms;
+    return (size_t)total;
+}
+
+bool audit_segment_next(audit_segment_t* seg, audit_entry_t* entry) {
+    if (seg->cursor >= seg->end) return false;
+    uint64_t tag, a, b, c;
+    if (!get_varint(&seg->cursor, seg->end, &tag)) return false;
+    seg->ts += unzigzag64(tag >> 3);
+    memset(entry, 0, sizeof(*entry));
+    entry->kind = (uint32_t)(tag & 7);
+    entry->ts_ms = seg->ts;
+    switch (entry->kind) {
+    case AUDIT_KIND_MOUSE_INPUT:
+        if (!get_varint(&seg->cursor, seg->end, &a) || !get_varint(&seg->cursor, seg->end, &b) ||
+            !get_varint(&seg->cursor, seg->end, &c) || a >= seg->header.dict_count) return false;
+        entry->pseudo_id = get_u32(seg->dict_bytes + 4 * a);
+        entry->dx = (int32_t)unzigzag64(b);
+        entry->dy = (int32_t)unzigzag64(c);
+        return true;
+    case AUDIT_KIND_DROPPED:
+        if (!get_varint(&seg->cursor, seg->end, &a)) return false;
+        entry->count = a;
+        return true;
+    case AUDIT_KIND_MOUSE_WINDOW: {
+        uint64_t v[10];
+        for (int i = 0; i < 10; i++) if (!get_varint(&seg->cursor, seg->end, &v[i])) return false;
+        if (v[0] >= seg->header.dict_count) return false;
+        audit_window_t* w = &entry->window;
+        entry->pseudo_id = get_u32(seg->dict_bytes + 4 * v[0]);
+        w->window_ms = (uint32_t)v[1];
+        w->count = (uint32_t)v[2];
+        w->sum_dx = unzigzag64(v[3]);
+        w->sum_dy = unzigzag64(v[4]);
+        w->min_dx = (int32_t)unzigzag64(v[5]);
+        w->max_dx = (int32_t)unzigzag64(v[6]);
+        w->min_dy = (int32_t)unzigzag64(v[7]);
+        w->max_dy = (int32_t)unzigzag64(v[8]);
+        w->active_ms = (uint32_t)v[9];
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// Hand-rolled decimal formatting: bulk exports are dominated by snprintf otherwise
+static char* put_u64(char* p, uint64_t v) {
+    char tmp[20];
+    int n = 0;
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    while (n) *p++ = tmp[--n];
+    return p;
+}
+
+static char* put_i64_text(char* p, int64_t v) {
+    if (v < 0) { *p++ = '-'; return put_u64(p, (uint64_t)0 - (uint64_t)v); }
+    return put_u64(p, (uint64_t)v);
+}
+
+int audit_format_csv(const audit_entry_t* entry, char* out, size_t out_size) {
+    // Longest line (MOUSE_WINDOW) stays well under 256 bytes
+    if (out_size < 256) return 0;
+    char* p = put_i64_text(out, entry->ts_ms);
+    switch (entry->kind) {
+    case AUDIT_KIND_MOUSE_INPUT:
+        memcpy(p, ",MOUSE_INPUT,", 13); p += 13;
+        p = put_u64(p, entry->pseudo_id); *p++ = ',';
+        p = put_i64_text(p, entry->dx); *p++ = ',';
+        p = put_i64_text(p, entry->dy);
+        break;
+    case AUDIT_KIND_DROPPED:
+        memcpy(p, ",AUDIT_DROPPED,", 15); p += 15;
+        p = put_u64(p, entry->count);
+        break;
+    case AUDIT_KIND_MOUSE_WINDOW: {
+        const audit_window_t* w = &entry->window;
+        memcpy(p, ",MOUSE_WINDOW,", 14); p += 14;
+        p = put_u64(p, entry->pseudo_id); *p++ = ',';
+        p = put_u64(p, w->window_ms); *p++ = ',';
+        p = put_u64(p, w->count); *p++ = ',';
+        p = put_i64_text(p, w->sum_dx); *p++ = ',';
+        p = put_i64_text(p, w->sum_dy); *p++ = ',';
+        p = put_i64_text(p, w->min_dx); *p++ = ',';
+        p = put_i64_text(p, w->max_dx); *p++ = ',';
+        p = put_i64_text(p, w->min_dy); *p++ = ',';
+        p = put_i64_text(p, w->max_dy); *p++ = ',';
+        p = put_u64(p, w->active_ms);
+        break;
+    }
+    default:
+        return 0;
+    }
+    *p++ = '\n';
+    return (int)(p - out);
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Segmented binary audit log. Every logger batch becomes one self-contained
+// segment, so a reader can skip whole segments by their time range:
+//
+//   header   audit_segment_header_t (little endian)
+//   dict     dict_count x uint32 pseudonymous device ids
+//   payload  records, each starting with a varint tag
+//            tag = zigzag(ts - previous ts) << 3 | kind
+//            MOUSE_INPUT:  varint dict index, zigzag varint dx, dy
+//            DROPPED:      varint count
+//            MOUSE_WINDOW: varint dict index, window_ms, count, zigzag sums,
+//                          zigzag min/max dx, min/max dy, varint active_ms
+//
+// Typical input records take 4-5 bytes against ~40 for a text line.
+
+#define AUDIT_SEGMENT_MAGIC 0x414D4254u // "TBMA"
+#define AUDIT_SEGMENT_VERSION 1
+#define AUDIT_MAX_DICT 4096
+
+enum {
+    AUDIT_KIND_MOUSE_INPUT = 1,
+    AUDIT_KIND_DROPPED = 2,
+    AUDIT_KIND_MOUSE_WINDOW = 3  // per-device aggregate over window_ms
+};
+
+// Aggregate of one device's input over a window starting at the record's ts
+typedef struct {
+    uint32_t window_ms;
+    uint32_t count;
+    int64_t sum_dx, sum_dy;
+    int32_t min_dx, max_dx, min_dy, max_dy;
+    uint32_t active_ms;  // time spent moving (gaps above a threshold count as idle)
+} audit_window_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t header_len;   // header + dict (+ any extensions), payload starts here
+    uint32_t payload_len;
+    uint32_t record_count;
+    uint32_t dict_count;
+    int64_t base_ts_ms;    // timestamp the first delta is relative to
+    int64_t first_ts_ms;   // earliest record
+    int64_t last_ts_ms;    // latest record
+} audit_segment_header_t;
+
+// One decoded record
+typedef struct {
+    uint32_t kind;
+    int64_t ts_ms;
+    uint32_t pseudo_id;
+    int32_t dx, dy;
+    uint64_t count;
+    audit_window_t window;  // AUDIT_KIND_MOUSE_WINDOW
+} audit_entry_t;
+
+// Segment encoder (one per writer; buffers are reused between segments)
+typedef struct {
+    uint8_t* payload;
+    size_t payload_len, payload_cap;
+    uint32_t dict[AUDIT_MAX_DICT];
+    uint32_t dict_count;
+    uint32_t slot_keys[AUDIT_MAX_DICT * 2];   // open-addressed id -> dict index
+    uint16_t slot_index[AUDIT_MAX_DICT * 2];
+    bool slot_used[AUDIT_MAX_DICT * 2];
+    uint32_t record_count;
+    int64_t base_ts, first_ts, last_ts, prev_ts;
+} audit_encoder_t;
+
+bool audit_encoder_init(audit_encoder_t* enc, size_t payload_cap);
+void audit_encoder_free(audit_encoder_t* enc);
+void audit_encoder_reset(audit_encoder_t* enc);
+// True when the segment should be finished before adding more records
+bool audit_encoder_full(const audit_encoder_t* enc);
+void audit_encoder_add_input(audit_encoder_t* enc, int64_t ts_ms, uint32_t pseudo_id, int32_t dx, int32_t dy);
+void audit_encoder_add_dropped(audit_encoder_t* enc, int64_t ts_ms, uint64_t count);
+void audit_encoder_add_window(audit_encoder_t* enc, int64_t ts_ms, uint32_t pseudo_id, const audit_window_t* window);
+// Size of the finished segment in bytes
+size_t audit_encoder_segment_size(const audit_encoder_t* enc);
+// Serialize the segment into out (segment_size bytes) and reset the encoder
+size_t audit_encoder_finish(audit_encoder_t* enc, uint8_t* out);
+
+// Segment reader over a mapped buffer
+typedef struct {
+    audit_segment_header_t header;
+    const uint8_t* dict_bytes;  // header.dict_count little-endian uint32 ids
+    const uint8_t* payload;
+    const uint8_t* cursor;
+    const uint8_t* end;
+    int64_t ts;
+} audit_segment_t;
+
+// Parse the segment at buf; returns its total size, or 0 if invalid/truncated
+size_t audit_segment_open(audit_segment_t* seg, const uint8_t* buf, size_t len);
+// Decode the next record; false at end of segment or on corruption
+bool audit_segment_next(audit_segment_t* seg, audit_entry_t* entry);
+
+// True if the buffer starts with a binary segment
+bool audit_is_binary(const uint8_t* buf, size_t len);
+
+// Format an entry in the text log's CSV shape into out (at least 256 bytes);
+// returns the length written, 0 for unknown kinds
+int audit_format_csv(const audit_entry_t* entry, char* out, size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
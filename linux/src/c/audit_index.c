@@ -0,0 +1,104 @@
+#include "audit_index.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void put_u32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i)); }
+static void put_u64(uint8_t* p, uint64_t v) { for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i)); }
+static uint32_t get_u32(const uint8_t* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint64_t get_u64(const uint8_t* p) { uint64_t v = 0; for (int i = 7; i >= 0; i--) v = (v << 8) | p[i]; return v; }
+
+static bool write_full(int fd, const uint8_t* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) { if (errno == EINTR) continue; return false; }
+        buf += n; len -= (size_t)n;
+    }
+    return true;
+}
+
+// Two independent bit positions per id in a 256-bit filter
+static void bloom_bits(uint32_t id, uint32_t* a, uint32_t* b) {
+    *a = (id * 0x9E3779B1u) >> 24;
+    *b = ((id ^ 0x5bd1e995u) * 0x85EBCA77u) >> 24;
+}
+
+void audit_index_bloom_add(uint8_t bloom[32], uint32_t pseudo_id) {
+    uint32_t a, b;
+    bloom_bits(pseudo_id, &a, &b);
+    bloom[a >> 3] |= (uint8_t)(1u << (a & 7));
+    bloom[b >> 3] |= (uint8_t)(1u << (b & 7));
+}
+
+bool audit_index_bloom_maybe(const uint8_t bloom[32], uint32_t pseudo_id) {
+    uint32_t a, b;
+    bloom_bits(pseudo_id, &a, &b);
+    return (bloom[a >> 3] & (1u << (a & 7))) && (bloom[b >> 3] & (1u << (b & 7)));
+}
+
+void audit_index_writer_open(audit_index_writer_t* w, const char* path) {
+    memset(w, 0, sizeof(*w));
+    w->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (w->fd < 0) return;
+    struct stat st;
+    if (fstat(w->fd, &st) == 0 && st.st_size == 0) {
+        uint8_t header[AUDIT_INDEX_HEADER_BYTES];
+        put_u32(header, AUDIT_INDEX_MAGIC);
+        put_u32(header + 4, 1);
+        write_full(w->fd, header, sizeof(header));
+    }
+}
+
+void audit_index_writer_close(audit_index_writer_t* w) {
+    if (w->fd >= 0) close(w->fd);
+    w->fd = -1;
+    w->open = false;
+}
+
+void audit_index_note(audit_index_writer_t* w, uint64_t offset, int64_t ts_ms, uint32_t pseudo_id) {
+    if (w->fd < 0) return;
+    audit_index_entry_t* b = &w->block;
+    if (!w->open) {
+        memset(b, 0, sizeof(*b));
+        b->offset = offset;
+        b->first_ts_ms = b->last_ts_ms = ts_ms;
+        w->open = true;
+    }
+    if (ts_ms < b->first_ts_ms) b->first_ts_ms = ts_ms;
+    if (ts_ms > b->last_ts_ms) b->last_ts_ms = ts_ms;
+    audit_index_bloom_add(b->bloom, pseudo_id);
+    b->records++;
+}
+
+void audit_index_flushed(audit_index_writer_t* w, uint64_t end_offset, bool force) {
+    if (w->fd < 0 || !w->open || end_offset <= w->block.offset) return;
+    audit_index_entry_t* b = &w->block;
+    uint64_t length = end_offset - b->offset;
+    if (!force && length < AUDIT_INDEX_BLOCK_BYTES && b->last_ts_ms - b->first_ts_ms < AUDIT_INDEX_BLOCK_MS) return;
+    uint8_t e[AUDIT_INDEX_ENTRY_BYTES];
+    put_u64(e, b->offset);
+    put_u32(e + 8, length > UINT32_MAX ? UINT32_MAX : (uint32_t)length);
+    put_u32(e + 12, b->records);
+    put_u64(e + 16, (uint64_t)b->first_ts_ms);
+    put_u64(e + 24, (uint64_t)b->last_ts_ms);
+    memcpy(e + 32, b->bloom, sizeof(b->bloom));
+    write_full(w->fd, e, sizeof(e));
+    w->open = false;
+}
+
+size_t audit_index_open(const uint8_t* buf, size_t len) {
+    if (len < AUDIT_INDEX_HEADER_BYTES || get_u32(buf) != AUDIT_INDEX_MAGIC || get_u32(buf + 4) != 1) return 0;
+    return (len - AUDIT_INDEX_HEADER_BYTES) / AUDIT_INDEX_ENTRY_BYTES;
+}
+
+void audit_index_entry(const uint8_t* buf, size_t i, audit_index_entry_t* entry) {
+    const uint8_t* e = buf + AUDIT_INDEX_HEADER_BYTES + i * AUDIT_INDEX_ENTRY_BYTES;
+    entry->offset = get_u64(e);
+    entry->length = get_u32(e + 8);
+    entry->records = get_u32(e + 12);
+    entry->first_ts_ms = (int64_t)get_u64(e + 16);
+    entry->last_ts_ms = (int64_t)get_u64(e + 24);
+    memcpy(entry->bloom, e + 32, sizeof(entry->bloom));
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sparse sidecar index (<log file>.idx) written by the logger next to each
+// audit file. Every entry covers one block of the log (at least
+// AUDIT_INDEX_BLOCK_BYTES or AUDIT_INDEX_BLOCK_MS, whichever comes first, cut
+// on batch boundaries) and records its byte range, time range and a bloom
+// filter of the pseudonymous device ids in it. Range and device queries read
+// only the blocks that can match.
+//
+//   header  magic "TBMI", version (8 bytes)
+//   entries offset u64, length u32, records u32, first/last ts i64, bloom[32]
+
+#define AUDIT_INDEX_MAGIC 0x494D4254u // "TBMI"
+#define AUDIT_INDEX_SUFFIX ".idx"
+#define AUDIT_INDEX_BLOCK_BYTES (64 * 1024)
+#define AUDIT_INDEX_BLOCK_MS 10000
+#define AUDIT_INDEX_HEADER_BYTES 8
+#define AUDIT_INDEX_ENTRY_BYTES 64
+// Bloom key for AUDIT_DROPPED records, so device queries still see gaps
+#define AUDIT_INDEX_ID_DROPPED 0xFFFFFFFFu
+
+typedef struct {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t records;
+    int64_t first_ts_ms;
+    int64_t last_ts_ms;
+    uint8_t bloom[32];
+} audit_index_entry_t;
+
+// Block accumulator used by the logger
+typedef struct {
+    int fd;
+    audit_index_entry_t block;
+    bool open;
+} audit_index_writer_t;
+
+// Attach to an index file (created with a header if new); fd < 0 on failure
+void audit_index_writer_open(audit_index_writer_t* w, const char* path);
+void audit_index_writer_close(audit_index_writer_t* w);
+// Account one record of the block that starts at file offset `offset`
+void audit_index_note(audit_index_writer_t* w, uint64_t offset, int64_t ts_ms, uint32_t pseudo_id);
+// Bytes of the current block reached the file; the block ends at `end_offset`.
+// Writes the entry once the block is large or old enough, or when forced.
+void audit_index_flushed(audit_index_writer_t* w, uint64_t end_offset, bool force);
+
+void audit_index_bloom_add(uint8_t bloom[32], uint32_t pseudo_id);
+bool audit_index_bloom_maybe(const uint8_t bloom[32], uint32_t pseudo_id);
+
+// Reader over a mapped index; returns the entry count (0 if invalid)
+size_t audit_index_open(const uint8_t* buf, size_t len);
+void audit_index_entry(const uint8_t* buf, size_t i, audit_index_entry_t* entry);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,369 @@
+// SCHED_IDLE
+#define _GNU_SOURCE
+#include "audit_store.h"
+#include "audit_crypto.h"
+#include "audit_compress.h"
+#include "audit_index.h"
+#include "audit_chain.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <openssl/crypto.h>
+
+// Longest the worker sleeps when nothing is due (picks up clock jumps)
+#define MAX_SLEEP_SEC 3600
+
+static char s_dir[512] = "";
+static char s_archive_dir[512] = "";
+
+// Index sorted by closed_at, oldest first; guarded by s_lock
+static audit_segment_file_t* s_index = NULL;
+static size_t s_count = 0, s_cap = 0;
+static int s_max_days = 0;
+static char s_passphrase[256];
+static bool s_encrypt = false;
+static bool s_compress = true;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t s_thread;
+static atomic_bool s_running = false;
+
+static bool has_suffix(const char* name, const char* suffix) {
+    size_t n = strlen(name), k = strlen(suffix);
+    return n >= k && strcmp(name + n - k, suffix) == 0;
+}
+
+static bool is_sidecar_name(const char* name) {
+    return has_suffix(name, AUDIT_INDEX_SUFFIX) || has_suffix(name, AUDIT_CHAIN_SUFFIX) ||
+           has_suffix(name, AUDIT_INDEX_SUFFIX AUDIT_CRYPTO_SUFFIX) || has_suffix(name, AUDIT_CHAIN_SUFFIX AUDIT_CRYPTO_SUFFIX);
+}
+
+static bool is_segment_name(const char* name) {
+    return strncmp(name, "audit-", 6) == 0 && strlen(name) < sizeof(((audit_segment_file_t*)0)->name) &&
+           !has_suffix(name, ".tmp") && !is_sidecar_name(name);
+}
+
+// Sidecars of a segment (index, hash chain) are named after the uncompressed,
+// unencrypted file
+static void sidecar_name(const char* name, const char* suffix, char* out, size_t out_size) {
+    char base[64];
+    snprintf(base, sizeof(base), "%s", name);
+    size_t n = strlen(base);
+    if (has_suffix(base, AUDIT_CRYPTO_SUFFIX)) base[n -= strlen(AUDIT_CRYPTO_SUFFIX)] = '\0';
+    if (has_suffix(base, AUDIT_ZFILE_SUFFIX)) base[n -= strlen(AUDIT_ZFILE_SUFFIX)] = '\0';
+    snprintf(out, out_size, "%s%s", base, suffix);
+}
+
+static uint32_t flags_for_name(const char* name) {
+    if (has_suffix(name, AUDIT_CRYPTO_SUFFIX)) return AUDIT_SEGMENT_ENCRYPTED;
+    if (has_suffix(name, AUDIT_ZFILE_SUFFIX)) return AUDIT_SEGMENT_COMPRESSED;
+    return 0;
+}
+
+static bool index_reserve(size_t n) {
+    if (n <= s_cap) return true;
+    size_t cap = s_cap ? s_cap * 2 : 64;
+    while (cap < n) cap *= 2;
+    audit_segment_file_t* grown = realloc(s_index, cap * sizeof(*grown));
+    if (!grown) return false;
+    s_index = grown;
+    s_cap = cap;
+    return true;
+}
+
+// Rotations arrive in time order, so this is an append in practice
+static void index_insert(const audit_segment_file_t* entry) {
+    if (!index_reserve(s_count + 1)) return;
+    size_t i = s_count;
+    while (i > 0 && s_index[i - 1].closed_at > entry->closed_at) {
+        s_index[i] = s_index[i - 1];
+        i--;
+    }
+    s_index[i] = *entry;
+    s_count++;
+}
+
+static int compare_closed_at(const void* a, const void* b) {
+    int64_t x = ((const audit_segment_file_t*)a)->closed_at;
+    int64_t y = ((const audit_segment_file_t*)b)->closed_at;
+    return (x > y) - (x < y);
+}
+
+// One-time directory scan to seed the index
+static void scan_dir(void) {
+    DIR* dir = opendir(s_dir);
+    if (!dir) return;
+    struct dirent* de;
+    while ((de = readdir(dir)) != NULL) {
+        // Output of a transform interrupted by a crash; the source is still there
+        if (strncmp(de->d_name, "audit-", 6) == 0 && has_suffix(de->d_name, ".tmp")) {
+            unlinkat(dirfd(dir), de->d_name, 0);
+            continue;
+        }
+        if (!is_segment_name(de->d_name)) continue;
+        struct stat st;
+        if (fstatat(dirfd(dir), de->d_name, &st, 0) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (!index_reserve(s_count + 1)) break;
+        audit_segment_file_t* e = &s_index[s_count++];
+        snprintf(e->name, sizeof(e->name), "%s", de->d_name);
+        e->closed_at = (int64_t)st.st_mtime;
+        e->bytes = (uint64_t)st.st_size;
+        e->flags = flags_for_name(e->name);
+    }
+    closedir(dir);
+    if (s_count > 1) qsort(s_index, s_count, sizeof(*s_index), compare_closed_at);
+}
+
+static bool expire_path(const char* name) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", s_dir, name);
+    if (s_archive_dir[0]) {
+        char dest[1024];
+        snprintf(dest, sizeof(dest), "%s/%s", s_archive_dir, name);
+        return rename(path, dest) == 0 || errno == ENOENT;
+    }
+    return unlink(path) == 0 || errno == ENOENT;
+}
+
+static const char* const s_sidecar_suffixes[] = {
+    AUDIT_INDEX_SUFFIX, AUDIT_CHAIN_SUFFIX, AUDIT_INDEX_SUFFIX AUDIT_CRYPTO_SUFFIX, AUDIT_CHAIN_SUFFIX AUDIT_CRYPTO_SUFFIX
+};
+
+static void expire_file(const char* name) {
+    if (!expire_path(name)) {
+        printf("⚠️  Could not %s %s: %s\n", s_archive_dir[0] ? "archive" : "delete", name, strerror(errno));
+        return;
+    }
+    for (size_t i = 0; i < sizeof(s_sidecar_suffixes) / sizeof(s_sidecar_suffixes[0]); i++) {
+        char sidecar[96];
+        sidecar_name(name, s_sidecar_suffixes[i], sidecar, sizeof(sidecar));
+        expire_path(sidecar);
+    }
+    if (s_archive_dir[0]) printf("📦 Archived audit segment %s\n", name);
+    else printf("🗑️  Expired audit segment %s\n", name);
+}
+
+// Remove everything past retention; called with s_lock held, drops it for I/O
+static void sweep_locked(void) {
+    if (s_max_days <= 0) return;
+    int64_t cutoff = (int64_t)time(NULL) - (int64_t)s_max_days * 86400;
+    while (s_count > 0 && s_index[0].closed_at <= cutoff) {
+        char name[sizeof(s_index[0].name)];
+        memcpy(name, s_index[0].name, sizeof(name));
+        memmove(s_index, s_index + 1, (s_count - 1) * sizeof(*s_index));
+        s_count--;
+        pthread_mutex_unlock(&s_lock);
+        expire_file(name);
+        pthread_mutex_lock(&s_lock);
+    }
+}
+
+// Per-segment pipeline, applied in order: compress, then encrypt
+typedef enum { STEP_NONE, STEP_COMPRESS, STEP_ENCRYPT } segment_step_t;
+
+static segment_step_t next_step(const audit_segment_file_t* e) {
+    // Encrypted files are opaque; nothing further applies
+    if (e->flags & (AUDIT_SEGMENT_ENCRYPTED | AUDIT_SEGMENT_ENCRYPT_FAILED)) return STEP_NONE;
+    if (s_compress && !(e->flags & (AUDIT_SEGMENT_COMPRESSED | AUDIT_SEGMENT_COMPRESS_FAILED))) return STEP_COMPRESS;
+    if (s_encrypt) return STEP_ENCRYPT;
+    return STEP_NONE;
+}
+
+// The index and chain of a segment give away its time range, record counts,
+// batch sizes and bloom filters of device ids, so they are encrypted along
+// with it. A sidecar that cannot be encrypted stays in clear and is reported.
+static void encrypt_sidecars(const char* name, const char* passphrase) {
+    static const char* const suffixes[] = { AUDIT_INDEX_SUFFIX, AUDIT_CHAIN_SUFFIX };
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        char sidecar[96], src[1024], dst[1024];
+        sidecar_name(name, suffixes[i], sidecar, sizeof(sidecar));
+        snprintf(src, sizeof(src), "%s/%s", s_dir, sidecar);
+        snprintf(dst, sizeof(dst), "%s/%s" AUDIT_CRYPTO_SUFFIX, s_dir, sidecar);
+        if (access(src, F_OK) != 0) continue;
+        if (audit_crypto_encrypt_file(src, dst, passphrase)) unlink(src);
+        else printf("⚠️  Could not encrypt audit sidecar %s\n", sidecar);
+    }
+}
+
+// Advance the oldest segment with pending work by one step; called with
+// s_lock held, drops it for I/O. Returns false when there is nothing to do.
+static bool process_one_locked(void) {
+    size_t i = 0;
+    while (i < s_count && next_step(&s_index[i]) == STEP_NONE) i++;
+    if (i == s_count) return false;
+    audit_segment_file_t entry = s_index[i];
+    segment_step_t step = next_step(&entry);
+    char passphrase[sizeof(s_passphrase)];
+    if (step == STEP_ENCRYPT) memcpy(passphrase, s_passphrase, sizeof(passphrase));
+    pthread_mutex_unlock(&s_lock);
+
+    const char* suffix = step == STEP_COMPRESS ? AUDIT_ZFILE_SUFFIX : AUDIT_CRYPTO_SUFFIX;
+    char src[1024], dst[1024], new_name[sizeof(entry.name)];
+    bool fits = snprintf(new_name, sizeof(new_name), "%s%s", entry.name, suffix) < (int)sizeof(new_name);
+    snprintf(src, sizeof(src), "%s/%s", s_dir, entry.name);
+    snprintf(dst, sizeof(dst), "%s/%s", s_dir, new_name);
+    bool ok = fits;
+    if (ok && step == STEP_COMPRESS) {
+        ok = audit_compress_file(src, dst);
+    } else if (ok) {
+        ok = audit_crypto_encrypt_file(src, dst, passphrase);
+        if (ok) encrypt_sidecars(entry.name, passphrase);
+    }
+    if (step == STEP_ENCRYPT) OPENSSL_cleanse(passphrase, sizeof(passphrase));
+    struct stat st;
+    uint64_t new_bytes = entry.bytes;
+    if (ok) {
+        unlink(src);
+        if (stat(dst, &st) == 0) new_bytes = (uint64_t)st.st_size;
+        if (step == STEP_COMPRESS) {
+            printf("🗜️  Compressed audit segment %s (%llu -> %llu bytes, %s)\n", new_name,
+                   (unsigned long long)entry.bytes, (unsigned long long)new_bytes,
+                   audit_compress_codec_name(audit_compress_codec()));
+        } else {
+            printf("🔒 Encrypted audit segment %s\n", new_name);
+        }
+    } else {
+        printf("⚠️  Could not %s audit segment %s\n", step == STEP_COMPRESS ? "compress" : "encrypt", entry.name);
+    }
+
+    pthread_mutex_lock(&s_lock);
+    // The entry may have moved while unlocked; find it by name
+    for (size_t j = 0; j < s_count; j++) {
+        if (strcmp(s_index[j].name, entry.name) != 0) continue;
+        if (ok) {
+            memcpy(s_index[j].name, new_name, sizeof(new_name));
+            s_index[j].bytes = new_bytes;
+            s_index[j].flags |= step == STEP_COMPRESS ? AUDIT_SEGMENT_COMPRESSED : AUDIT_SEGMENT_ENCRYPTED;
+        } else {
+            // Failed steps are not retried in a loop; the segment stays as is
+            s_index[j].flags |= step == STEP_COMPRESS ? AUDIT_SEGMENT_COMPRESS_FAILED : AUDIT_SEGMENT_ENCRYPT_FAILED;
+        }
+        break;
+    }
+    return true;
+}
+
+static int64_t next_wait_sec_locked(void) {
+    if (s_max_days <= 0 || s_count == 0) return MAX_SLEEP_SEC;
+    int64_t due = s_index[0].closed_at + (int64_t)s_max_days * 86400 - (int64_t)time(NULL);
+    if (due < 1) due = 1;
+    return due < MAX_SLEEP_SEC ? due : MAX_SLEEP_SEC;
+}
+
+static void* worker_thread(void* arg) {
+    (void)arg;
+    // Housekeeping must never compete with input handling: idle scheduling
+    // class where allowed, otherwise the lowest-ish nice level
+    struct sched_param param = { 0 };
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0) {
+        setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 10);
+    }
+    pthread_mutex_lock(&s_lock);
+    while (atomic_load(&s_running)) {
+        while (atomic_load(&s_running) && process_one_locked()) {}
+        sweep_locked();
+        struct timespec deadline; clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += next_wait_sec_locked();
+        pthread_cond_timedwait(&s_cond, &s_lock, &deadline);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return NULL;
+}
+
+bool audit_store_start(const char* log_dir, const char* archive_dir) {
+    if (!log_dir || atomic_load(&s_running)) return false;
+    snprintf(s_dir, sizeof(s_dir), "%s", log_dir);
+    s_archive_dir[0] = '\0';
+    if (archive_dir && archive_dir[0]) {
+        snprintf(s_archive_dir, sizeof(s_archive_dir), "%s", archive_dir);
+        mkdir(s_archive_dir, 0700);
+    }
+    pthread_mutex_lock(&s_lock);
+    s_count = 0;
+    scan_dir();
+    pthread_mutex_unlock(&s_lock);
+
+    atomic_store(&s_running, true);
+    if (pthread_create(&s_thread, NULL, worker_thread, NULL) != 0) {
+        atomic_store(&s_running, false);
+        return false;
+    }
+    return true;
+}
+
+void audit_store_stop(void) {
+    if (atomic_exchange(&s_running, false)) {
+        pthread_mutex_lock(&s_lock);
+        pthread_cond_signal(&s_cond);
+        pthread_mutex_unlock(&s_lock);
+        pthread_join(s_thread, NULL);
+    }
+    pthread_mutex_lock(&s_lock);
+    free(s_index); s_index = NULL;
+    s_count = s_cap = 0;
+    pthread_mutex_unlock(&s_lock);
+    audit_store_set_encryption(NULL);
+}
+
+void audit_store_add(const char* name, int64_t closed_at, uint64_t bytes) {
+    if (!name || !is_segment_name(name)) return;
+    audit_segment_file_t entry;
+    snprintf(entry.name, sizeof(entry.name), "%s", name);
+    entry.closed_at = closed_at;
+    entry.bytes = bytes;
+    entry.flags = flags_for_name(name);
+    pthread_mutex_lock(&s_lock);
+    index_insert(&entry);
+    pthread_cond_signal(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+}
+
+void audit_store_set_encryption(const char* passphrase) {
+    static bool locked = false;
+    pthread_mutex_lock(&s_lock);
+    if (!locked) locked = mlock(s_passphrase, sizeof(s_passphrase)) == 0;
+    OPENSSL_cleanse(s_passphrase, sizeof(s_passphrase));
+    s_encrypt = passphrase && passphrase[0] && strlen(passphrase) < sizeof(s_passphrase);
+    if (s_encrypt) {
+        memcpy(s_passphrase, passphrase, strlen(passphrase) + 1);
+        pthread_cond_signal(&s_cond);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+void audit_store_set_compression(bool enabled) {
+    pthread_mutex_lock(&s_lock);
+    s_compress = enabled;
+    pthread_cond_signal(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+}
+
+void audit_store_set_retention(int max_days) {
+    pthread_mutex_lock(&s_lock);
+    if (s_max_days != max_days) {
+        s_max_days = max_days;
+        pthread_cond_signal(&s_cond);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+size_t audit_store_list(audit_segment_file_t* out, size_t max) {
+    pthread_mutex_lock(&s_lock);
+    size_t n = s_count < max ? s_count : max;
+    if (out && n) memcpy(out, s_index, n * sizeof(*out));
+    size_t total = s_count;
+    pthread_mutex_unlock(&s_lock);
+    return total;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rotated audit segments and their background maintenance.
+//
+// The store keeps an in-memory index of closed segment files. The directory
+// is scanned once at start, and the logger adds each segment as it rotates it.
+// A low-priority worker thread processes that index. It compresses new
+// segments into seekable containers, encrypts them when a passphrase is set,
+// and deletes or archives expired segments. Neither the input path nor the
+// logger ever walks the directory.
+//
+// An encrypted segment's .idx and .chain sidecars are encrypted with it
+// (NAME.idx.enc, NAME.chain.enc), because they reveal time ranges, record
+// counts and device-id bloom filters. To query or verify such a segment,
+// decrypt the segment and its sidecars with audit_tool first.
+
+enum {
+    AUDIT_SEGMENT_ENCRYPTED = 1u << 0,        // name ends in AUDIT_CRYPTO_SUFFIX
+    AUDIT_SEGMENT_ENCRYPT_FAILED = 1u << 1,   // left as plaintext, not retried
+    AUDIT_SEGMENT_COMPRESSED = 1u << 2,       // name ends in AUDIT_ZFILE_SUFFIX
+    AUDIT_SEGMENT_COMPRESS_FAILED = 1u << 3   // left uncompressed, not retried
+};
+
+typedef struct {
+    char name[64];       // file name inside the log directory
+    int64_t closed_at;   // wall-clock seconds when the segment was rotated
+    uint64_t bytes;
+    uint32_t flags;      // AUDIT_SEGMENT_*
+} audit_segment_file_t;
+
+// Start the worker for log_dir. archive_dir (optional, same filesystem)
+// receives expired segments instead of deleting them.
+bool audit_store_start(const char* log_dir, const char* archive_dir);
+void audit_store_stop(void);
+
+// Called by the logger after it renamed the active file to name
+void audit_store_add(const char* name, int64_t closed_at, uint64_t bytes);
+
+// Encrypt rotated segments (and plaintext ones found at start) with this
+// passphrase; NULL or "" turns encryption off. The copy is kept in locked
+// memory and wiped on stop.
+void audit_store_set_encryption(const char* passphrase);
+
+// Compress rotated segments (see audit_compress.h); on by default
+void audit_store_set_compression(bool enabled);
+
+// Segments older than max_days are expired; <= 0 keeps everything
+void audit_store_set_retention(int max_days);
+
+// Copy up to max entries of the index, oldest first; returns the total count
+size_t audit_store_list(audit_segment_file_t* out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,575 @@
+// strptime
+#define _GNU_SOURCE
+#include "audit_format.h"
+#include "audit_crypto.h"
+#include "audit_compress.h"
+#include "audit_index.h"
+#include "audit_chain.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Offline audit log tooling. Files are mapped read-only and streamed, so
+// exporting a multi-gigabyte log needs no more memory than one output buffer.
+
+typedef struct {
+    int64_t from_ms;
+    int64_t to_ms;
+    bool by_device;
+    uint32_t device;
+    uint64_t records;
+    uint64_t segments_skipped;
+    uint64_t frames_skipped;
+    uint64_t blocks_skipped;
+} export_ctx_t;
+
+// Byte range of the uncompressed log that may hold matching records
+typedef struct {
+    uint64_t lo, hi;
+} byte_range_t;
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s query [--from TIME] [--to TIME] [--device ID] FILE...\n"
+            "  Streams matching records from audit logs (binary, text or\n"
+            "  compressed .z) to stdout in CSV form. The sidecar .idx of each\n"
+            "  file is used to read only blocks that can match. TIME is epoch\n"
+            "  ms, \"YYYY-MM-DD HH:MM[:SS]\" or \"HH:MM[:SS]\" (today), local\n"
+            "  time, inclusive. ID is the pseudonymous device id from the log.\n"
+            "       %s export [--from TIME] [--to TIME] FILE...\n"
+            "  Same as query without a device filter.\n"
+            "       %s verify [--from TIME] [--to TIME] FILE...\n"
+            "  Checks each file against its .chain sidecar (every batch, or the\n"
+            "  batches in the time range) and prints the chain head. Give\n"
+            "  rotated files oldest first to also check they link up.\n"
+            "       %s decrypt [--key-file PATH] IN OUT\n"
+            "  Decrypts an encrypted segment, sidecar (.idx.enc, .chain.enc)\n"
+            "  or export (passphrase prompted unless a key file is given).\n", argv0, argv0, argv0, argv0);
+}
+
+static bool parse_time(const char* text, int64_t* out_ms) {
+    char* end = NULL;
+    long long ms = strtoll(text, &end, 10);
+    if (end != text && *end == '\0') { *out_ms = ms; return true; }
+
+    static const char* formats[] = { "%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d %H:%M",
+                                     "%Y-%m-%dT%H:%M", "%Y-%m-%d", "%H:%M:%S", "%H:%M" };
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        struct tm tm;
+        time_t now = time(NULL);
+        localtime_r(&now, &tm); // date defaults to today for time-only formats
+        tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+        const char* rest = strptime(text, formats[i], &tm);
+        if (!rest || *rest != '\0') continue;
+        tm.tm_isdst = -1;
+        *out_ms = (int64_t)mktime(&tm) * 1000;
+        return true;
+    }
+    return false;
+}
+
+// Map a whole file read-only; an empty file maps to (NULL, 0) and succeeds
+static bool map_file(const char* path, const uint8_t** data, size_t* len) {
+    *data = NULL; *len = 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { fprintf(stderr, "❌ %s: %s\n", path, strerror(errno)); return false; }
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return false; }
+    if (st.st_size == 0) { close(fd); return true; }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) { fprintf(stderr, "❌ %s: mmap failed: %s\n", path, strerror(errno)); return false; }
+    *data = map;
+    *len = (size_t)st.st_size;
+    return true;
+}
+
+static bool in_range(const export_ctx_t* ctx, int64_t first, int64_t last) {
+    return last >= ctx->from_ms && first <= ctx->to_ms;
+}
+
+// Dropped-record markers are kept under a device filter: they mark gaps
+static bool keep_entry(const export_ctx_t* ctx, const audit_entry_t* entry) {
+    if (entry->ts_ms < ctx->from_ms || entry->ts_ms > ctx->to_ms) return false;
+    return !ctx->by_device || entry->kind == AUDIT_KIND_DROPPED || entry->pseudo_id == ctx->device;
+}
+
+static void export_binary(export_ctx_t* ctx, const char* path, const uint8_t* data, size_t len) {
+    char line[256];
+    size_t off = 0;
+    while (off < len) {
+        audit_segment_t seg;
+        size_t size = audit_segment_open(&seg, data + off, len - off);
+        if (size == 0) {
+            fprintf(stderr, "⚠️  %s: truncated or corrupt segment\n", path);
+            return;
+        }
+        off += size;
+        // Whole segments outside the range are skipped from the header alone
+        if (!in_range(ctx, seg.header.first_ts_ms, seg.header.last_ts_ms)) {
+            ctx->segments_skipped++;
+            continue;
+        }
+        audit_entry_t entry;
+        uint32_t decoded = 0;
+        while (audit_segment_next(&seg, &entry)) {
+            decoded++;
+            if (!keep_entry(ctx, &entry)) continue;
+            int n = audit_format_csv(&entry, line, sizeof(line));
+            if (n > 0) fwrite(line, 1, (size_t)n, stdout);
+            ctx->records++;
+        }
+        if (decoded != seg.header.record_count) {
+            fprintf(stderr, "⚠️  %s: segment decoded %u of %u records\n", path, decoded, seg.header.record_count);
+        }
+    }
+}
+
+static void export_text(export_ctx_t* ctx, const uint8_t* data, size_t len) {
+    static const char dropped_tag[] = ",AUDIT_DROPPED,";
+    const char* p = (const char*)data;
+    const char* end = p + len;
+    while (p < end) {
+        const char* nl = memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = nl ? nl + 1 : end;
+        char* after = NULL;
+        long long ts = strtoll(p, &after, 10);
+        bool keep = after != p && ts >= ctx->from_ms && ts <= ctx->to_ms;
+        // Device records are "ts,KIND,pseudo,..."; drop markers always pass
+        if (keep && ctx->by_device && !(line_end - after >= (ptrdiff_t)sizeof(dropped_tag) - 1 &&
+                                        memcmp(after, dropped_tag, sizeof(dropped_tag) - 1) == 0)) {
+            const char* kind_end = after + 1 < line_end ? memchr(after + 1, ',', (size_t)(line_end - after - 1)) : NULL;
+            keep = kind_end && strtoul(kind_end + 1, NULL, 10) == ctx->device;
+        }
+        if (keep) {
+            fwrite(p, 1, (size_t)(line_end - p), stdout);
+            if (!nl) fputc('\n', stdout);
+            ctx->records++;
+        }
+        p = line_end;
+    }
+}
+
+static void export_raw(export_ctx_t* ctx, const char* path, const uint8_t* data, size_t len) {
+    if (audit_is_binary(data, len)) export_binary(ctx, path, data, len);
+    else export_text(ctx, data, len);
+}
+
+// Sidecars (.idx, .chain) are named after the uncompressed, unencrypted log
+static void sidecar_path(const char* log_path, const char* suffix, char* out, size_t out_size) {
+    snprintf(out, out_size, "%s", log_path);
+    size_t n = strlen(out);
+    static const char* suffixes[] = { AUDIT_CRYPTO_SUFFIX, AUDIT_ZFILE_SUFFIX };
+    for (size_t i = 0; i < 2; i++) {
+        size_t k = strlen(suffixes[i]);
+        if (n >= k && strcmp(out + n - k, suffixes[i]) == 0) out[n -= k] = '\0';
+    }
+    snprintf(out + n, out_size - n, "%s", suffix);
+}
+
+// Ranges of the log worth reading according to its sidecar index. Without an
+// index the whole log is one range; bytes past the last indexed block (not yet
+// indexed when the file was copied, or after a crash) are always included.
+static size_t select_ranges(export_ctx_t* ctx, const char* log_path, uint64_t raw_len, byte_range_t** out) {
+    char idx_path[1024];
+    sidecar_path(log_path, AUDIT_INDEX_SUFFIX, idx_path, sizeof(idx_path));
+
+    const uint8_t* idx = NULL;
+    size_t idx_len = 0, entries = 0;
+    if (access(idx_path, R_OK) == 0 && map_file(idx_path, &idx, &idx_len) && idx) {
+        entries = audit_index_open(idx, idx_len);
+    }
+
+    byte_range_t* ranges = malloc((entries + 1) * sizeof(*ranges));
+    size_t count = 0;
+    uint64_t covered = 0;
+    for (size_t i = 0; ranges && i < entries; i++) {
+        audit_index_entry_t e;
+        audit_index_entry(idx, i, &e);
+        if (e.offset + e.length > covered) covered = e.offset + e.length;
+        bool match = in_range(ctx, e.first_ts_ms, e.last_ts_ms) &&
+                     (!ctx->by_device || audit_index_bloom_maybe(e.bloom, ctx->device) ||
+                      audit_index_bloom_maybe(e.bloom, AUDIT_INDEX_ID_DROPPED));
+        if (!match) { ctx->blocks_skipped++; continue; }
+        uint64_t hi = e.offset + e.length < raw_len ? e.offset + e.length : raw_len;
+        if (e.offset >= hi) continue;
+        if (count > 0 && ranges[count - 1].hi == e.offset) ranges[count - 1].hi = hi;
+        else ranges[count++] = (byte_range_t){ e.offset, hi };
+    }
+    if (ranges && covered < raw_len) {
+        if (count > 0 && ranges[count - 1].hi == covered) ranges[count - 1].hi = raw_len;
+        else ranges[count++] = (byte_range_t){ covered, raw_len };
+    }
+    if (idx) munmap((void*)idx, idx_len);
+    *out = ranges;
+    return ranges ? count : 0;
+}
+
+static void export_indexed(export_ctx_t* ctx, const char* path, const uint8_t* data, size_t len) {
+    byte_range_t* ranges = NULL;
+    size_t count = select_ranges(ctx, path, len, &ranges);
+    for (size_t i = 0; i < count; i++) {
+        export_raw(ctx, path, data + ranges[i].lo, (size_t)(ranges[i].hi - ranges[i].lo));
+    }
+    free(ranges);
+}
+
+// Compressed container: only frames that overlap a selected range and the
+// time filter are decompressed
+static void export_compressed(export_ctx_t* ctx, const char* path, const uint8_t* data, size_t len) {
+    audit_zfile_t zf;
+    if (!audit_zfile_open(&zf, data, len)) {
+        fprintf(stderr, "⚠️  %s: incomplete or corrupt compressed file\n", path);
+        return;
+    }
+    uint64_t raw_len = 0;
+    audit_zframe_t frame;
+    for (uint32_t i = 0; i < zf.frame_count && audit_zfile_frame(&zf, i, &frame); i++) raw_len += frame.raw_len;
+    byte_range_t* ranges = NULL;
+    size_t count = select_ranges(ctx, path, raw_len, &ranges);
+
+    uint8_t* raw = NULL;
+    size_t raw_cap = 0, r = 0;
+    uint64_t raw_off = 0;
+    for (uint32_t i = 0; i < zf.frame_count; i++, raw_off += frame.raw_len) {
+        if (!audit_zfile_frame(&zf, i, &frame)) {
+            fprintf(stderr, "⚠️  %s: bad index entry %u\n", path, i);
+            break;
+        }
+        while (r < count && ranges[r].hi <= raw_off) r++;
+        bool wanted = r < count && ranges[r].lo < raw_off + frame.raw_len;
+        if (!wanted || !in_range(ctx, frame.first_ts_ms, frame.last_ts_ms)) {
+            ctx->frames_skipped++;
+            continue;
+        }
+        if (frame.raw_len > raw_cap) {
+            uint8_t* grown = realloc(raw, frame.raw_len);
+            if (!grown) break;
+            raw = grown; raw_cap = frame.raw_len;
+        }
+        if (!audit_zfile_decompress(&zf, &frame, raw)) {
+            fprintf(stderr, "⚠️  %s: frame %u failed to decompress\n", path, i);
+            continue;
+        }
+        export_raw(ctx, path, raw, frame.raw_len);
+    }
+    free(raw);
+    free(ranges);
+}
+
+static bool is_encrypted_data(const uint8_t* data, size_t len) {
+    return len >= 4 && (data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24) == AUDIT_CRYPTO_MAGIC;
+}
+
+static int cmd_query(int argc, char** argv, bool allow_device) {
+    export_ctx_t ctx = { .from_ms = INT64_MIN, .to_ms = INT64_MAX };
+    int first_file = argc;
+    for (int i = 2; i < argc; i++) {
+        if ((strcmp(argv[i], "--from") == 0 || strcmp(argv[i], "--to") == 0) && i + 1 < argc) {
+            int64_t* bound = argv[i][2] == 'f' ? &ctx.from_ms : &ctx.to_ms;
+            if (!parse_time(argv[i + 1], bound)) {
+                fprintf(stderr, "❌ Unrecognized time: %s\n", argv[i + 1]);
+                return 2;
+            }
+            i++;
+        } else if (allow_device && strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
+            ctx.by_device = true;
+            ctx.device = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            first_file = i;
+            break;
+        }
+    }
+    if (first_file >= argc) { usage(argv[0]); return 2; }
+
+    static char out_buf[1 << 20];
+    setvbuf(stdout, out_buf, _IOFBF, sizeof(out_buf));
+
+    int rc = 0;
+    for (int i = first_file; i < argc; i++) {
+        const uint8_t* data;
+        size_t len;
+        if (!map_file(argv[i], &data, &len)) { rc = 1; continue; }
+        if (!data) continue;
+        if (audit_zfile_is_compressed(data, len)) export_compressed(&ctx, argv[i], data, len);
+        else if (is_encrypted_data(data, len)) {
+            fprintf(stderr, "⚠️  %s is encrypted; run decrypt first\n", argv[i]);
+            rc = 1;
+        } else export_indexed(&ctx, argv[i], data, len);
+        munmap((void*)data, len);
+    }
+    fflush(stdout);
+    fprintf(stderr, "📄 %llu records (skipped: %llu index blocks, %llu frames, %llu segments)\n",
+            (unsigned long long)ctx.records, (unsigned long long)ctx.blocks_skipped,
+            (unsigned long long)ctx.frames_skipped, (unsigned long long)ctx.segments_skipped);
+    return rc;
+}
+
+// Hash chain verification of one file. Entries are hashed in log order from
+// contiguous runs of the uncompressed log; only entries whose time range
+// overlaps [from, to] are checked.
+typedef struct {
+    int64_t from_ms, to_ms;
+    const char* path;
+    const uint8_t* chain;
+    size_t count;
+    uint8_t start[AUDIT_DIGEST_BYTES];  // digest the file's chain continues from
+    size_t next;                        // entry being hashed
+    uint64_t fed;                       // bytes of it hashed so far
+    bool active;
+    audit_chain_hash_t hash;
+    uint64_t verified, failed, bytes;
+} verify_ctx_t;
+
+static bool chain_selected(const verify_ctx_t* v, const audit_chain_entry_t* e) {
+    return e->records == 0 || (e->last_ts_ms >= v->from_ms && e->first_ts_ms <= v->to_ms);
+}
+
+static void chain_fail(verify_ctx_t* v, size_t i, const audit_chain_entry_t* e, const char* why) {
+    // The first few are enough to locate tampering; the count says the rest
+    if (v->failed++ < 10) {
+        printf("❌ %s: batch %zu (bytes %llu-%llu, ts %lld-%lld) %s\n", v->path, i,
+               (unsigned long long)e->offset, (unsigned long long)(e->offset + e->length),
+               (long long)e->first_ts_ms, (long long)e->last_ts_ms, why);
+    }
+}
+
+// Skip entries outside the time range; true if the run [lo, hi) holds bytes
+// of an entry still to be checked
+static bool verify_wants(verify_ctx_t* v, uint64_t lo, uint64_t hi) {
+    if (v->active) return true;
+    while (v->next < v->count) {
+        audit_chain_entry_t e;
+        audit_chain_entry(v->chain, v->next, &e);
+        if (chain_selected(v, &e)) return e.offset < hi && e.offset + e.length > lo;
+        v->next++;
+    }
+    return false;
+}
+
+static void verify_feed(verify_ctx_t* v, uint64_t raw_off, const uint8_t* data, size_t len) {
+    uint64_t raw_end = raw_off + len;
+    while (verify_wants(v, raw_off, raw_end)) {
+        audit_chain_entry_t e;
+        audit_chain_entry(v->chain, v->next, &e);
+        if (!v->active) {
+            if (e.offset < raw_off) { chain_fail(v, v->next++, &e, "starts in bytes that were not read"); continue; }
+            // Each entry is checked against the recorded digest before it, so
+            // one altered batch does not hide the state of the others
+            audit_chain_entry_t prev;
+            if (v->next > 0) audit_chain_entry(v->chain, v->next - 1, &prev);
+            else memcpy(prev.digest, v->start, AUDIT_DIGEST_BYTES);
+            audit_chain_hash_begin(&v->hash, prev.digest, &e);
+            v->active = true;
+            v->fed = 0;
+        }
+        uint64_t pos = e.offset + v->fed;
+        uint64_t stop = e.offset + e.length < raw_end ? e.offset + e.length : raw_end;
+        audit_chain_hash_update(&v->hash, data + (pos - raw_off), (size_t)(stop - pos));
+        v->fed += stop - pos;
+        if (v->fed < e.length) return;
+        uint8_t digest[AUDIT_DIGEST_BYTES];
+        audit_chain_hash_final(&v->hash, digest);
+        v->active = false;
+        if (memcmp(digest, e.digest, AUDIT_DIGEST_BYTES) != 0) chain_fail(v, v->next, &e, "does not match its digest");
+        else v->verified++;
+        v->bytes += e.length;
+        v->next++;
+    }
+}
+
+// Checks that need only the chain: entries tile the log from offset 0.
+// Bytes outside every entry were never hashed (a crash between a write and
+// its entry, or data written before chaining existed) and are reported.
+static void verify_layout(verify_ctx_t* v, uint64_t raw_len) {
+    uint64_t expect = 0;
+    for (size_t i = 0; i < v->count; i++) {
+        audit_chain_entry_t e;
+        audit_chain_entry(v->chain, i, &e);
+        if (e.offset > expect) {
+            printf("⚠️  %s: bytes %llu-%llu are not covered by the chain\n", v->path,
+                   (unsigned long long)expect, (unsigned long long)e.offset);
+        } else if (e.offset < expect) {
+            chain_fail(v, i, &e, "overlaps the batch before it");
+        }
+        if (e.offset + e.length > raw_len && chain_selected(v, &e)) chain_fail(v, i, &e, "is past the end of the log (truncated)");
+        if (e.offset + e.length > expect) expect = e.offset + e.length;
+    }
+    if (expect < raw_len) {
+        printf("⚠️  %s: last %llu bytes are not covered by the chain\n", v->path,
+               (unsigned long long)(raw_len - expect));
+    }
+}
+
+static void verify_compressed(verify_ctx_t* v, const uint8_t* data, size_t len) {
+    audit_zfile_t zf;
+    if (!audit_zfile_open(&zf, data, len)) {
+        printf("❌ %s: incomplete or corrupt compressed file\n", v->path);
+        v->failed++;
+        return;
+    }
+    uint64_t raw_len = 0;
+    audit_zframe_t frame;
+    for (uint32_t i = 0; i < zf.frame_count && audit_zfile_frame(&zf, i, &frame); i++) raw_len += frame.raw_len;
+    verify_layout(v, raw_len);
+
+    uint8_t* raw = NULL;
+    size_t raw_cap = 0;
+    uint64_t raw_off = 0;
+    for (uint32_t i = 0; i < zf.frame_count; i++, raw_off += frame.raw_len) {
+        if (!audit_zfile_frame(&zf, i, &frame)) {
+            printf("❌ %s: bad index entry %u\n", v->path, i);
+            v->failed++;
+            break;
+        }
+        // Frames holding no batch in the time range are not decompressed
+        if (!verify_wants(v, raw_off, raw_off + frame.raw_len)) continue;
+        if (frame.raw_len > raw_cap) {
+            uint8_t* grown = realloc(raw, frame.raw_len);
+            if (!grown) break;
+            raw = grown; raw_cap = frame.raw_len;
+        }
+        if (!audit_zfile_decompress(&zf, &frame, raw)) {
+            printf("❌ %s: frame %u failed to decompress\n", v->path, i);
+            v->failed++;
+            v->active = false;
+            continue;
+        }
+        verify_feed(v, raw_off, raw, frame.raw_len);
+    }
+    free(raw);
+}
+
+static int cmd_verify(int argc, char** argv) {
+    int64_t from_ms = INT64_MIN, to_ms = INT64_MAX;
+    int first_file = argc;
+    for (int i = 2; i < argc; i++) {
+        if ((strcmp(argv[i], "--from") == 0 || strcmp(argv[i], "--to") == 0) && i + 1 < argc) {
+            int64_t* bound = argv[i][2] == 'f' ? &from_ms : &to_ms;
+            if (!parse_time(argv[i + 1], bound)) {
+                fprintf(stderr, "❌ Unrecognized time: %s\n", argv[i + 1]);
+                return 2;
+            }
+            i++;
+        } else {
+            first_file = i;
+            break;
+        }
+    }
+    if (first_file >= argc) { usage(argv[0]); return 2; }
+
+    audit_chain_hash_t hash;
+    if (!audit_chain_hash_init(&hash)) return 1;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint8_t head[AUDIT_DIGEST_BYTES];
+    bool have_head = false;
+    uint64_t total_bytes = 0;
+    int rc = 0;
+    for (int i = first_file; i < argc; i++) {
+        verify_ctx_t v = { .from_ms = from_ms, .to_ms = to_ms, .path = argv[i], .hash = hash };
+        char chain_path[1024];
+        sidecar_path(argv[i], AUDIT_CHAIN_SUFFIX, chain_path, sizeof(chain_path));
+        const uint8_t* chain = NULL;
+        size_t chain_len = 0;
+        const uint8_t* data = NULL;
+        size_t len = 0;
+        if (!map_file(chain_path, &chain, &chain_len) || !map_file(argv[i], &data, &len)) {
+            if (chain) munmap((void*)chain, chain_len);
+            rc = 1;
+            continue;
+        }
+        v.chain = chain;
+        v.count = chain ? audit_chain_open(chain, chain_len, v.start) : (size_t)-1;
+        if (v.count == (size_t)-1) {
+            printf("❌ %s: %s is not a valid chain file\n", argv[i], chain_path);
+            v.failed++;
+        } else if (is_encrypted_data(data, len)) {
+            printf("⚠️  %s is encrypted; run decrypt first\n", argv[i]);
+            v.failed++;
+        } else {
+            // Consecutive files given in order must link up across rotation
+            if (have_head && memcmp(head, v.start, AUDIT_DIGEST_BYTES) != 0) {
+                printf("⚠️  %s does not continue the chain of the file before it\n", argv[i]);
+            }
+            if (audit_zfile_is_compressed(data, len)) verify_compressed(&v, data, len);
+            else {
+                verify_layout(&v, len);
+                verify_feed(&v, 0, data, len);
+            }
+            audit_chain_entry_t last;
+            if (v.count > 0) audit_chain_entry(chain, v.count - 1, &last);
+            else memcpy(last.digest, v.start, AUDIT_DIGEST_BYTES);
+            memcpy(head, last.digest, AUDIT_DIGEST_BYTES);
+            have_head = true;
+        }
+        if (chain) munmap((void*)chain, chain_len);
+        if (data) munmap((void*)data, len);
+        total_bytes += v.bytes;
+        if (v.failed) {
+            printf("❌ %s: %llu of %llu batches failed\n", argv[i], (unsigned long long)v.failed,
+                   (unsigned long long)(v.failed + v.verified));
+            rc = 1;
+        } else {
+            printf("✅ %s: %llu batches verified (%.1f MB)\n", argv[i], (unsigned long long)v.verified, v.bytes / 1e6);
+        }
+    }
+    audit_chain_hash_free(&hash);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    if (have_head) {
+        // Recording the head elsewhere pins everything before it
+        printf("🔗 Chain head: ");
+        for (int i = 0; i < AUDIT_DIGEST_BYTES; i++) printf("%02x", head[i]);
+        printf("\n");
+    }
+    fprintf(stderr, "⏱️  %.1f MB hashed in %.2f s (%.0f MB/s)\n", total_bytes / 1e6, secs,
+            secs > 0 ? total_bytes / 1e6 / secs : 0.0);
+    return rc;
+}
+
+static bool read_passphrase(const char* key_file, char* out, size_t out_size) {
+    if (key_file) {
+        FILE* f = fopen(key_file, "r");
+        if (!f) { fprintf(stderr, "❌ %s: %s\n", key_file, strerror(errno)); return false; }
+        bool ok = fgets(out, (int)out_size, f) != NULL;
+        fclose(f);
+        if (!ok) return false;
+    } else {
+        const char* typed = getpass("Passphrase: ");
+        if (!typed) return false;
+        snprintf(out, out_size, "%s", typed);
+    }
+    out[strcspn(out, "\r\n")] = '\0';
+    return out[0] != '\0';
+}
+
+static int cmd_decrypt(int argc, char** argv) {
+    const char* key_file = NULL;
+    int i = 2;
+    if (i + 1 < argc && strcmp(argv[i], "--key-file") == 0) { key_file = argv[i + 1]; i += 2; }
+    if (argc - i != 2) { usage(argv[0]); return 2; }
+    char passphrase[256];
+    if (!read_passphrase(key_file, passphrase, sizeof(passphrase))) return 1;
+    bool ok = audit_crypto_decrypt_file(argv[i], argv[i + 1], passphrase);
+    explicit_bzero(passphrase, sizeof(passphrase));
+    if (!ok) { fprintf(stderr, "❌ Decryption failed (wrong passphrase or damaged file)\n"); return 1; }
+    fprintf(stderr, "🔓 Decrypted %s -> %s\n", argv[i], argv[i + 1]);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "query") == 0) return cmd_query(argc, argv, true);
+    if (argc >= 2 && strcmp(argv[1], "export") == 0) return cmd_query(argc, argv, false);
+    if (argc >= 2 && strcmp(argv[1], "verify") == 0) return cmd_verify(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "decrypt") == 0) return cmd_decrypt(argc, argv);
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,220 @@
+// accept4
+#define _GNU_SOURCE
+#include "control_socket.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// A command line never needs more; longer input is a protocol error
+#define CLIENT_IN_SIZE 512
+// Largest reply (the metrics exposition) with room to spare; a client that
+// lets replies pile up past this is dropped rather than buffered without bound
+#define CLIENT_OUT_SIZE (64 * 1024)
+
+typedef struct {
+    int fd;
+    size_t in_len, out_len;
+    char in[CLIENT_IN_SIZE];
+    char out[CLIENT_OUT_SIZE];
+} client_t;
+
+struct control_reply {
+    client_t* client;
+    bool error;
+    bool overflow;
+};
+
+static int s_listen_fd = -1;
+static char s_path[sizeof(((struct sockaddr_un*)0)->sun_path)] = "";
+static control_handler_t s_handler = NULL;
+static client_t s_clients[CONTROL_MAX_CLIENTS];
+static int s_client_count = 0;
+
+void control_socket_default_path(char* out, size_t out_size) {
+    const char* env = getenv("THREEBLINDMICE_CONTROL_SOCKET");
+    const char* runtime = getenv("XDG_RUNTIME_DIR");
+    if (env && env[0]) snprintf(out, out_size, "%s", env);
+    else if (runtime && runtime[0]) snprintf(out, out_size, "%s/threeblindmice.sock", runtime);
+    else snprintf(out, out_size, "/run/threeblindmice.sock");
+}
+
+// A socket file left by a previous run is removed; one with a listener is not
+static bool clear_stale_socket(const struct sockaddr_un* addr) {
+    struct stat st;
+    if (lstat(addr->sun_path, &st) != 0) return errno == ENOENT;
+    if (!S_ISSOCK(st.st_mode)) {
+        printf("⚠️  Control socket path %s exists and is not a socket\n", addr->sun_path);
+        return false;
+    }
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) return false;
+    bool live = connect(probe, (const struct sockaddr*)addr, sizeof(*addr)) == 0;
+    close(probe);
+    if (live) {
+        printf("⚠️  Another instance is serving %s\n", addr->sun_path);
+        return false;
+    }
+    return unlink(addr->sun_path) == 0;
+}
+
+bool control_socket_open(const char* path, control_handler_t handler) {
+    if (!path || !handler || s_listen_fd >= 0) return false;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) return false;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    if (!clear_stale_socket(&addr)) return false;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    // Owner-only from the moment the file appears
+    mode_t old_mask = umask(077);
+    bool ok = bind(fd, (const struct sockaddr*)&addr, sizeof(addr)) == 0;
+    umask(old_mask);
+    if (!ok || listen(fd, CONTROL_MAX_CLIENTS) != 0) {
+        close(fd);
+        return false;
+    }
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) s_clients[i].fd = -1;
+    s_client_count = 0;
+    s_listen_fd = fd;
+    s_handler = handler;
+    snprintf(s_path, sizeof(s_path), "%s", path);
+    return true;
+}
+
+static void drop_client(client_t* c) {
+    if (c->fd < 0) return;
+    close(c->fd);
+    c->fd = -1;
+    s_client_count--;
+}
+
+void control_socket_close(void) {
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) drop_client(&s_clients[i]);
+    if (s_listen_fd >= 0) {
+        close(s_listen_fd);
+        s_listen_fd = -1;
+        unlink(s_path);
+    }
+}
+
+int control_socket_client_count(void) {
+    return s_client_count;
+}
+
+int control_socket_pollfds(struct pollfd* fds, int max_fds) {
+    int n = 0;
+    if (s_listen_fd < 0 || max_fds <= 0) return 0;
+    fds[n++] = (struct pollfd){ .fd = s_listen_fd, .events = POLLIN };
+    for (int i = 0; i < CONTROL_MAX_CLIENTS && n < max_fds; i++) {
+        if (s_clients[i].fd < 0) continue;
+        short events = POLLIN;
+        if (s_clients[i].out_len > 0) events |= POLLOUT;
+        fds[n++] = (struct pollfd){ .fd = s_clients[i].fd, .events = events };
+    }
+    return n;
+}
+
+// Send what is buffered without blocking; false if the client is gone
+static bool flush_client(client_t* c) {
+    size_t sent = 0;
+    while (sent < c->out_len) {
+        ssize_t n = send(c->fd, c->out + sent, c->out_len - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        sent += (size_t)n;
+    }
+    memmove(c->out, c->out + sent, c->out_len - sent);
+    c->out_len -= sent;
+    return true;
+}
+
+void control_reply_printf(control_reply_t* reply, const char* fmt, ...) {
+    client_t* c = reply->client;
+    if (reply->overflow) return;
+    size_t room = sizeof(c->out) - c->out_len;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(c->out + c->out_len, room, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= room) { reply->overflow = true; return; }
+    c->out_len += (size_t)n;
+}
+
+void control_reply_error(control_reply_t* reply, const char* reason) {
+    control_reply_printf(reply, "error %s\n", reason);
+    reply->error = true;
+}
+
+// Run every complete line in the input buffer; false if the client must go
+static bool run_commands(client_t* c) {
+    size_t start = 0;
+    while (start < c->in_len) {
+        char* nl = memchr(c->in + start, '\n', c->in_len - start);
+        if (!nl) break;
+        *nl = '\0';
+        size_t end = (size_t)(nl - c->in);
+        if (end > start && c->in[end - 1] == '\r') c->in[end - 1] = '\0';
+        const char* line = c->in + start;
+        start = end + 1;
+        if (!line[0]) continue;
+        control_reply_t reply = { .client = c };
+        s_handler(line, &reply);
+        if (!reply.error) control_reply_printf(&reply, "ok\n");
+        if (reply.overflow) return false;
+    }
+    memmove(c->in, c->in + start, c->in_len - start);
+    c->in_len -= start;
+    return c->in_len < sizeof(c->in);
+}
+
+static void accept_clients(void) {
+    while (1) {
+        int fd = accept4(s_listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        client_t* slot = NULL;
+        for (int i = 0; i < CONTROL_MAX_CLIENTS && !slot; i++) if (s_clients[i].fd < 0) slot = &s_clients[i];
+        if (!slot) {
+            static const char busy[] = "error too many clients\n";
+            send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+            close(fd);
+            continue;
+        }
+        slot->fd = fd;
+        slot->in_len = slot->out_len = 0;
+        s_client_count++;
+    }
+}
+
+static void service_client(client_t* c, short revents) {
+    if (revents & POLLOUT && !flush_client(c)) { drop_client(c); return; }
+    if (revents & (POLLIN | POLLHUP | POLLERR)) {
+        ssize_t n = recv(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len, MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+        // n == 0: the peer closed; pending replies have nowhere to go
+        if (n <= 0) { drop_client(c); return; }
+        c->in_len += (size_t)n;
+        if (!run_commands(c) || !flush_client(c)) drop_client(c);
+    }
+}
+
+void control_socket_dispatch(const struct pollfd* fds, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!fds[i].revents) continue;
+        if (fds[i].fd == s_listen_fd) { accept_clients(); continue; }
+        for (int k = 0; k < CONTROL_MAX_CLIENTS; k++) {
+            if (s_clients[k].fd == fds[i].fd) { service_client(&s_clients[k], fds[i].revents); break; }
+        }
+    }
+}
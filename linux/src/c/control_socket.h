@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <poll.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Local control socket (Unix domain, stream, mode 0600) with a line protocol:
+// one command per line, answered by zero or more data lines and a final
+// "ok" or "error <reason>" line. For example:
+//
+//   $ socat - UNIX-CONNECT:$XDG_RUNTIME_DIR/threeblindmice.sock
+//   stats
+//   input_events 18234
+//   ...
+//   ok
+//
+// The socket has no thread of its own: the owner adds its descriptors to its
+// poll set and hands back the results, so commands run on the owner's thread
+// and can touch its state directly.
+
+#define CONTROL_MAX_CLIENTS 16
+
+typedef struct control_reply control_reply_t;
+
+// Handle one command line (without the newline); write data lines with
+// control_reply_printf. The final "ok" is added unless control_reply_error was used.
+typedef void (*control_handler_t)(const char* line, control_reply_t* reply);
+
+// $THREEBLINDMICE_CONTROL_SOCKET, else $XDG_RUNTIME_DIR/threeblindmice.sock,
+// else /run/threeblindmice.sock
+void control_socket_default_path(char* out, size_t out_size);
+
+// Bind and listen; a stale socket file is replaced, a live one is refused
+bool control_socket_open(const char* path, control_handler_t handler);
+void control_socket_close(void);
+
+// Descriptors to poll (listener and clients); returns how many were written
+int control_socket_pollfds(struct pollfd* fds, int max_fds);
+// Accept, read and answer based on the revents of those descriptors
+void control_socket_dispatch(const struct pollfd* fds, int count);
+int control_socket_client_count(void);
+
+void control_reply_printf(control_reply_t* reply, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+void control_reply_error(control_reply_t* reply, const char* reason);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,178 @@
+#include "device_transform.h"
+#include <math.h>
+#include <string.h>
+
+// id -> slot index size, kept below ~50% full
+#define INDEX_BITS 9
+#define INDEX_MASK ((1u << INDEX_BITS) - 1)
+#define BATCH 256
+#define NO_SLOT 0xFFFFu
+
+typedef struct {
+    uint32_t id;
+    bool present;
+    int32_t a, b, c, d;
+    int32_t rem_x, rem_y;       // Q16 fraction carried between frames, 0..ONE-1
+    device_transform_params_t params;
+} transform_t;
+
+static transform_t s_transforms[DEVICE_TRANSFORM_MAX];
+static uint16_t s_index[1u << INDEX_BITS];   // slot + 1, 0 = empty
+static int s_count = 0;
+
+static const device_transform_params_t IDENTITY = { .rotation_deg = 0.0, .gain = 1.0 };
+
+static uint32_t transform_home(uint32_t id) {
+    return (id * 0x9E3779B1u) >> (32 - INDEX_BITS);
+}
+
+void device_transform_init(void) {
+    memset(s_transforms, 0, sizeof(s_transforms));
+    memset(s_index, 0, sizeof(s_index));
+    s_count = 0;
+}
+
+static uint32_t find_slot(uint32_t id) {
+    for (uint32_t h = transform_home(id); s_index[h]; h = (h + 1) & INDEX_MASK) {
+        if (s_transforms[s_index[h] - 1].id == id) return h;
+    }
+    return NO_SLOT;
+}
+
+static transform_t* find_transform(uint32_t id) {
+    if (s_count == 0) return NULL;
+    uint32_t h = find_slot(id);
+    return h == NO_SLOT ? NULL : &s_transforms[s_index[h] - 1];
+}
+
+static void remove_transform(uint32_t h) {
+    s_transforms[s_index[h] - 1].present = false;
+    s_count--;
+    // Backward-shift deletion, as in the fusion tables
+    uint32_t hole = h;
+    for (uint32_t j = (h + 1) & INDEX_MASK; s_index[j]; j = (j + 1) & INDEX_MASK) {
+        uint32_t home = transform_home(s_transforms[s_index[j] - 1].id);
+        bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (stays) continue;
+        s_index[hole] = s_index[j];
+        hole = j;
+    }
+    s_index[hole] = 0;
+}
+
+static int32_t q16(double v) {
+    return (int32_t)lround(v * DEVICE_TRANSFORM_ONE);
+}
+
+bool device_transform_set(uint32_t device_id, const device_transform_params_t* params) {
+    if (!isfinite(params->rotation_deg) || !(params->gain >= 1.0 / 64.0 && params->gain <= 16.0)) return false;
+    double rotation = fmod(params->rotation_deg, 360.0);
+    if (rotation < 0.0) rotation += 360.0;
+    // Flip in the device's frame, then rotate clockwise (screen y points down), then scale
+    double rad = rotation * M_PI / 180.0;
+    double fx = params->flip_x ? -1.0 : 1.0, fy = params->flip_y ? -1.0 : 1.0;
+    int32_t a = q16(params->gain * cos(rad) * fx), b = q16(-params->gain * sin(rad) * fy);
+    int32_t c = q16(params->gain * sin(rad) * fx), d = q16(params->gain * cos(rad) * fy);
+
+    uint32_t h = find_slot(device_id);
+    bool identity = a == DEVICE_TRANSFORM_ONE && b == 0 && c == 0 && d == DEVICE_TRANSFORM_ONE;
+    if (identity) {
+        if (h != NO_SLOT) remove_transform(h);
+        return true;
+    }
+    transform_t* t = NULL;
+    if (h != NO_SLOT) {
+        t = &s_transforms[s_index[h] - 1];
+    } else {
+        for (int i = 0; i < DEVICE_TRANSFORM_MAX && !t; i++) if (!s_transforms[i].present) t = &s_transforms[i];
+        if (!t) return false;
+        uint32_t e = transform_home(device_id);
+        while (s_index[e]) e = (e + 1) & INDEX_MASK;
+        s_index[e] = (uint16_t)(t - s_transforms + 1);
+        s_count++;
+        *t = (transform_t){ .id = device_id, .present = true };
+    }
+    t->a = a; t->b = b; t->c = c; t->d = d;
+    t->params = *params;
+    t->params.rotation_deg = rotation;
+    return true;
+}
+
+device_transform_params_t device_transform_get(uint32_t device_id) {
+    const transform_t* t = find_transform(device_id);
+    return t ? t->params : IDENTITY;
+}
+
+// Q16 product plus the carried fraction; floor keeps the carry in 0..ONE-1
+static int32_t carry(int64_t product, int32_t* rem) {
+    int64_t total = product + *rem;
+    int64_t whole = total >> 16;
+    *rem = (int32_t)(total - (whole << 16));
+    return (int32_t)whole;
+}
+
+void device_transform_apply(uint32_t device_id, int32_t* dx, int32_t* dy) {
+    transform_t* t = find_transform(device_id);
+    if (!t) return;
+    int64_t x = *dx, y = *dy;
+    *dx = carry(t->a * x + t->b * y, &t->rem_x);
+    *dy = carry(t->c * x + t->d * y, &t->rem_y);
+}
+
+// The multiply pass works on plain arrays with no aliasing or branches, so
+// the compiler turns it into SIMD multiply-adds; lookups and the per-device
+// carry stay scalar around it. Signed 32x32->64 lane multiplies need
+// SSE4.1, so on x86-64 it is built for AVX2, SSE4.1 and the baseline and
+// the loader picks the best the CPU has.
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define MULTIPLY_KERNEL __attribute__((target_clones("avx2", "sse4.1", "default"), optimize("O3")))
+#else
+#define MULTIPLY_KERNEL
+#endif
+
+MULTIPLY_KERNEL
+static void multiply(const int32_t* restrict a, const int32_t* restrict b, const int32_t* restrict c,
+                     const int32_t* restrict d, const int32_t* restrict x, const int32_t* restrict y,
+                     int64_t* restrict out_x, int64_t* restrict out_y, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out_x[i] = (int64_t)a[i] * x[i] + (int64_t)b[i] * y[i];
+        out_y[i] = (int64_t)c[i] * x[i] + (int64_t)d[i] * y[i];
+    }
+}
+
+void device_transform_batch(const uint32_t* device_ids, int32_t* dx, int32_t* dy, size_t n) {
+    if (s_count == 0) return;
+    int32_t a[BATCH], b[BATCH], c[BATCH], d[BATCH];
+    int64_t px[BATCH], py[BATCH];
+    transform_t* owner[BATCH];
+    for (size_t base = 0; base < n; base += BATCH) {
+        size_t count = n - base < BATCH ? n - base : BATCH;
+        int32_t* x = dx + base;
+        int32_t* y = dy + base;
+        for (size_t i = 0; i < count; i++) {
+            transform_t* t = owner[i] = find_transform(device_ids[base + i]);
+            a[i] = t ? t->a : DEVICE_TRANSFORM_ONE;
+            b[i] = t ? t->b : 0;
+            c[i] = t ? t->c : 0;
+            d[i] = t ? t->d : DEVICE_TRANSFORM_ONE;
+        }
+        multiply(a, b, c, d, x, y, px, py, count);
+        for (size_t i = 0; i < count; i++) if (owner[i]) {
+            x[i] = carry(px[i], &owner[i]->rem_x);
+            y[i] = carry(py[i], &owner[i]->rem_y);
+        }
+    }
+}
+
+int device_transform_count(void) {
+    return s_count;
+}
+
+int device_transform_list(device_transform_info_t* out, int max) {
+    int n = 0;
+    for (int i = 0; i < DEVICE_TRANSFORM_MAX && n < max; i++) if (s_transforms[i].present) {
+        const transform_t* t = &s_transforms[i];
+        out[n++] = (device_transform_info_t){ .id = t->id, .params = t->params, .a = t->a, .b = t->b, .c = t->c, .d = t->d };
+    }
+    return n;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-device 2x2 transform of relative motion, applied as frames are
+// ingested and before rate limiting, so every later stage sees motion in
+// the user's frame. It is the C counterpart of the Swift managers'
+// per-mouse rotation.
+//
+// A transform is an axis flip, then a rotation, then a gain. It is kept as
+// Q16 fixed-point coefficients:
+//   dx' = (a*dx + b*dy) >> 16,  dy' = (c*dx + d*dy) >> 16
+// The fractional part carries over per device, so slow motion at low gain
+// is not lost. Devices without a transform are passed through untouched.
+
+#define DEVICE_TRANSFORM_MAX 256
+#define DEVICE_TRANSFORM_ONE 65536
+// Rotation step of the Swift managers' scroll-to-rotate gesture
+#define DEVICE_TRANSFORM_ROTATE_STEP 15.0
+
+typedef struct {
+    double rotation_deg;        // clockwise on screen
+    double gain;
+    bool flip_x, flip_y;
+} device_transform_params_t;
+
+typedef struct {
+    uint32_t id;
+    device_transform_params_t params;
+    int32_t a, b, c, d;         // Q16
+} device_transform_info_t;
+
+void device_transform_init(void);
+// False when the table is full or the parameters are out of range
+// (gain 1/64..16); identity parameters remove the device's transform
+bool device_transform_set(uint32_t device_id, const device_transform_params_t* params);
+// Current parameters; identity when the device has no transform
+device_transform_params_t device_transform_get(uint32_t device_id);
+
+// One frame, in place
+void device_transform_apply(uint32_t device_id, int32_t* dx, int32_t* dy);
+// n frames of any devices, in place (structure of arrays)
+void device_transform_batch(const uint32_t* device_ids, int32_t* dx, int32_t* dy, size_t n);
+
+int device_transform_count(void);
+int device_transform_list(device_transform_info_t* out, int max);
+
+#ifdef __cplusplus
+}
+#endif
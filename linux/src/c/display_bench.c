@@ -0,0 +1,157 @@
+#include "display_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Micro-benchmark of the display spatial index behind hit testing and
+// clamping: builds layouts of 1 to 64 outputs and times both queries
+// against a linear scan over the same rectangles, checking that they agree.
+
+#define MAX_OUTPUTS 64
+#define POINTS 4096
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [--queries N] [--seed S]\n"
+            "  Times hit test and clamp for layouts of 1, 2, 4 ... 64 outputs,\n"
+            "  N queries each (default 2000000), index against linear scan.\n",
+            argv0);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t s_rng = 1;
+
+static uint32_t next_random(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// Rows of mixed monitors, some rows offset and with gaps, so layouts have
+// dead areas and uneven edges like real desk setups
+static void make_layout(DisplayRect* rects, int count) {
+    static const int32_t modes[][2] = { { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 }, { 1280, 1024 }, { 1080, 1920 } };
+    int per_row = count < 8 ? count : 8;
+    int32_t y = 0;
+    for (int i = 0; i < count; i += per_row) {
+        int32_t x = (int32_t)(next_random() % 400);
+        int32_t row_h = 0;
+        for (int j = i; j < count && j < i + per_row; j++) {
+            const int32_t* mode = modes[next_random() % 5];
+            int32_t top = y + (int32_t)(next_random() % 200);
+            rects[j] = (DisplayRect){ x, top, x + mode[0], top + mode[1] };
+            x += mode[0] + (next_random() % 4 == 0 ? 300 : 0);
+            if (top - y + mode[1] > row_h) row_h = top - y + mode[1];
+        }
+        y += row_h;
+    }
+}
+
+static int32_t linear_hit(const DisplayRect* rects, int count, int32_t x, int32_t y) {
+    for (int i = 0; i < count; i++) {
+        if (x >= rects[i].x0 && x < rects[i].x1 && y >= rects[i].y0 && y < rects[i].y1) return i;
+    }
+    return -1;
+}
+
+static int32_t clamp_i32(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static int32_t linear_clamp(const DisplayRect* rects, int count, int32_t* x, int32_t* y) {
+    int32_t best = -1, best_x = *x, best_y = *y;
+    int64_t best_d = INT64_MAX;
+    for (int i = 0; i < count; i++) {
+        int32_t nx = clamp_i32(*x, rects[i].x0, rects[i].x1 - 1);
+        int32_t ny = clamp_i32(*y, rects[i].y0, rects[i].y1 - 1);
+        int64_t dx = (int64_t)nx - *x, dy = (int64_t)ny - *y;
+        int64_t d = dx * dx + dy * dy;
+        if (d < best_d) { best_d = d; best = i; best_x = nx; best_y = ny; }
+    }
+    *x = best_x;
+    *y = best_y;
+    return best;
+}
+
+static int64_t distance2(int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+    int64_t dx = (int64_t)x1 - x0, dy = (int64_t)y1 - y0;
+    return dx * dx + dy * dy;
+}
+
+int main(int argc, char** argv) {
+    long queries = 2000000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) queries = atol(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) s_rng = (uint32_t)strtoul(argv[++i], NULL, 10) | 1u;
+        else { usage(argv[0]); return 2; }
+    }
+    if (queries <= 0) { usage(argv[0]); return 2; }
+
+    printf("outputs  hit index   hit linear  clamp index clamp linear  (ns/query)\n");
+    int mismatches = 0;
+    volatile int64_t sink = 0;
+    for (int count = 1; count <= MAX_OUTPUTS; count *= 2) {
+        DisplayRect rects[MAX_OUTPUTS];
+        make_layout(rects, count);
+        DisplayIndex index;
+        if (!display_index_build(&index, rects, count)) { fprintf(stderr, "❌ Failed to build index\n"); return 1; }
+
+        // Points over the bounding box and a margin around it, so clamp
+        // sees both dead areas and points off every edge
+        int32_t min_x = rects[0].x0, min_y = rects[0].y0, max_x = rects[0].x1, max_y = rects[0].y1;
+        for (int i = 1; i < count; i++) {
+            if (rects[i].x0 < min_x) min_x = rects[i].x0;
+            if (rects[i].y0 < min_y) min_y = rects[i].y0;
+            if (rects[i].x1 > max_x) max_x = rects[i].x1;
+            if (rects[i].y1 > max_y) max_y = rects[i].y1;
+        }
+        int32_t margin_x = (max_x - min_x) / 10, margin_y = (max_y - min_y) / 10;
+        static int32_t px[POINTS], py[POINTS];
+        for (int i = 0; i < POINTS; i++) {
+            px[i] = min_x - margin_x + (int32_t)(next_random() % (uint32_t)(max_x - min_x + 2 * margin_x));
+            py[i] = min_y - margin_y + (int32_t)(next_random() % (uint32_t)(max_y - min_y + 2 * margin_y));
+        }
+        for (int i = 0; i < POINTS; i++) {
+            if (display_index_hit(&index, px[i], py[i]) != linear_hit(rects, count, px[i], py[i])) mismatches++;
+            int32_t ix = px[i], iy = py[i], lx = px[i], ly = py[i];
+            display_index_clamp(&index, &ix, &iy);
+            linear_clamp(rects, count, &lx, &ly);
+            // Ties may pick different displays; the distance must match
+            if (distance2(px[i], py[i], ix, iy) != distance2(px[i], py[i], lx, ly)) mismatches++;
+        }
+
+        double ns[4];
+        for (int pass = 0; pass < 4; pass++) {
+            uint64_t start = now_ns();
+            int64_t acc = 0;
+            for (long q = 0; q < queries; q++) {
+                int p = (int)(q & (POINTS - 1));
+                int32_t x = px[p], y = py[p];
+                switch (pass) {
+                case 0: acc += display_index_hit(&index, x, y); break;
+                case 1: acc += linear_hit(rects, count, x, y); break;
+                case 2: acc += display_index_clamp(&index, &x, &y) + x + y; break;
+                default: acc += linear_clamp(rects, count, &x, &y) + x + y; break;
+                }
+            }
+            sink += acc;
+            ns[pass] = (double)(now_ns() - start) / (double)queries;
+        }
+        printf("%7d  %9.1f  %11.1f  %11.1f  %12.1f\n", count, ns[0], ns[1], ns[2], ns[3]);
+        display_index_free(&index);
+    }
+    (void)sink;
+    if (mismatches) {
+        printf("❌ %d queries disagree with the linear scan\n", mismatches);
+        return 1;
+    }
+    printf("✅ Index and linear scan agree on all checked queries\n");
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include "display_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Upper bound on grid resolution per axis (keeps tiny displays in huge
+// layouts from blowing up the cell table)
+#define MAX_GRID_DIM 128
+
+static int32_t clamp_i32(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static int32_t cell_col(const DisplayIndex* index, int32_t x) {
+    return clamp_i32((x - index->origin_x) / index->cell_w, 0, index->cols - 1);
+}
+
+static int32_t cell_row(const DisplayIndex* index, int32_t y) {
+    return clamp_i32((y - index->origin_y) / index->cell_h, 0, index->rows - 1);
+}
+
+bool display_index_build(DisplayIndex* index, const DisplayRect* rects, int32_t count) {
+    memset(index, 0, sizeof(*index));
+    if (count <= 0) {
+        return true;
+    }
+
+    int32_t min_x = rects[0].x0, min_y = rects[0].y0;
+    int32_t max_x = rects[0].x1, max_y = rects[0].y1;
+    int32_t min_w = rects[0].x1 - rects[0].x0, min_h = rects[0].y1 - rects[0].y0;
+    for (int32_t i = 1; i < count; ++i) {
+        const DisplayRect* r = &rects[i];
+        min_x = r->x0 < min_x ? r->x0 : min_x;
+        min_y = r->y0 < min_y ? r->y0 : min_y;
+        max_x = r->x1 > max_x ? r->x1 : max_x;
+        max_y = r->y1 > max_y ? r->y1 : max_y;
+        min_w = (r->x1 - r->x0) < min_w ? (r->x1 - r->x0) : min_w;
+        min_h = (r->y1 - r->y0) < min_h ? (r->y1 - r->y0) : min_h;
+    }
+
+    // Cells of half the smallest display keep overlap lists short
+    // (at most four displays per cell for an aligned wall)
+    int32_t span_w = max_x - min_x, span_h = max_y - min_y;
+    int32_t cell_w = min_w / 2 > 0 ? min_w / 2 : 1;
+    int32_t cell_h = min_h / 2 > 0 ? min_h / 2 : 1;
+    if ((span_w + cell_w - 1) / cell_w > MAX_GRID_DIM) cell_w = (span_w + MAX_GRID_DIM - 1) / MAX_GRID_DIM;
+    if ((span_h + cell_h - 1) / cell_h > MAX_GRID_DIM) cell_h = (span_h + MAX_GRID_DIM - 1) / MAX_GRID_DIM;
+
+    index->count = count;
+    index->origin_x = min_x;
+    index->origin_y = min_y;
+    index->cell_w = cell_w;
+    index->cell_h = cell_h;
+    index->cols = (span_w + cell_w - 1) / cell_w;
+    index->rows = (span_h + cell_h - 1) / cell_h;
+    if (index->cols < 1) index->cols = 1;
+    if (index->rows < 1) index->rows = 1;
+
+    int32_t cells = index->cols * index->rows;
+    index->rects = malloc((size_t)count * sizeof(DisplayRect));
+    index->cell_start = calloc((size_t)cells + 1, sizeof(uint32_t));
+    if (!index->rects || !index->cell_start) {
+        display_index_free(index);
+        return false;
+    }
+    memcpy(index->rects, rects, (size_t)count * sizeof(DisplayRect));
+
+    // Two passes: count overlaps per cell, then fill (CSR layout)
+    for (int32_t i = 0; i < count; ++i) {
+        const DisplayRect* r = &rects[i];
+        if (r->x1 <= r->x0 || r->y1 <= r->y0) continue;
+        int32_t c0 = cell_col(index, r->x0), c1 = cell_col(index, r->x1 - 1);
+        int32_t r0 = cell_row(index, r->y0), r1 = cell_row(index, r->y1 - 1);
+        for (int32_t row = r0; row <= r1; ++row)
+            for (int32_t col = c0; col <= c1; ++col) index->cell_start[row * index->cols + col + 1]++;
+    }
+    for (int32_t c = 0; c < cells; ++c) index->cell_start[c + 1] += index->cell_start[c];
+
+    uint32_t total = index->cell_start[cells];
+    index->cell_items = malloc((total > 0 ? total : 1) * sizeof(uint16_t));
+    uint32_t* fill = malloc((size_t)cells * sizeof(uint32_t));
+    if (!index->cell_items || !fill) {
+        free(fill);
+        display_index_free(index);
+        return false;
+    }
+    memcpy(fill, index->cell_start, (size_t)cells * sizeof(uint32_t));
+    for (int32_t i = 0; i < count; ++i) {
+        const DisplayRect* r = &rects[i];
+        if (r->x1 <= r->x0 || r->y1 <= r->y0) continue;
+        int32_t c0 = cell_col(index, r->x0), c1 = cell_col(index, r->x1 - 1);
+        int32_t r0 = cell_row(index, r->y0), r1 = cell_row(index, r->y1 - 1);
+        for (int32_t row = r0; row <= r1; ++row)
+            for (int32_t col = c0; col <= c1; ++col) index->cell_items[fill[row * index->cols + col]++] = (uint16_t)i;
+    }
+    free(fill);
+    return true;
+}
+
+void display_index_free(DisplayIndex* index) {
+    free(index->rects);
+    free(index->cell_start);
+    free(index->cell_items);
+    memset(index, 0, sizeof(*index));
+}
+
+int32_t display_index_hit(const DisplayIndex* index, int32_t x, int32_t y) {
+    if (index->count == 0) return -1;
+    if (x < index->origin_x || y < index->origin_y) return -1;
+    int32_t col = (x - index->origin_x) / index->cell_w;
+    int32_t row = (y - index->origin_y) / index->cell_h;
+    if (col >= index->cols || row >= index->rows) return -1;
+
+    int32_t cell = row * index->cols + col;
+    for (uint32_t k = index->cell_start[cell]; k < index->cell_start[cell + 1]; ++k) {
+        uint16_t i = index->cell_items[k];
+        const DisplayRect* r = &index->rects[i];
+        if (x >= r->x0 && x < r->x1 && y >= r->y0 && y < r->y1) return i;
+    }
+    return -1;
+}
+
+// Squared distance from (x, y) to the nearest pixel of r, and that pixel
+static int64_t nearest_on_rect(const DisplayRect* r, int32_t x, int32_t y, int32_t* nx, int32_t* ny) {
+    *nx = clamp_i32(x, r->x0, r->x1 - 1);
+    *ny = clamp_i32(y, r->y0, r->y1 - 1);
+    int64_t dx = (int64_t)x - *nx, dy = (int64_t)y - *ny;
+    return dx * dx + dy * dy;
+}
+
+static int64_t min_i64(int64_t a, int64_t b) {
+    return a < b ? a : b;
+}
+
+// Squared distance from (x, y) to the half-open box [x0, x1) x [y0, y1)
+static int64_t box_distance2(int64_t x, int64_t y, int64_t x0, int64_t y0, int64_t x1, int64_t y1) {
+    int64_t dx = x < x0 ? x0 - x : (x >= x1 ? x - (x1 - 1) : 0);
+    int64_t dy = y < y0 ? y0 - y : (y >= y1 ? y - (y1 - 1) : 0);
+    return dx * dx + dy * dy;
+}
+
+int32_t display_index_clamp(const DisplayIndex* index, int32_t* x, int32_t* y) {
+    if (index->count == 0) return -1;
+    int32_t hit = display_index_hit(index, *x, *y);
+    if (hit >= 0) return hit;
+
+    // Ring search outward from the cell nearest to the point. After ring r,
+    // every unvisited cell lies beyond one of the ring's outer edges, which
+    // bounds how close any remaining display can be.
+    int32_t px = *x, py = *y;
+    int32_t c0 = cell_col(index, px), r0 = cell_row(index, py);
+    int32_t max_ring = index->cols > index->rows ? index->cols : index->rows;
+    int64_t best_d2 = INT64_MAX;
+    int32_t best = -1, best_x = px, best_y = py;
+
+    for (int32_t ring = 0; ring <= max_ring; ++ring) {
+        int32_t col_lo = c0 - ring, col_hi = c0 + ring;
+        int32_t row_lo = r0 - ring, row_hi = r0 + ring;
+        for (int32_t row = row_lo; row <= row_hi; ++row) {
+            if (row < 0 || row >= index->rows) continue;
+            bool edge_row = (row == row_lo || row == row_hi);
+            for (int32_t col = col_lo; col <= col_hi; col += edge_row ? 1 : (col_hi - col_lo)) {
+                if (col >= 0 && col < index->cols) {
+                    int32_t cell = row * index->cols + col;
+                    for (uint32_t k = index->cell_start[cell]; k < index->cell_start[cell + 1]; ++k) {
+                        uint16_t i = index->cell_items[k];
+                        int32_t nx, ny;
+                        int64_t d2 = nearest_on_rect(&index->rects[i], px, py, &nx, &ny);
+                        if (d2 < best_d2) { best_d2 = d2; best = i; best_x = nx; best_y = ny; }
+                    }
+                }
+                if (col_hi == col_lo) break;
+            }
+        }
+
+        if (best >= 0) {
+            // Lower bound on distance to any cell outside this ring: each side
+            // with cells left beyond it bounds a box of the grid
+            int64_t gx0 = index->origin_x, gy0 = index->origin_y;
+            int64_t gx1 = gx0 + (int64_t)index->cols * index->cell_w;
+            int64_t gy1 = gy0 + (int64_t)index->rows * index->cell_h;
+            int64_t rx0 = gx0 + (int64_t)col_lo * index->cell_w, rx1 = gx0 + (int64_t)(col_hi + 1) * index->cell_w;
+            int64_t ry0 = gy0 + (int64_t)row_lo * index->cell_h, ry1 = gy0 + (int64_t)(row_hi + 1) * index->cell_h;
+            int64_t bound2 = INT64_MAX;
+            if (col_lo > 0) bound2 = min_i64(bound2, box_distance2(px, py, gx0, gy0, rx0, gy1));
+            if (col_hi < index->cols - 1) bound2 = min_i64(bound2, box_distance2(px, py, rx1, gy0, gx1, gy1));
+            if (row_lo > 0) bound2 = min_i64(bound2, box_distance2(px, py, gx0, gy0, gx1, ry0));
+            if (row_hi < index->rows - 1) bound2 = min_i64(bound2, box_distance2(px, py, gx0, ry1, gx1, gy1));
+            if (bound2 >= best_d2) break;
+        }
+    }
+
+    if (best >= 0) {
+        *x = best_x;
+        *y = best_y;
+    }
+    return best;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compact display rectangle (half-open: x0 <= x < x1, y0 <= y < y1)
+typedef struct {
+    int32_t x0, y0, x1, y1;
+} DisplayRect;
+
+// Uniform grid over the bounding box of all displays. Each cell lists the
+// displays overlapping it, so point queries touch one cell and nearest-point
+// queries only walk rings of cells until no closer display can exist.
+typedef struct {
+    int32_t count;
+    int32_t origin_x, origin_y;
+    int32_t cell_w, cell_h;
+    int32_t cols, rows;
+    DisplayRect* rects;     // count entries
+    uint32_t* cell_start;   // cols*rows + 1 offsets into cell_items
+    uint16_t* cell_items;   // display indices
+} DisplayIndex;
+
+// Build an index over rects (copied). Returns false on allocation failure.
+bool display_index_build(DisplayIndex* index, const DisplayRect* rects, int32_t count);
+void display_index_free(DisplayIndex* index);
+
+// Index of the display containing (x, y), or -1 if the point is in a dead area
+int32_t display_index_hit(const DisplayIndex* index, int32_t x, int32_t y);
+
+// Move (x, y) to the nearest point on any display. Returns that display's
+// index, or -1 if the index is empty (point left untouched).
+int32_t display_index_clamp(const DisplayIndex* index, int32_t* x, int32_t* y);
+
+#ifdef __cplusplus
+}
+#endif
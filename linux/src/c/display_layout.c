@@ -0,0 +1,37 @@
+#include "display_manager.h"
+
+// Layout geometry queries. Kept apart from the RandR watcher so code that
+// only needs a DisplayLayout (the fusion engine, the Node addon) builds
+// without X11.
+
+bool display_manager_is_point_in_display(int32_t x, int32_t y, const DisplayInfo* display) {
+    if (!display) {
+        return false;
+    }
+
+    return (x >= display->x && x < display->x + display->width &&
+            y >= display->y && y < display->y + display->height);
+}
+
+int32_t display_manager_hit_test(const DisplayLayout* layout, int32_t x, int32_t y) {
+    if (layout->index.count > 0) {
+        return display_index_hit(&layout->index, x, y);
+    }
+    for (int32_t i = 0; i < layout->count; ++i) {
+        if (display_manager_is_point_in_display(x, y, &layout->displays[i])) return i;
+    }
+    return -1;
+}
+
+int32_t display_manager_clamp_to_layout(const DisplayLayout* layout, int32_t* x, int32_t* y) {
+    if (layout->index.count > 0) {
+        return display_index_clamp(&layout->index, x, y);
+    }
+    // Unindexed (fallback) layout: clamp to the bounding box
+    if (*x < layout->total_x) *x = layout->total_x;
+    if (*y < layout->total_y) *y = layout->total_y;
+    if (*x > layout->total_x + layout->total_width - 1) *x = layout->total_x + layout->total_width - 1;
+    if (*y > layout->total_y + layout->total_height - 1) *y = layout->total_y + layout->total_height - 1;
+    int32_t index = display_manager_hit_test(layout, *x, *y);
+    return index >= 0 ? index : layout->primary;
+}
@@ -1,21 +1,81 @@
 #include "display_manager.h"
+#include "layout_reclaim.h"
 #include <X11/Xlib.h>
+#include <X11/Xresource.h>
 #include <X11/extensions/Xrandr.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+
+// How often the watcher looks for retired layouts every reader has moved past
+#define RECLAIM_POLL_MS 100
+
+// X11's nominal resolution; a scale factor of 1.0 means 96 DPI
+#define BASE_DPI 96.0f
+
+// Server-side view of outputs and CRTCs, owned by the watcher (guarded by g_lock).
+// RandR change events patch these tables in place; layouts are derived from them
+// without further round trips.
+typedef struct {
+    RROutput id;
+    RRCrtc crtc;
+    bool connected;
+    char name[256];
+    unsigned long mm_width, mm_height;
+} OutputState;
+
+typedef struct {
+    RRCrtc id;
+    int32_t x, y, width, height;
+    Rotation rotation;
+} CrtcState;
+
+// Layout allocation: header and display array in one block
+typedef struct {
+    DisplayLayout layout;
+    DisplayInfo displays[];
+} LayoutBlock;
 
 // Global display manager state
 static Display* g_display = NULL;
-static DisplayInfo* g_displays = NULL;
-static int32_t g_display_count = 0;
-static DisplayInfo* g_primary_display = NULL;
+static int g_rr_event_base = 0;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static OutputState* g_outputs = NULL;
+static int g_output_count = 0;
+static CrtcState* g_crtcs = NULL;
+static int g_crtc_count = 0;
+static RROutput g_primary_output = None;
+static float g_xft_dpi = 0.0f; // 0 if Xft.dpi is not set
+static uint64_t g_generation = 0;
+
+static _Atomic(LayoutBlock*) g_current = NULL;
+
+static pthread_t g_watch_thread;
+static bool g_watching = false;
+static int g_wake_pipe[2] = { -1, -1 };
+
+// Fallback used before the first enumeration or without an X server
+static const DisplayInfo g_fallback_display = {
+    "default", "Default", 0, 0, 1920, 1080, true, 1.0f
+};
+static const float g_fallback_gain = 1.0f;
+static const DisplayLayout g_fallback_layout = {
+    0, 1, 0, 0, 0, 1920, 1080, &g_fallback_display, &g_fallback_gain, { 0 }
+};
 
 // Forward declarations
-static void enumerate_outputs(void);
-static void cleanup_displays(void);
-static const char* get_output_name(RROutput output);
-static float get_output_scale_factor(RROutput output);
+static bool resync_tables(void);
+static bool apply_event(const XEvent* event);
+static void publish_layout(void);
+static void free_layout_block(void* block);
+static void cleanup_tables(void);
+static void* watch_thread(void* arg);
+static float query_xft_dpi(void);
+static float get_output_dpi(const OutputState* output, const CrtcState* crtc);
 
 void display_manager_init(void) {
     g_display = XOpenDisplay(NULL);
@@ -23,20 +83,46 @@ void display_manager_init(void) {
         printf("❌ Failed to open X display\n");
         return;
     }
-    
+
     // Check for XRandR extension
     int event_base, error_base;
     if (!XRRQueryExtension(g_display, &event_base, &error_base)) {
         printf("❌ XRandR extension not available\n");
         return;
     }
-    
+    g_rr_event_base = event_base;
+
+    // Watch for hotplug, mode and arrangement changes before the first
+    // enumeration so nothing slips in between
+    XRRSelectInput(g_display, DefaultRootWindow(g_display),
+                   RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask | RROutputChangeNotifyMask);
+
     display_manager_update_displays();
+
+    if (pipe(g_wake_pipe) != 0) {
+        printf("⚠️  Display change tracking disabled (pipe failed)\n");
+        return;
+    }
+    if (pthread_create(&g_watch_thread, NULL, watch_thread, NULL) == 0) {
+        g_watching = true;
+    } else {
+        printf("⚠️  Display change tracking disabled (thread failed)\n");
+    }
 }
 
 void display_manager_cleanup(void) {
-    cleanup_displays();
-    
+    if (g_watching) {
+        char c = 0;
+        if (write(g_wake_pipe[1], &c, 1) < 0) { /* thread also exits on X errors */ }
+        pthread_join(g_watch_thread, NULL);
+        g_watching = false;
+    }
+    if (g_wake_pipe[0] >= 0) { close(g_wake_pipe[0]); close(g_wake_pipe[1]); g_wake_pipe[0] = g_wake_pipe[1] = -1; }
+
+    free_layout_block(atomic_exchange(&g_current, NULL));
+    layout_reclaim_drain(free_layout_block);
+    cleanup_tables();
+
     if (g_display) {
         XCloseDisplay(g_display);
         g_display = NULL;
@@ -48,90 +134,104 @@ void display_manager_update_displays(void) {
         printf("❌ Display not initialized\n");
         return;
     }
-    
-    cleanup_displays();
-    enumerate_outputs();
-    
-    printf("🖥️  Updated displays: %d found\n", g_display_count);
-    for (int32_t i = 0; i < g_display_count; ++i) {
-        const DisplayInfo* display = &g_displays[i];
-        printf("   Display %d: %s (%dx%d) %s\n", 
-               i + 1, display->name, display->width, display->height,
-               display->isPrimary ? "[PRIMARY]" : "");
+
+    pthread_mutex_lock(&g_lock);
+    if (resync_tables()) {
+        publish_layout();
     }
+    pthread_mutex_unlock(&g_lock);
 }
 
+const DisplayLayout* display_manager_get_layout(void) {
+    LayoutBlock* block = atomic_load_explicit(&g_current, memory_order_acquire);
+    return block ? &block->layout : &g_fallback_layout;
+}
+
+int display_manager_register_reader(void) {
+    return layout_reclaim_register();
+}
+
+void display_manager_unregister_reader(int reader) {
+    layout_reclaim_unregister(reader);
+}
+
+void display_manager_layout_seen(int reader, uint64_t generation) {
+    layout_reclaim_seen(reader, generation);
+}
+
+// The getters below copy out of the current layout and keep nothing, so they
+// hold off reclamation for the copy instead of registering as readers
+
 int32_t display_manager_get_display_count(void) {
-    return g_display_count;
+    layout_reclaim_read_begin();
+    int32_t count = display_manager_get_layout()->count;
+    layout_reclaim_read_end();
+    return count;
 }
 
 void display_manager_get_display_info(int32_t index, DisplayInfo* info) {
-    if (!info || index < 0 || index >= g_display_count) {
+    if (!info) {
         return;
     }
-    
-    *info = g_displays[index];
+
+    layout_reclaim_read_begin();
+    const DisplayLayout* layout = display_manager_get_layout();
+    if (index >= 0 && index < layout->count) {
+        *info = layout->displays[index];
+    }
+    layout_reclaim_read_end();
 }
 
 void display_manager_get_primary_display_info(DisplayInfo* info) {
-    if (!info || !g_primary_display) {
+    if (!info) {
         return;
     }
-    
-    *info = *g_primary_display;
+
+    layout_reclaim_read_begin();
+    const DisplayLayout* layout = display_manager_get_layout();
+    if (layout->primary >= 0) {
+        *info = layout->displays[layout->primary];
+    }
+    layout_reclaim_read_end();
 }
 
 int32_t display_manager_get_display_at(int32_t x, int32_t y, DisplayInfo* info) {
     if (!info) {
         return 0;
     }
-    
-    for (int32_t i = 0; i < g_display_count; ++i) {
-        const DisplayInfo* display = &g_displays[i];
-        if (display_manager_is_point_in_display(x, y, display)) {
-            *info = *display;
-            return 1; // Found
-        }
+
+    layout_reclaim_read_begin();
+    const DisplayLayout* layout = display_manager_get_layout();
+    int32_t index = display_manager_hit_test(layout, x, y);
+    if (index >= 0) {
+        *info = layout->displays[index];
     }
-    
-    return 0; // Not found
+    layout_reclaim_read_end();
+    return index >= 0 ? 1 : 0; // Found / not found
 }
 
 void display_manager_get_total_screen_bounds(int32_t* x, int32_t* y, int32_t* width, int32_t* height) {
-    if (!x || !y || !width || !height || g_display_count == 0) {
-        *x = *y = 0;
-        *width = 1920;
-        *height = 1080;
+    if (!x || !y || !width || !height) {
         return;
     }
-    
-    int32_t minX = g_displays[0].x;
-    int32_t minY = g_displays[0].y;
-    int32_t maxX = g_displays[0].x + g_displays[0].width;
-    int32_t maxY = g_displays[0].y + g_displays[0].height;
-    
-    for (int32_t i = 1; i < g_display_count; ++i) {
-        const DisplayInfo* display = &g_displays[i];
-        minX = (display->x < minX) ? display->x : minX;
-        minY = (display->y < minY) ? display->y : minY;
-        maxX = (display->x + display->width > maxX) ? display->x + display->width : maxX;
-        maxY = (display->y + display->height > maxY) ? display->y + display->height : maxY;
-    }
-    
-    *x = minX;
-    *y = minY;
-    *width = maxX - minX;
-    *height = maxY - minY;
+
+    layout_reclaim_read_begin();
+    const DisplayLayout* layout = display_manager_get_layout();
+    *x = layout->total_x;
+    *y = layout->total_y;
+    *width = layout->total_width;
+    *height = layout->total_height;
+    layout_reclaim_read_end();
 }
 
 void display_manager_clamp_to_display_bounds(int32_t x, int32_t y, const DisplayInfo* display, int32_t* clampedX, int32_t* clampedY) {
     if (!display || !clampedX || !clampedY) {
         return;
     }
-    
-    *clampedX = (x < display->x) ? display->x : 
+
+    *clampedX = (x < display->x) ? display->x :
                 (x >= display->x + display->width) ? display->x + display->width - 1 : x;
-    *clampedY = (y < display->y) ? display->y : 
+    *clampedY = (y < display->y) ? display->y :
                 (y >= display->y + display->height) ? display->y + display->height - 1 : y;
 }
 
@@ -139,173 +239,324 @@ const char* display_manager_get_display_name(const DisplayInfo* display) {
     return display ? display->name : "Unknown";
 }
 
-bool display_manager_is_point_in_display(int32_t x, int32_t y, const DisplayInfo* display) {
-    if (!display) {
-        return false;
-    }
-    
-    return (x >= display->x && x < display->x + display->width &&
-            y >= display->y && y < display->y + display->height);
-}
-
 // Private functions
-static void enumerate_outputs(void) {
-    if (!g_display) {
-        return;
-    }
-    
+
+// Full resync of the output/CRTC tables. Only used at startup, on
+// ScreenChangeNotify and when an event names an output we have not seen.
+static bool resync_tables(void) {
     Window root = DefaultRootWindow(g_display);
-    XRRScreenResources* screen_resources = XRRGetScreenResources(g_display, root);
-    
-    if (!screen_resources) {
+    XRRScreenResources* resources = XRRGetScreenResourcesCurrent(g_display, root);
+
+    if (!resources) {
         printf("❌ Failed to get screen resources\n");
-        return;
+        return false;
     }
-    
-    // Count connected outputs
-    int32_t connected_count = 0;
-    for (int i = 0; i < screen_resources->noutput; ++i) {
-        XRROutputInfo* output_info = XRRGetOutputInfo(g_display, screen_resources, screen_resources->outputs[i]);
-        if (output_info && output_info->connection == RR_Connected) {
-            connected_count++;
+
+    OutputState* outputs = calloc(resources->noutput > 0 ? resources->noutput : 1, sizeof(OutputState));
+    CrtcState* crtcs = calloc(resources->ncrtc > 0 ? resources->ncrtc : 1, sizeof(CrtcState));
+    if (!outputs || !crtcs) {
+        printf("❌ Failed to allocate display tables\n");
+        free(outputs);
+        free(crtcs);
+        XRRFreeScreenResources(resources);
+        return false;
+    }
+
+    for (int i = 0; i < resources->ncrtc; ++i) {
+        CrtcState* crtc = &crtcs[i];
+        crtc->id = resources->crtcs[i];
+        XRRCrtcInfo* crtc_info = XRRGetCrtcInfo(g_display, resources, resources->crtcs[i]);
+        if (crtc_info) {
+            crtc->x = crtc_info->x;
+            crtc->y = crtc_info->y;
+            crtc->width = (int32_t)crtc_info->width;
+            crtc->height = (int32_t)crtc_info->height;
+            crtc->rotation = crtc_info->rotation;
+            XRRFreeCrtcInfo(crtc_info);
         }
+    }
+
+    for (int i = 0; i < resources->noutput; ++i) {
+        OutputState* output = &outputs[i];
+        output->id = resources->outputs[i];
+        XRROutputInfo* output_info = XRRGetOutputInfo(g_display, resources, resources->outputs[i]);
         if (output_info) {
+            output->crtc = output_info->crtc;
+            output->connected = (output_info->connection == RR_Connected);
+            output->mm_width = output_info->mm_width;
+            output->mm_height = output_info->mm_height;
+            snprintf(output->name, sizeof(output->name), "%s",
+                     (output_info->name && output_info->name[0]) ? output_info->name : "Unknown");
             XRRFreeOutputInfo(output_info);
+        } else {
+            snprintf(output->name, sizeof(output->name), "Unknown");
         }
     }
-    
-    if (connected_count == 0) {
-        printf("❌ No connected outputs found\n");
-        XRRFreeScreenResources(screen_resources);
-        return;
+
+    cleanup_tables();
+    g_outputs = outputs;
+    g_output_count = resources->noutput;
+    g_crtcs = crtcs;
+    g_crtc_count = resources->ncrtc;
+    g_primary_output = XRRGetOutputPrimary(g_display, root);
+    g_xft_dpi = query_xft_dpi();
+
+    XRRFreeScreenResources(resources);
+    return true;
+}
+
+// Patch the tables from a RandR notification. Returns true if the layout changed.
+static bool apply_event(const XEvent* event) {
+    if (event->type == g_rr_event_base + RRScreenChangeNotify) {
+        XRRUpdateConfiguration((XEvent*)event);
+        return resync_tables();
     }
-    
-    // Allocate display array
-    g_displays = (DisplayInfo*)calloc(connected_count, sizeof(DisplayInfo));
-    if (!g_displays) {
-        printf("❌ Failed to allocate display array\n");
-        XRRFreeScreenResources(screen_resources);
-        return;
+    if (event->type != g_rr_event_base + RRNotify) {
+        return false;
     }
-    
-    // Enumerate connected outputs
-    int32_t display_index = 0;
-    for (int i = 0; i < screen_resources->noutput; ++i) {
-        XRROutputInfo* output_info = XRRGetOutputInfo(g_display, screen_resources, screen_resources->outputs[i]);
-        
-        if (output_info && output_info->connection == RR_Connected) {
-            DisplayInfo* display = &g_displays[display_index];
-            
-            // Get output name
-            const char* name = get_output_name(screen_resources->outputs[i]);
-            strncpy(display->name, name, sizeof(display->name) - 1);
-            display->name[sizeof(display->name) - 1] = '\0';
-            
-            // Generate ID
-            snprintf(display->id, sizeof(display->id), "output_%lu", screen_resources->outputs[i]);
-            
-            // Get current mode
-            if (output_info->nmode > 0) {
-                XRRModeInfo* mode_info = NULL;
-                for (int j = 0; j < screen_resources->nmode; ++j) {
-                    if (screen_resources->modes[j].id == output_info->modes[output_info->npreferred]) {
-                        mode_info = &screen_resources->modes[j];
-                        break;
-                    }
-                }
-                
-                if (mode_info) {
-                    display->width = mode_info->width;
-                    display->height = mode_info->height;
-                } else {
-                    display->width = 1920;
-                    display->height = 1080;
-                }
-            } else {
-                display->width = 1920;
-                display->height = 1080;
-            }
-            
-            // Get position (simplified - assume primary at 0,0)
-            display->x = (display_index == 0) ? 0 : display_index * display->width;
-            display->y = 0;
-            
-            // Check if primary
-            display->isPrimary = (display_index == 0);
-            
-            // Get scale factor
-            display->scaleFactor = get_output_scale_factor(screen_resources->outputs[i]);
-            
-            if (display->isPrimary) {
-                g_primary_display = display;
+
+    const XRRNotifyEvent* notify = (const XRRNotifyEvent*)event;
+    if (notify->subtype == RRNotify_CrtcChange) {
+        const XRRCrtcChangeNotifyEvent* ce = (const XRRCrtcChangeNotifyEvent*)event;
+        for (int i = 0; i < g_crtc_count; ++i) {
+            if (g_crtcs[i].id != ce->crtc) continue;
+            CrtcState* crtc = &g_crtcs[i];
+            int32_t width = ce->mode == None ? 0 : (int32_t)ce->width;
+            int32_t height = ce->mode == None ? 0 : (int32_t)ce->height;
+            if (crtc->x == ce->x && crtc->y == ce->y && crtc->width == width && crtc->height == height &&
+                crtc->rotation == ce->rotation) {
+                return false;
             }
-            
-            display_index++;
+            crtc->x = ce->x;
+            crtc->y = ce->y;
+            crtc->width = width;
+            crtc->height = height;
+            crtc->rotation = ce->rotation;
+            return true;
         }
-        
-        if (output_info) {
-            XRRFreeOutputInfo(output_info);
+        return resync_tables();
+    }
+    if (notify->subtype == RRNotify_OutputChange) {
+        const XRROutputChangeNotifyEvent* oe = (const XRROutputChangeNotifyEvent*)event;
+        for (int i = 0; i < g_output_count; ++i) {
+            if (g_outputs[i].id != oe->output) continue;
+            OutputState* output = &g_outputs[i];
+            bool connected = (oe->connection == RR_Connected);
+            if (output->crtc == oe->crtc && output->connected == connected) {
+                return false;
+            }
+            if (output->connected != connected) {
+                // A different monitor may now be on this connector; refetch its physical size
+                return resync_tables();
+            }
+            output->crtc = oe->crtc;
+            output->connected = connected;
+            return true;
         }
+        return resync_tables();
     }
-    
-    g_display_count = display_index;
-    XRRFreeScreenResources(screen_resources);
+    return false;
 }
 
-static void cleanup_displays(void) {
-    if (g_displays) {
-        free(g_displays);
-        g_displays = NULL;
+static const CrtcState* find_crtc(RRCrtc id) {
+    for (int i = 0; i < g_crtc_count; ++i) {
+        if (g_crtcs[i].id == id) return &g_crtcs[i];
     }
-    g_display_count = 0;
-    g_primary_display = NULL;
+    return NULL;
 }
 
-static const char* get_output_name(RROutput output) {
-    static char name_buffer[256];
-    name_buffer[0] = '\0';
-    
-    if (!g_display) {
-        return "Unknown";
+// Build a new layout from the tables and swap it in. Caller holds g_lock.
+static void publish_layout(void) {
+    int32_t active_count = 0;
+    for (int i = 0; i < g_output_count; ++i) {
+        const CrtcState* crtc = g_outputs[i].connected ? find_crtc(g_outputs[i].crtc) : NULL;
+        if (crtc && crtc->width > 0 && crtc->height > 0) active_count++;
     }
-    
-    Window root = DefaultRootWindow(g_display);
-    XRRScreenResources* resources = NULL;
-    
-    // Prefer Current if available; fallback to GetScreenResources
-#ifdef XrandrServer
-    resources = XRRGetScreenResourcesCurrent(g_display, root);
-#else
-    resources = XRRGetScreenResources(g_display, root);
-#endif
+
+    LayoutBlock* block = calloc(1, sizeof(LayoutBlock) + (size_t)active_count * (sizeof(DisplayInfo) + sizeof(float)));
+    if (!block) {
+        printf("❌ Failed to allocate display array\n");
+        return;
+    }
+
+    DisplayLayout* layout = &block->layout;
+    float* gains = (float*)(block->displays + active_count);
+    float reference_dpi = g_xft_dpi > 0.0f ? g_xft_dpi : BASE_DPI;
+    layout->primary = -1;
+    int32_t display_index = 0;
+    for (int i = 0; i < g_output_count; ++i) {
+        const OutputState* output = &g_outputs[i];
+        const CrtcState* crtc = output->connected ? find_crtc(output->crtc) : NULL;
+        if (!crtc || crtc->width <= 0 || crtc->height <= 0) continue;
+
+        DisplayInfo* display = &block->displays[display_index];
+        snprintf(display->name, sizeof(display->name), "%s", output->name);
+        snprintf(display->id, sizeof(display->id), "output_%lu", (unsigned long)output->id);
+        display->x = crtc->x;
+        display->y = crtc->y;
+        display->width = crtc->width;
+        display->height = crtc->height;
+        display->isPrimary = (output->id == g_primary_output);
+        float dpi = get_output_dpi(output, crtc);
+        display->scaleFactor = dpi / BASE_DPI;
+        // Motion gain so a given physical hand movement covers the same
+        // physical distance on every display
+        gains[display_index] = dpi / reference_dpi;
+        if (display->isPrimary) {
+            layout->primary = display_index;
+        }
+        display_index++;
+    }
+
+    if (display_index == 0) {
+        printf("❌ No connected outputs found\n");
+        free(block);
+        return;
+    }
+    if (layout->primary < 0) {
+        // No primary configured: treat the first active output as primary
+        layout->primary = 0;
+        block->displays[0].isPrimary = true;
+    }
+
+    int32_t minX = block->displays[0].x;
+    int32_t minY = block->displays[0].y;
+    int32_t maxX = block->displays[0].x + block->displays[0].width;
+    int32_t maxY = block->displays[0].y + block->displays[0].height;
+    for (int32_t i = 1; i < display_index; ++i) {
+        const DisplayInfo* display = &block->displays[i];
+        minX = (display->x < minX) ? display->x : minX;
+        minY = (display->y < minY) ? display->y : minY;
+        maxX = (display->x + display->width > maxX) ? display->x + display->width : maxX;
+        maxY = (display->y + display->height > maxY) ? display->y + display->height : maxY;
+    }
+
+    layout->generation = ++g_generation;
+    layout->count = display_index;
+    layout->total_x = minX;
+    layout->total_y = minY;
+    layout->total_width = maxX - minX;
+    layout->total_height = maxY - minY;
+    layout->displays = block->displays;
+    layout->gains = gains;
+
+    DisplayRect rects[display_index];
+    for (int32_t i = 0; i < display_index; ++i) {
+        const DisplayInfo* display = &block->displays[i];
+        rects[i] = (DisplayRect){ display->x, display->y, display->x + display->width, display->y + display->height };
+    }
+    if (!display_index_build(&layout->index, rects, display_index)) {
+        printf("⚠️  Failed to build display index, clamping to bounding box\n");
+    }
+
+    LayoutBlock* old = atomic_exchange_explicit(&g_current, block, memory_order_acq_rel);
+    if (old) {
+        // On allocation failure the old layout is leaked rather than freed under a reader
+        layout_reclaim_retire(old, old->layout.generation);
+    }
+
+    printf("🖥️  Updated displays: %d found\n", layout->count);
+    for (int32_t i = 0; i < layout->count; ++i) {
+        const DisplayInfo* display = &layout->displays[i];
+        printf("   Display %d: %s (%dx%d+%d+%d, %.0f DPI, gain %.2f) %s\n",
+               i + 1, display->name, display->width, display->height, display->x, display->y,
+               display->scaleFactor * BASE_DPI, layout->gains[i],
+               display->isPrimary ? "[PRIMARY]" : "");
+    }
+}
+
+static void free_layout_block(void* block) {
+    if (!block) return;
+    display_index_free(&((LayoutBlock*)block)->layout.index);
+    free(block);
+}
+
+static void cleanup_tables(void) {
+    free(g_outputs);
+    g_outputs = NULL;
+    g_output_count = 0;
+    free(g_crtcs);
+    g_crtcs = NULL;
+    g_crtc_count = 0;
+}
+
+// Waits on the X connection and rebuilds the layout when RandR reports changes.
+// Bursts of events (a hotplug emits several) are coalesced into one publish.
+static void* watch_thread(void* arg) {
+    (void)arg;
+    struct pollfd fds[2];
+    fds[0].fd = ConnectionNumber(g_display);
+    fds[0].events = POLLIN;
+    fds[1].fd = g_wake_pipe[0];
+    fds[1].events = POLLIN;
+
+    while (1) {
+        int timeout = layout_reclaim_pending() ? RECLAIM_POLL_MS : -1;
+        int result = poll(fds, 2, timeout);
+        if (result < 0) continue;
+        if (fds[1].revents) break;
+        if (fds[0].revents & (POLLERR | POLLHUP)) break;
+
+        pthread_mutex_lock(&g_lock);
+        bool changed = false;
+        while (XPending(g_display)) {
+            XEvent event;
+            XNextEvent(g_display, &event);
+            changed |= apply_event(&event);
+        }
+        if (changed) {
+            publish_layout();
+        }
+        pthread_mutex_unlock(&g_lock);
+        layout_reclaim_collect(free_layout_block);
+    }
+    return NULL;
+}
+
+// Xft.dpi from the RESOURCE_MANAGER property, 0 if unset
+static float query_xft_dpi(void) {
+    const char* resources = XResourceManagerString(g_display);
     if (!resources) {
-        return "Unknown";
+        return 0.0f;
     }
-    
-    XRROutputInfo* output_info = XRRGetOutputInfo(g_display, resources, output);
-    if (!output_info) {
-        XRRFreeScreenResources(resources);
-        return "Unknown";
+
+    XrmInitialize();
+    XrmDatabase db = XrmGetStringDatabase(resources);
+    if (!db) {
+        return 0.0f;
     }
-    
-    if (output_info->name && output_info->name[0] != '\0') {
-        strncpy(name_buffer, output_info->name, sizeof(name_buffer) - 1);
-        name_buffer[sizeof(name_buffer) - 1] = '\0';
-    } else {
-        strncpy(name_buffer, "Unknown", sizeof(name_buffer) - 1);
-        name_buffer[sizeof(name_buffer) - 1] = '\0';
+
+    float dpi = 0.0f;
+    char* type = NULL;
+    XrmValue value;
+    if (XrmGetResource(db, "Xft.dpi", "Xft.Dpi", &type, &value) && value.addr) {
+        dpi = strtof(value.addr, NULL);
+        if (dpi < 24.0f || dpi > 1200.0f) dpi = 0.0f;
     }
-    
-    XRRFreeOutputInfo(output_info);
-    XRRFreeScreenResources(resources);
-    
-    return name_buffer[0] ? name_buffer : "Unknown";
+    XrmDestroyDatabase(db);
+    return dpi;
 }
 
-static float get_output_scale_factor(RROutput output) {
-    // Simplified scale factor detection
-    // In a real implementation, you'd query the actual DPI/scale settings
-    return 1.0f;
+// Physical DPI from the output's reported size in millimetres. Falls back to
+// Xft.dpi (then 96) when the size is missing or implausible, which is common
+// for projectors and TVs that report 0 or an aspect ratio (16x9 "mm").
+static float get_output_dpi(const OutputState* output, const CrtcState* crtc) {
+    float fallback = g_xft_dpi > 0.0f ? g_xft_dpi : BASE_DPI;
+    unsigned long mm_w = output->mm_width, mm_h = output->mm_height;
+    if (crtc->rotation & (RR_Rotate_90 | RR_Rotate_270)) {
+        unsigned long t = mm_w; mm_w = mm_h; mm_h = t;
+    }
+    if (mm_w < 50 || mm_h < 50) {
+        return fallback;
+    }
+
+    float dpi_x = (float)crtc->width * 25.4f / (float)mm_w;
+    float dpi_y = (float)crtc->height * 25.4f / (float)mm_h;
+    float dpi = (dpi_x + dpi_y) * 0.5f;
+    if (dpi < 48.0f || dpi > 600.0f) {
+        return fallback;
+    }
+    return dpi;
 }
 
 // C-friendly getters for Swift bridge
@@ -315,8 +566,10 @@ void dm_get_display_info_c(int32_t index,
                            int32_t* xOut, int32_t* yOut,
                            int32_t* wOut, int32_t* hOut,
                            bool* isPrimaryOut, float* scaleOut) {
-    if (index < 0 || index >= g_display_count) return;
-    const DisplayInfo* d = &g_displays[index];
+    layout_reclaim_read_begin();
+    const DisplayLayout* layout = display_manager_get_layout();
+    if (index < 0 || index >= layout->count) { layout_reclaim_read_end(); return; }
+    const DisplayInfo* d = &layout->displays[index];
     if (idOut && idOutSize > 0) { snprintf(idOut, idOutSize, "%s", d->id); }
     if (nameOut && nameOutSize > 0) { snprintf(nameOut, nameOutSize, "%s", d->name); }
     if (xOut) *xOut = d->x;
@@ -325,6 +578,7 @@ void dm_get_display_info_c(int32_t index,
     if (hOut) *hOut = d->height;
     if (isPrimaryOut) *isPrimaryOut = d->isPrimary;
     if (scaleOut) *scaleOut = d->scaleFactor;
+    layout_reclaim_read_end();
 }
 
 void dm_get_primary_info_c(char* idOut, int idOutSize,
@@ -332,8 +586,10 @@ void dm_get_primary_info_c(char* idOut, int idOutSize,
                            int32_t* xOut, int32_t* yOut,
                            int32_t* wOut, int32_t* hOut,
                            bool* isPrimaryOut, float* scaleOut) {
-    if (!g_primary_display) return;
-    const DisplayInfo* d = g_primary_display;
+    layout_reclaim_read_begin();
+    const DisplayLayout* layout = display_manager_get_layout();
+    if (layout->primary < 0) { layout_reclaim_read_end(); return; }
+    const DisplayInfo* d = &layout->displays[layout->primary];
     if (idOut && idOutSize > 0) { snprintf(idOut, idOutSize, "%s", d->id); }
     if (nameOut && nameOutSize > 0) { snprintf(nameOut, nameOutSize, "%s", d->name); }
     if (xOut) *xOut = d->x;
@@ -342,6 +598,7 @@ void dm_get_primary_info_c(char* idOut, int idOutSize,
     if (hOut) *hOut = d->height;
     if (isPrimaryOut) *isPrimaryOut = d->isPrimary;
     if (scaleOut) *scaleOut = d->scaleFactor;
+    layout_reclaim_read_end();
 }
 
 int dm_get_display_at_c(int32_t x, int32_t y,
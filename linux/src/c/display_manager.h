@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "display_index.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,11 +18,41 @@ typedef struct {
     float scaleFactor;
 } DisplayInfo;
 
+// Immutable snapshot of the display arrangement.
+// The RandR watcher thread rebuilds it when outputs change and publishes it
+// with an atomic pointer swap. Threads that keep a layout between calls (the
+// fusion loop, the GUI renderer) register as readers and report each
+// generation they switch to; a replaced layout is freed only once every
+// registered reader has moved past it, however long one of them stalls.
+typedef struct {
+    uint64_t generation;
+    int32_t count;
+    int32_t primary; // index into displays, -1 if none
+    int32_t total_x, total_y, total_width, total_height;
+    const DisplayInfo* displays;
+    const float* gains; // per-display motion gain (display DPI / reference DPI)
+    DisplayIndex index; // spatial index over displays, built once per layout
+} DisplayLayout;
+
 // Display manager functions
 void display_manager_init(void);
 void display_manager_cleanup(void);
 void display_manager_update_displays(void);
 
+// Current layout snapshot (never NULL; falls back to a single 1920x1080 display)
+const DisplayLayout* display_manager_get_layout(void);
+// Register before the first display_manager_get_layout() whose result is
+// kept; returns -1 when no reader slot is free
+int display_manager_register_reader(void);
+void display_manager_unregister_reader(int reader);
+// The reader no longer references any layout older than `generation`
+void display_manager_layout_seen(int reader, uint64_t generation);
+
+// Layout queries (no string copies): index of the display containing (x, y)
+// or -1, and clamping onto the nearest display (returns its index)
+int32_t display_manager_hit_test(const DisplayLayout* layout, int32_t x, int32_t y);
+int32_t display_manager_clamp_to_layout(const DisplayLayout* layout, int32_t* x, int32_t* y);
+
 // Get display information
 int32_t display_manager_get_display_count(void);
 void display_manager_get_display_info(int32_t index, DisplayInfo* info);
@@ -1,4 +1,5 @@
 #include "evdev_manager.h"
+#include "metrics.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,16 +12,23 @@
 #include <X11/extensions/XTest.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/ioctl.h>
 
 // Maximum number of devices
 #define MAX_DEVICES 16
+// "/dev/input/" plus any directory entry name
+#define DEVICE_PATH_SIZE (sizeof("/dev/input/") + sizeof(((struct dirent*)0)->d_name))
 
 // Device structure
 typedef struct {
     int fd;
-    char path[256];
+    char path[DEVICE_PATH_SIZE];
     uint32_t device_id;
     bool active;
+    bool hires_wheel;       // reports REL_WHEEL_HI_RES; REL_WHEEL is then redundant
+    bool hires_hwheel;
+    uint8_t buttons;        // MOUSE_BUTTON_* currently held
+    bool dropping;          // the kernel dropped events: skip to the next SYN_REPORT, then resync
 } mouse_device_t;
 
 // evdev manager structure
@@ -28,6 +36,7 @@ struct evdev_manager {
     mouse_device_t devices[MAX_DEVICES];
     int device_count;
     mouse_input_callback_t callback;
+    mouse_removed_callback_t removed_callback;
     Display* display;
     bool initialized;
 };
@@ -41,7 +50,13 @@ static bool find_mouse_devices(evdev_manager_t* manager);
 static bool open_device(evdev_manager_t* manager, const char* path);
 static void close_device(mouse_device_t* device);
 static void handle_device_input(evdev_manager_t* manager, int device_index);
-static bool is_mouse_device(const char* path);
+static bool is_event_node(const char* name);
+
+// Bit `bit` of an EVIOCGBIT bitmap
+static inline bool has_bit(const unsigned long* bits, unsigned int bit) {
+    size_t word_bits = 8 * sizeof(unsigned long);
+    return (bits[bit / word_bits] >> (bit % word_bits)) & 1;
+}
 
 evdev_manager_t* evdev_manager_create(void) {
     evdev_manager_t* manager = calloc(1, sizeof(evdev_manager_t));
@@ -57,6 +72,9 @@ evdev_manager_t* evdev_manager_create(void) {
         return NULL;
     }
     
+    // The first manager drives cursor injection
+    if (!g_manager) g_manager = manager;
+    
     return manager;
 }
 
@@ -68,6 +86,8 @@ void evdev_manager_destroy(evdev_manager_t* manager) {
         close_device(&manager->devices[i]);
     }
     
+    if (g_manager == manager) g_manager = NULL;
+    
     // Close X11 display
     if (manager->display) {
         XCloseDisplay(manager->display);
@@ -138,6 +158,38 @@ void evdev_manager_start_loop(evdev_manager_t* manager) {
     }
 }
 
+int evdev_manager_get_fds(evdev_manager_t* manager, int* fds, int max_fds) {
+    if (!manager || !manager->initialized) return 0;
+    
+    int count = 0;
+    for (int i = 0; i < manager->device_count && count < max_fds; i++) {
+        if (manager->devices[i].active) {
+            fds[count++] = manager->devices[i].fd;
+        }
+    }
+    return count;
+}
+
+bool evdev_manager_handle_fd(evdev_manager_t* manager, int fd) {
+    if (!manager) return false;
+    
+    for (int i = 0; i < manager->device_count; i++) {
+        if (manager->devices[i].active && manager->devices[i].fd == fd) {
+            errno = 0;
+            handle_device_input(manager, i);
+            // An unplugged device stays readable with ENODEV; stop polling it
+            if (errno == ENODEV) {
+                printf("🔌 Device removed: %s (ID: %u)\n", manager->devices[i].path, manager->devices[i].device_id);
+                close_device(&manager->devices[i]);
+                if (manager->removed_callback) manager->removed_callback(manager->devices[i].device_id);
+                return false;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
 void evdev_manager_set_callback(evdev_manager_t* manager, mouse_input_callback_t callback) {
     if (manager) {
         manager->callback = callback;
@@ -145,6 +197,12 @@ void evdev_manager_set_callback(evdev_manager_t* manager, mouse_input_callback_t
     }
 }
 
+void evdev_manager_set_removed_callback(evdev_manager_t* manager, mouse_removed_callback_t callback) {
+    if (manager) {
+        manager->removed_callback = callback;
+    }
+}
+
 int32_t evdev_manager_get_screen_width(void) {
     Display* display = XOpenDisplay(NULL);
     if (!display) return 1920; // Default fallback
@@ -163,10 +221,53 @@ int32_t evdev_manager_get_screen_height(void) {
     return height;
 }
 
+// X core buttons: 1 left, 2 middle, 3 right; 4/5 scroll up/down, 6/7 left/right
+static unsigned int x_button(uint8_t button) {
+    if (button == MOUSE_BUTTON_LEFT) return 1;
+    if (button == MOUSE_BUTTON_MIDDLE) return 2;
+    if (button == MOUSE_BUTTON_RIGHT) return 3;
+    return 0;
+}
+
+static bool fake_clicks(Display* display, unsigned int button, int32_t count) {
+    bool ok = true;
+    for (int32_t i = 0; i < count; i++) {
+        ok = XTestFakeButtonEvent(display, button, True, CurrentTime) &&
+             XTestFakeButtonEvent(display, button, False, CurrentTime) && ok;
+    }
+    return ok;
+}
+
+void evdev_manager_inject_frame(int32_t x, int32_t y, const mouse_button_event_t* buttons, int button_count,
+                                int32_t wheel_steps, int32_t hwheel_steps) {
+    if (!g_manager || !g_manager->display) {
+        metrics_count(METRIC_INJECTION_FAILURES, 1);
+        return;
+    }
+    Display* display = g_manager->display;
+    bool ok = XTestFakeMotionEvent(display, 0, x, y, CurrentTime);
+    for (int i = 0; i < button_count; i++) {
+        unsigned int b = x_button(buttons[i].button);
+        if (b) ok = XTestFakeButtonEvent(display, b, buttons[i].pressed ? True : False, CurrentTime) && ok;
+    }
+    // A scroll detent is a click of the wheel button in the core protocol
+    ok = fake_clicks(display, wheel_steps > 0 ? 4 : 5, wheel_steps > 0 ? wheel_steps : -wheel_steps) && ok;
+    ok = fake_clicks(display, hwheel_steps > 0 ? 7 : 6, hwheel_steps > 0 ? hwheel_steps : -hwheel_steps) && ok;
+    XFlush(display);
+    if (button_count > 0) metrics_count(METRIC_BUTTON_EVENTS, (uint64_t)button_count);
+    if (wheel_steps != 0 || hwheel_steps != 0) {
+        metrics_count(METRIC_SCROLL_STEPS, (uint64_t)(llabs(wheel_steps) + llabs(hwheel_steps)));
+    }
+    metrics_count(ok ? METRIC_INJECTIONS : METRIC_INJECTION_FAILURES, 1);
+}
+
 void evdev_manager_set_cursor_position(int32_t x, int32_t y) {
-    if (g_manager && g_manager->display) {
-        XTestFakeMotionEvent(g_manager->display, 0, x, y, CurrentTime);
+    if (g_manager && g_manager->display &&
+        XTestFakeMotionEvent(g_manager->display, 0, x, y, CurrentTime)) {
         XFlush(g_manager->display);
+        metrics_count(METRIC_INJECTIONS, 1);
+    } else {
+        metrics_count(METRIC_INJECTION_FAILURES, 1);
     }
 }
 
@@ -179,8 +280,8 @@ bool evdev_manager_has_permissions(void) {
     bool has_access = false;
     
     while ((entry = readdir(dir)) != NULL) {
-        if (strncmp(entry->d_name, "mouse", 5) == 0 || strncmp(entry->d_name, "event", 5) == 0) {
-            char path[256];
+        if (is_event_node(entry->d_name)) {
+            char path[DEVICE_PATH_SIZE];
             snprintf(path, sizeof(path), "/dev/input/%s", entry->d_name);
             
             int fd = open(path, O_RDONLY);
@@ -205,40 +306,53 @@ static bool find_mouse_devices(evdev_manager_t* manager) {
     }
     
     struct dirent* entry;
-    int device_count = 0;
     
-    while ((entry = readdir(dir)) != NULL && device_count < MAX_DEVICES) {
-        if (is_mouse_device(entry->d_name)) {
-            char path[256];
+    // open_device fills the next slot and counts it; only evdev nodes are
+    // tried (mouseN and /dev/input/mice repeat the same motion in PS/2 form)
+    while ((entry = readdir(dir)) != NULL && manager->device_count < MAX_DEVICES) {
+        if (is_event_node(entry->d_name)) {
+            char path[DEVICE_PATH_SIZE];
             snprintf(path, sizeof(path), "/dev/input/%s", entry->d_name);
-            
-            if (open_device(manager, path)) {
-                device_count++;
-            }
+            open_device(manager, path);
         }
     }
     
     closedir(dir);
-    manager->device_count = device_count;
     
-    return device_count > 0;
+    return manager->device_count > 0;
 }
 
+// Opens an evdev node and takes the next slot if it is a pointer with
+// relative X/Y motion; keyboards, touchpads, power buttons etc. are closed
 static bool open_device(evdev_manager_t* manager, const char* path) {
     int fd = open(path, O_RDONLY | O_NONBLOCK);
     if (fd < 0) {
         return false;
     }
     
+    unsigned long rel_bits[(REL_MAX + 8 * sizeof(unsigned long)) / (8 * sizeof(unsigned long))] = { 0 };
+    if (ioctl(fd, EVIOCGBIT(EV_REL, sizeof(rel_bits)), rel_bits) < 0 ||
+        !has_bit(rel_bits, REL_X) || !has_bit(rel_bits, REL_Y)) {
+        close(fd);
+        return false;
+    }
+    
     int device_index = manager->device_count;
     mouse_device_t* device = &manager->devices[device_index];
     
     device->fd = fd;
-    strncpy(device->path, path, sizeof(device->path) - 1);
-    device->path[sizeof(device->path) - 1] = '\0';
+    snprintf(device->path, sizeof(device->path), "%s", path);
     device->device_id = device_index;
     device->active = true;
+    device->buttons = 0;
+    device->dropping = false;
+    device->hires_wheel = device->hires_hwheel = false;
+#ifdef REL_WHEEL_HI_RES
+    device->hires_wheel = has_bit(rel_bits, REL_WHEEL_HI_RES);
+    device->hires_hwheel = has_bit(rel_bits, REL_HWHEEL_HI_RES);
+#endif
     
+    manager->device_count++;
     printf("✅ Opened device: %s (ID: %u)\n", path, device->device_id);
     
     return true;
@@ -252,31 +366,99 @@ static void close_device(mouse_device_t* device) {
     }
 }
 
+static uint8_t button_bit(uint16_t code) {
+    if (code == BTN_LEFT) return MOUSE_BUTTON_LEFT;
+    if (code == BTN_RIGHT) return MOUSE_BUTTON_RIGHT;
+    if (code == BTN_MIDDLE) return MOUSE_BUTTON_MIDDLE;
+    return 0;
+}
+
+static void add_rel(const mouse_device_t* device, mouse_frame_t* frame, uint16_t code, int32_t value) {
+    switch (code) {
+    case REL_X: frame->dx += value; break;
+    case REL_Y: frame->dy += value; break;
+    case REL_WHEEL: if (!device->hires_wheel) frame->wheel += value * MOUSE_WHEEL_UNITS_PER_DETENT; break;
+    case REL_HWHEEL: if (!device->hires_hwheel) frame->hwheel += value * MOUSE_WHEEL_UNITS_PER_DETENT; break;
+#ifdef REL_WHEEL_HI_RES
+    case REL_WHEEL_HI_RES: frame->wheel += value; break;
+    case REL_HWHEEL_HI_RES: frame->hwheel += value; break;
+#endif
+    default: break;
+    }
+}
+
+static void emit_frame(evdev_manager_t* manager, mouse_device_t* device, mouse_frame_t* frame) {
+    frame->buttons = device->buttons;
+    bool empty = frame->dx == 0 && frame->dy == 0 && frame->wheel == 0 && frame->hwheel == 0 && frame->changed == 0;
+    if (!empty && manager->callback) {
+        manager->callback(device->device_id, frame);
+    }
+    *frame = (mouse_frame_t){ 0 };
+}
+
+// After SYN_DROPPED the button transitions in the gap are unknown; read the
+// held buttons from the kernel and report whatever differs from what was
+// last delivered
+static void resync_buttons(evdev_manager_t* manager, mouse_device_t* device) {
+    unsigned long key_bits[(KEY_MAX + 8 * sizeof(unsigned long)) / (8 * sizeof(unsigned long))] = { 0 };
+    if (ioctl(device->fd, EVIOCGKEY(sizeof(key_bits)), key_bits) < 0) return;
+    static const uint16_t codes[MOUSE_BUTTON_COUNT] = { BTN_LEFT, BTN_RIGHT, BTN_MIDDLE };
+    size_t word_bits = 8 * sizeof(unsigned long);
+    uint8_t held = 0;
+    for (int i = 0; i < MOUSE_BUTTON_COUNT; i++) {
+        if ((key_bits[codes[i] / word_bits] >> (codes[i] % word_bits)) & 1) held |= button_bit(codes[i]);
+    }
+    mouse_frame_t frame = { 0 };
+    frame.changed = held ^ device->buttons;
+    device->buttons = held;
+    emit_frame(manager, device, &frame);
+}
+
 static void handle_device_input(evdev_manager_t* manager, int device_index) {
     mouse_device_t* device = &manager->devices[device_index];
-    struct input_event event;
+    struct input_event events[64];
+    mouse_frame_t frame = { 0 };
+    ssize_t got;
     
-    while (read(device->fd, &event, sizeof(event)) == sizeof(event)) {
-        if (event.type == EV_REL) {
-            int32_t delta_x = 0, delta_y = 0;
-            
-            if (event.code == REL_X) {
-                delta_x = event.value;
-            } else if (event.code == REL_Y) {
-                delta_y = event.value;
-            }
-            
-            if (delta_x != 0 || delta_y != 0) {
-                if (manager->callback) {
-                    manager->callback(device->device_id, delta_x, delta_y);
+    // The kernel reports the axes and buttons of one frame as separate
+    // events closed by SYN_REPORT; deliver them as one frame
+    while ((got = read(device->fd, events, sizeof(events))) >= (ssize_t)sizeof(events[0])) {
+        size_t count = (size_t)got / sizeof(events[0]);
+        for (size_t i = 0; i < count; i++) {
+            const struct input_event* event = &events[i];
+            if (device->dropping) {
+                // Events up to the next SYN_REPORT belong to a torn frame
+                if (event->type == EV_SYN && event->code == SYN_REPORT) {
+                    device->dropping = false;
+                    resync_buttons(manager, device);
+                }
+            } else if (event->type == EV_SYN && event->code == SYN_DROPPED) {
+                // Undo the transitions of the torn frame; the resync reports the real state
+                device->buttons ^= frame.changed;
+                frame = (mouse_frame_t){ 0 };
+                device->dropping = true;
+            } else if (event->type == EV_REL) {
+                add_rel(device, &frame, event->code, event->value);
+            } else if (event->type == EV_KEY && event->value != 2) {
+                uint8_t bit = button_bit(event->code);
+                // A second transition of a button in one frame closes the frame early
+                if (bit && (frame.changed & bit)) emit_frame(manager, device, &frame);
+                if (bit && (((device->buttons & bit) != 0) != (event->value != 0))) {
+                    device->buttons ^= bit;
+                    frame.changed |= bit;
                 }
+            } else if (event->type == EV_SYN && event->code == SYN_REPORT) {
+                emit_frame(manager, device, &frame);
             }
         }
     }
+    
+    // A frame whose SYN_REPORT has not arrived yet still counts
+    emit_frame(manager, device, &frame);
 }
 
-static bool is_mouse_device(const char* name) {
-    return (strncmp(name, "mouse", 5) == 0 || strncmp(name, "event", 5) == 0);
+static bool is_event_node(const char* name) {
+    return strncmp(name, "event", 5) == 0;
 }
 
 // C interface implementation
@@ -3,12 +3,17 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "mouse_frame.h"
 
 // Linux evdev Manager for multi-mouse support
 typedef struct evdev_manager evdev_manager_t;
 
-// Mouse input callback type
-typedef void (*mouse_input_callback_t)(uint32_t device_id, int32_t delta_x, int32_t delta_y);
+// Mouse input callback type: one call per device frame (motion, wheel, buttons)
+typedef void (*mouse_input_callback_t)(uint32_t device_id, const mouse_frame_t* frame);
+
+// Device removal callback type: called once an unplugged device is closed,
+// so state it held (pressed buttons) can be released
+typedef void (*mouse_removed_callback_t)(uint32_t device_id);
 
 // Create evdev manager
 evdev_manager_t* evdev_manager_create(void);
@@ -22,9 +27,20 @@ bool evdev_manager_initialize(evdev_manager_t* manager);
 // Start the event loop
 void evdev_manager_start_loop(evdev_manager_t* manager);
 
+// Descriptors of the open devices, for callers that run their own poll loop
+// instead of evdev_manager_start_loop; returns how many were written
+int evdev_manager_get_fds(evdev_manager_t* manager, int* fds, int max_fds);
+
+// Read and dispatch pending input of the device behind fd (non-blocking).
+// Returns false once the device is gone; it is closed and no longer listed.
+bool evdev_manager_handle_fd(evdev_manager_t* manager, int fd);
+
 // Set mouse input callback
 void evdev_manager_set_callback(evdev_manager_t* manager, mouse_input_callback_t callback);
 
+// Set device removal callback
+void evdev_manager_set_removed_callback(evdev_manager_t* manager, mouse_removed_callback_t callback);
+
 // Get screen dimensions
 int32_t evdev_manager_get_screen_width(void);
 int32_t evdev_manager_get_screen_height(void);
@@ -32,6 +48,11 @@ int32_t evdev_manager_get_screen_height(void);
 // Set cursor position
 void evdev_manager_set_cursor_position(int32_t x, int32_t y);
 
+// Move the cursor, then replay button transitions and whole scroll detents
+// at the new position, all in one flush to the X server
+void evdev_manager_inject_frame(int32_t x, int32_t y, const mouse_button_event_t* buttons, int button_count,
+                                int32_t wheel_steps, int32_t hwheel_steps);
+
 // Check if running with proper permissions
 bool evdev_manager_has_permissions(void);
 
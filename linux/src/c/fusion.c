@@ -0,0 +1,222 @@
+#include "fusion.h"
+#include <math.h>
+#include <string.h>
+
+#define INDEX_MASK ((1u << FUSION_INDEX_BITS) - 1)
+// Physics mode: velocity damping per tick and speed cap in pixels per tick
+#define PHYSICS_DAMPING 0.12
+#define PHYSICS_MAX_SPEED 50.0
+
+static uint32_t mouse_home(uint32_t id) {
+    return (id * 0x9E3779B1u) >> (32 - FUSION_INDEX_BITS);
+}
+
+void fusion_init(fusion_t* f, const DisplayLayout* layout) {
+    memset(f, 0, sizeof(*f));
+    f->smoothing = 0.7; // similar to Swift
+    f->host_display = -1;
+    fusion_set_layout(f, layout);
+    f->host_x = layout->total_x + layout->total_width / 2;
+    f->host_y = layout->total_y + layout->total_height / 2;
+}
+
+void fusion_set_layout(fusion_t* f, const DisplayLayout* layout) {
+    f->layout = layout;
+    if (layout->generation == f->layout_generation) return;
+    f->layout_generation = layout->generation;
+    f->host_display = -1;
+    for (int i = 0; i < f->slots; i++) f->mice[i].display = -1;
+}
+
+fusion_mouse_t* fusion_get_mouse(fusion_t* f, uint32_t id, int64_t now_ms) {
+    uint32_t h = mouse_home(id);
+    for (; f->index[h]; h = (h + 1) & INDEX_MASK) {
+        fusion_mouse_t* m = &f->mice[f->index[h] - 1];
+        if (m->id == id) return m;
+    }
+    for (int i = 0; i < FUSION_MAX_MICE; i++) if (!f->mice[i].present) {
+        fusion_mouse_t* m = &f->mice[i];
+        f->index[h] = (uint16_t)(i + 1);
+        if (i >= f->slots) f->slots = i + 1;
+        f->count++;
+        memset(m, 0, sizeof(*m));
+        m->present = true;
+        m->id = id;
+        m->weight = 1.0;
+        m->pos_x = f->layout->total_x + f->layout->total_width / 2;
+        m->pos_y = f->layout->total_y + f->layout->total_height / 2;
+        m->display = -1;
+        m->last_activity_ms = now_ms;
+        return m;
+    }
+    return NULL;
+}
+
+static void push_button_event(fusion_t* f, uint8_t button, bool pressed) {
+    f->button_events[f->button_event_count++] = (mouse_button_event_t){ .button = button, .pressed = pressed };
+}
+
+static void arbitrate_button(fusion_t* f, uint32_t id, int b, bool pressed) {
+    uint8_t bit = (uint8_t)(1u << b);
+    if (pressed) {
+        // Presses never take the last slots, so every held button can
+        // always be released
+        if ((f->buttons & bit) || f->button_event_count > FUSION_MAX_BUTTON_EVENTS - MOUSE_BUTTON_COUNT - 1) return;
+        f->buttons |= bit;
+        f->button_owner[b] = id;
+        push_button_event(f, bit, true);
+    } else if ((f->buttons & bit) && f->button_owner[b] == id) {
+        f->buttons &= (uint8_t)~bit;
+        push_button_event(f, bit, false);
+    }
+}
+
+bool fusion_forget_mouse(fusion_t* f, uint32_t id) {
+    uint32_t h = mouse_home(id);
+    while (f->index[h] && f->mice[f->index[h] - 1].id != id) h = (h + 1) & INDEX_MASK;
+    if (!f->index[h]) return false;
+    for (int b = 0; b < MOUSE_BUTTON_COUNT; b++) arbitrate_button(f, id, b, false);
+    f->mice[f->index[h] - 1].present = false;
+    f->count--;
+    if (f->active_mouse == id) f->active_mouse = 0;
+    while (f->slots > 0 && !f->mice[f->slots - 1].present) f->slots--;
+    // Backward-shift deletion: pull later entries of the probe chain into the hole
+    uint32_t hole = h;
+    for (uint32_t j = (h + 1) & INDEX_MASK; f->index[j]; j = (j + 1) & INDEX_MASK) {
+        uint32_t home = mouse_home(f->mice[f->index[j] - 1].id);
+        bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (stays) continue;
+        f->index[hole] = f->index[j];
+        hole = j;
+    }
+    f->index[hole] = 0;
+    return true;
+}
+
+fusion_mouse_t* fusion_input(fusion_t* f, uint32_t id, int32_t dx, int32_t dy, int64_t now_ms) {
+    fusion_mouse_t* m = fusion_get_mouse(f, id, now_ms);
+    if (!m) return NULL;
+    m->delta_x += dx;
+    m->delta_y += dy;
+    m->last_activity_ms = now_ms;
+    return m;
+}
+
+fusion_mouse_t* fusion_input_frame(fusion_t* f, uint32_t id, const mouse_frame_t* frame, int64_t now_ms) {
+    fusion_mouse_t* m = fusion_input(f, id, frame->dx, frame->dy, now_ms);
+    if (!m) return NULL;
+    m->wheel += frame->wheel;
+    m->hwheel += frame->hwheel;
+    for (int b = 0; b < MOUSE_BUTTON_COUNT; b++) if (frame->changed & (1u << b)) {
+        bool pressed = (frame->buttons >> b) & 1;
+        m->buttons = (uint8_t)((m->buttons & ~(1u << b)) | ((unsigned)pressed << b));
+        arbitrate_button(f, id, b, pressed);
+    }
+    return m;
+}
+
+void fusion_clear_output(fusion_t* f) {
+    f->button_event_count = 0;
+    f->wheel_steps = f->hwheel_steps = 0;
+}
+
+// Whole detents of a hi-res scroll sum; the rest waits for the next tick
+static int32_t scroll_steps(int32_t* rem, int64_t units) {
+    int64_t total = units + *rem;
+    int64_t steps = total / MOUSE_WHEEL_UNITS_PER_DETENT;
+    *rem = (int32_t)(total - steps * MOUSE_WHEEL_UNITS_PER_DETENT);
+    return (int32_t)steps;
+}
+
+static void apply_scroll(fusion_t* f, const fusion_mouse_t* only) {
+    int64_t wheel = 0, hwheel = 0;
+    for (int i = 0; i < f->slots; i++) if (f->mice[i].present) {
+        fusion_mouse_t* m = &f->mice[i];
+        if (!only || m == only) { wheel += m->wheel; hwheel += m->hwheel; }
+        m->wheel = m->hwheel = 0;
+    }
+    f->wheel_steps += scroll_steps(&f->wheel_rem, wheel);
+    f->hwheel_steps += scroll_steps(&f->hwheel_rem, hwheel);
+}
+
+// DPI-normalizing gain of the display a position is on (precomputed per layout)
+static double display_gain(const DisplayLayout* layout, int32_t* display, int32_t x, int32_t y) {
+    if (*display < 0) *display = display_manager_hit_test(layout, x, y);
+    return *display >= 0 ? (double)layout->gains[*display] : 1.0;
+}
+
+static void update_weights(fusion_t* f, int64_t now_ms) {
+    for (int i = 0; i < f->slots; i++) if (f->mice[i].present) {
+        fusion_mouse_t* m = &f->mice[i];
+        if (now_ms - m->last_activity_ms > FUSION_ACTIVITY_TIMEOUT_MS) {
+            m->weight = m->weight * 0.9; if (m->weight < 0.1) m->weight = 0.1;
+        } else {
+            m->weight = m->weight * 1.1; if (m->weight > 2.0) m->weight = 2.0;
+        }
+    }
+}
+
+static void apply_deltas_individual(fusion_t* f, fusion_mouse_t* m) {
+    f->active_mouse = m->id;
+    double gain = display_gain(f->layout, &m->display, m->pos_x, m->pos_y);
+    double fx = (double)m->delta_x * gain + m->rem_x;
+    double fy = (double)m->delta_y * gain + m->rem_y;
+    int32_t mx = (int32_t)fx, my = (int32_t)fy;
+    m->rem_x = fx - mx; m->rem_y = fy - my;
+    m->pos_x += mx; m->pos_y += my;
+    m->delta_x = m->delta_y = 0;
+    // Clamp onto the nearest display, not just the bounding box
+    m->display = display_manager_clamp_to_layout(f->layout, &m->pos_x, &m->pos_y);
+    f->host_x = m->pos_x; f->host_y = m->pos_y;
+}
+
+static void apply_deltas_fused(fusion_t* f) {
+    double wx = 0.0, wy = 0.0, tw = 0.0;
+    for (int i = 0; i < f->slots; i++) if (f->mice[i].present) {
+        wx += (double)f->mice[i].delta_x * f->mice[i].weight;
+        wy += (double)f->mice[i].delta_y * f->mice[i].weight;
+        tw += f->mice[i].weight;
+    }
+    if (tw > 0.0) {
+        double gain = display_gain(f->layout, &f->host_display, f->host_x, f->host_y);
+        double avgx = wx / tw * gain;
+        double avgy = wy / tw * gain;
+        if (f->physics) {
+            f->velocity_x = (1.0 - PHYSICS_DAMPING) * f->velocity_x + avgx;
+            f->velocity_y = (1.0 - PHYSICS_DAMPING) * f->velocity_y + avgy;
+            double speed = hypot(f->velocity_x, f->velocity_y);
+            if (speed > PHYSICS_MAX_SPEED) {
+                f->velocity_x *= PHYSICS_MAX_SPEED / speed;
+                f->velocity_y *= PHYSICS_MAX_SPEED / speed;
+            }
+            double fx = f->velocity_x + f->host_rem_x;
+            double fy = f->velocity_y + f->host_rem_y;
+            int32_t mx = (int32_t)fx, my = (int32_t)fy;
+            f->host_rem_x = fx - mx; f->host_rem_y = fy - my;
+            f->host_x += mx; f->host_y += my;
+        } else {
+            double new_x = (double)f->host_x + avgx;
+            double new_y = (double)f->host_y + avgy;
+            f->host_x = (int32_t)((1.0 - f->smoothing) * (double)f->host_x + f->smoothing * new_x);
+            f->host_y = (int32_t)((1.0 - f->smoothing) * (double)f->host_y + f->smoothing * new_y);
+        }
+    }
+    for (int i = 0; i < f->slots; i++) if (f->mice[i].present) { f->mice[i].delta_x = 0; f->mice[i].delta_y = 0; }
+    f->host_display = display_manager_clamp_to_layout(f->layout, &f->host_x, &f->host_y);
+}
+
+void fusion_tick(fusion_t* f, int64_t now_ms) {
+    update_weights(f, now_ms);
+    if (f->individual) {
+        // pick most recently active mouse as active
+        fusion_mouse_t* active = NULL;
+        for (int i = 0; i < f->slots; i++) if (f->mice[i].present) {
+            if (!active || f->mice[i].last_activity_ms > active->last_activity_ms) active = &f->mice[i];
+        }
+        if (active) apply_deltas_individual(f, active);
+        apply_scroll(f, active);
+    } else {
+        apply_deltas_fused(f);
+        apply_scroll(f, NULL);
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "display_manager.h"
+#include "mouse_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Multi-mouse fusion engine: per-mouse state, activity weights and the
+// fused (or individually driven) host cursor over a display layout.
+//
+// Pure computation: no X11, clocks, threads or I/O. Callers pass the time
+// and own the layout, so the daemon and the Node addon run identical code.
+
+// Every remote client (NET_INGEST_MAX_CLIENTS) plus local and injected devices
+#define FUSION_MAX_MICE 4608
+// id -> slot index size, kept below ~60% full
+#define FUSION_INDEX_BITS 13
+#define FUSION_ACTIVITY_TIMEOUT_MS 2000
+// Button transitions held for the caller between ticks
+#define FUSION_MAX_BUTTON_EVENTS 64
+
+typedef struct {
+    uint32_t id;
+    int32_t pos_x;
+    int32_t pos_y;
+    int32_t delta_x;
+    int32_t delta_y;
+    int32_t wheel, hwheel;  // hi-res scroll units since the last tick
+    uint8_t buttons;        // MOUSE_BUTTON_* the device holds
+    double  weight;
+    double  rem_x, rem_y;   // sub-pixel motion carried between ticks
+    int32_t display;        // display index in the layout, -1 if unknown
+    int64_t last_activity_ms;
+    bool    present;
+} fusion_mouse_t;
+
+
+typedef struct {
+    fusion_mouse_t mice[FUSION_MAX_MICE];
+    uint16_t index[1u << FUSION_INDEX_BITS];   // slot + 1, 0 = empty
+    int slots;                                 // slots in use lie below this
+    int count;
+    bool individual;
+    bool physics;               // damped velocity instead of smoothing (fused mode)
+    uint32_t active_mouse;
+    int32_t host_x, host_y;
+    int32_t host_display;       // -1 if unknown
+    double smoothing;
+    double velocity_x, velocity_y;
+    double host_rem_x, host_rem_y;
+    const DisplayLayout* layout;
+    uint64_t layout_generation;
+    // Click arbitration: a host button is held by the mouse that pressed it
+    // first and released only by that mouse (or when it is forgotten)
+    uint8_t buttons;
+    uint32_t button_owner[MOUSE_BUTTON_COUNT];
+    int32_t wheel_rem, hwheel_rem;
+    // Output for the caller to inject and then clear with fusion_clear_output
+    mouse_button_event_t button_events[FUSION_MAX_BUTTON_EVENTS];
+    int button_event_count;
+    int32_t wheel_steps, hwheel_steps;  // whole detents
+} fusion_t;
+
+// The engine is large (keep it static or on the heap); layout must outlive it
+// or be replaced with fusion_set_layout
+void fusion_init(fusion_t* f, const DisplayLayout* layout);
+// Switch layouts; display indices from an older generation are re-resolved lazily
+void fusion_set_layout(fusion_t* f, const DisplayLayout* layout);
+
+// Existing mouse, or a new one at the layout centre; NULL when the table is full
+fusion_mouse_t* fusion_get_mouse(fusion_t* f, uint32_t id, int64_t now_ms);
+// Drop a mouse and reuse its slot; false if it was unknown
+bool fusion_forget_mouse(fusion_t* f, uint32_t id);
+
+// Accumulate relative motion for the next tick
+fusion_mouse_t* fusion_input(fusion_t* f, uint32_t id, int32_t dx, int32_t dy, int64_t now_ms);
+// Motion and scroll as fusion_input; button transitions are arbitrated at
+// once and queued in button_events in the order they arrive
+fusion_mouse_t* fusion_input_frame(fusion_t* f, uint32_t id, const mouse_frame_t* frame, int64_t now_ms);
+
+// One tick: update activity weights, then move the fused cursor, or in
+// individual mode the most recently active mouse (which the host follows).
+// Scroll is summed over all mice in fused mode and taken from the active
+// mouse in individual mode, then added to wheel_steps/hwheel_steps in whole
+// detents; the remainder carries over.
+void fusion_tick(fusion_t* f, int64_t now_ms);
+// The caller injected button_events and the scroll steps
+void fusion_clear_output(fusion_t* f);
+
+#ifdef __cplusplus
+}
+#endif
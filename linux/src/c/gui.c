@@ -2,8 +2,35 @@
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include "seqlock.h"
+#include "display_manager.h"
+#include "metrics.h"
+
+#define GRID_SPACING 50
+#define CROSS_ARM 12
+// Text overlay area (two lines at baseline 20 and 40)
+#define TEXT_X 10
+#define TEXT_W 400
+#define TEXT_H 48
+#define VIEW_MARGIN 16
+#define MAX_GUI_DISPLAYS 64
+// More damage rectangles than this collapse into one full-window copy
+#define MAX_DAMAGE 32
+// A mouse counts as active if it moved within this window
+#define ACTIVE_WINDOW_MS 2000
+
+// Marker styles, one batched fill request each
+enum { MARK_IDLE, MARK_ACTIVE, MARK_SELECTED, MARK_STYLES };
+static const unsigned long k_mark_colors[MARK_STYLES] = { 0xAAAAAA, 0x2E7D32, 0xC62828 };
 
 static Display* s_dpy = NULL;
 static int s_screen = 0;
@@ -14,10 +41,69 @@ static int s_h = 600;
 static char s_mode_text[128] = "";
 static char s_status_text[256] = "";
 
+// Overlay text is set from other threads; the renderer copies it under
+// s_text_lock only when s_text_version moved
+static pthread_mutex_t s_text_lock = PTHREAD_MUTEX_INITIALIZER;
+static char s_shared_mode_text[128] = "";
+static char s_shared_status_text[256] = "";
+static atomic_uint s_text_version = 0;
+static unsigned s_seen_text_version = 0;
+
+// Latest-value mailbox between the fusion loop and the render thread
+static seqlock_t s_snap_lock;
+static GuiSnapshot s_snap;
+static GuiSnapshot s_frame; // render thread's private copy
+
+static pthread_t s_thread;
+static atomic_bool s_thread_running = false;
+static int s_frame_interval_ms = 16;
+static int s_wake_pipe[2] = { -1, -1 };
+
+// Off-screen rendering: s_grid caches the static background (rebuilt on
+// resize), s_back holds the composed frame. Only damaged rectangles are
+// restored from s_grid, redrawn and copied to the window.
+static Pixmap s_grid = 0;
+static Pixmap s_back = 0;
+static int s_buf_w = 0;
+static int s_buf_h = 0;
+static XRectangle s_cross = { 0, 0, 0, 0 }; // last drawn crosshair bounds
+static int s_last_x = -1;
+static int s_last_y = -1;
+static bool s_text_dirty = true;
+static bool s_full_redraw = true;
+
+// Display arrangement copied out of the published layout, so the RCU
+// snapshot is never held across X calls
+typedef struct {
+    int32_t x, y, width, height;
+    bool primary;
+    char name[32];
+} GuiDisplay;
+static GuiDisplay s_displays[MAX_GUI_DISPLAYS];
+static int s_display_count = 0;
+static uint64_t s_layout_generation = UINT64_MAX;
+// Reader slot that keeps the layout being copied from being freed
+static int s_layout_reader = -1;
+static int32_t s_total_x = 0, s_total_y = 0, s_total_w = 1920, s_total_h = 1080;
+
+// Screen -> window mapping (recomputed on resize or layout change)
+static double s_scale = 1.0;
+static int s_off_x = 0, s_off_y = 0;
+
+// Mouse markers as drawn last frame, in window coordinates
+typedef struct {
+    short x, y;
+    unsigned short r;
+    unsigned short style;
+} Mark;
+static Mark s_marks[GUI_MAX_MICE];
+static int s_mark_count = 0;
+
 int gui_init(int width, int height, const char* title) {
     if (s_dpy) return 1;
     s_dpy = XOpenDisplay(NULL);
     if (!s_dpy) return 0;
+    s_layout_reader = display_manager_register_reader();
     s_screen = DefaultScreen(s_dpy);
     s_w = width > 0 ? width : 800;
     s_h = height > 0 ? height : 600;
@@ -29,68 +115,378 @@ int gui_init(int width, int height, const char* title) {
     );
     XStoreName(s_dpy, s_win, title ? title : "3 Blind Mice");
     XSelectInput(s_dpy, s_win, ExposureMask | KeyPressMask | StructureNotifyMask);
+    // The window is always repainted from the back buffer; skip server-side clears
+    XSetWindowBackgroundPixmap(s_dpy, s_win, None);
     XMapWindow(s_dpy, s_win);
     s_gc = XCreateGC(s_dpy, s_win, 0, NULL);
     XSetForeground(s_dpy, s_gc, BlackPixel(s_dpy, s_screen));
     return 1;
 }
 
-static void draw_scene(double host_x, double host_y) {
+// Pick up a new display layout; the static layer is rebuilt when it changes
+static void sync_layout(void) {
+    const DisplayLayout* layout = display_manager_get_layout();
+    if (layout->generation == s_layout_generation) return;
+    s_layout_generation = layout->generation;
+    s_display_count = layout->count < MAX_GUI_DISPLAYS ? layout->count : MAX_GUI_DISPLAYS;
+    for (int i = 0; i < s_display_count; i++) {
+        const DisplayInfo* d = &layout->displays[i];
+        s_displays[i] = (GuiDisplay){ d->x, d->y, d->width, d->height, d->isPrimary, "" };
+        // Labels keep the start of long output names
+        size_t name_len = strnlen(d->name, sizeof(s_displays[i].name) - 1);
+        memcpy(s_displays[i].name, d->name, name_len);
+        s_displays[i].name[name_len] = '\0';
+    }
+    s_total_x = layout->total_x;
+    s_total_y = layout->total_y;
+    s_total_w = layout->total_width > 0 ? layout->total_width : 1;
+    s_total_h = layout->total_height > 0 ? layout->total_height : 1;
+    s_buf_w = s_buf_h = 0; // force static layer rebuild
+    // Nothing older than this layout is referenced any more
+    display_manager_layout_seen(s_layout_reader, layout->generation);
+}
+
+// Fit the layout's bounding box below the text area, preserving aspect
+static void compute_view(void) {
+    int avail_w = s_w - 2 * VIEW_MARGIN;
+    int avail_h = s_h - TEXT_H - VIEW_MARGIN;
+    if (avail_w < 1) avail_w = 1;
+    if (avail_h < 1) avail_h = 1;
+    double sx = (double)avail_w / (double)s_total_w;
+    double sy = (double)avail_h / (double)s_total_h;
+    s_scale = sx < sy ? sx : sy;
+    s_off_x = VIEW_MARGIN + (avail_w - (int)(s_total_w * s_scale)) / 2;
+    s_off_y = TEXT_H + (avail_h - (int)(s_total_h * s_scale)) / 2;
+}
+
+static short to_win_x(double x) { return (short)(s_off_x + (x - s_total_x) * s_scale + 0.5); }
+static short to_win_y(double y) { return (short)(s_off_y + (y - s_total_y) * s_scale + 0.5); }
+
+// (Re)create the back buffer and the cached static layer (grid and display
+// arrangement) for the current window size and layout
+static void ensure_buffers(void) {
+    if (s_grid && s_buf_w == s_w && s_buf_h == s_h) return;
+    if (s_grid) { XFreePixmap(s_dpy, s_grid); s_grid = 0; }
+    if (s_back) { XFreePixmap(s_dpy, s_back); s_back = 0; }
+
+    unsigned int depth = (unsigned int)DefaultDepth(s_dpy, s_screen);
+    s_grid = XCreatePixmap(s_dpy, s_win, (unsigned int)s_w, (unsigned int)s_h, depth);
+    s_back = XCreatePixmap(s_dpy, s_win, (unsigned int)s_w, (unsigned int)s_h, depth);
+    s_buf_w = s_w;
+    s_buf_h = s_h;
+    compute_view();
+
+    XSetForeground(s_dpy, s_gc, WhitePixel(s_dpy, s_screen));
+    XFillRectangle(s_dpy, s_grid, s_gc, 0, 0, (unsigned int)s_w, (unsigned int)s_h);
+
+    // background grid, one request for all lines
+    int n = (s_w / GRID_SPACING + 1) + (s_h / GRID_SPACING + 1);
+    XSegment* segs = malloc((size_t)n * sizeof(XSegment));
+    if (segs) {
+        int k = 0;
+        for (int x = 0; x <= s_w; x += GRID_SPACING) segs[k++] = (XSegment){ (short)x, 0, (short)x, (short)s_h };
+        for (int y = 0; y <= s_h; y += GRID_SPACING) segs[k++] = (XSegment){ 0, (short)y, (short)s_w, (short)y };
+        XSetForeground(s_dpy, s_gc, 0xEEEEEE);
+        XDrawSegments(s_dpy, s_grid, s_gc, segs, k);
+        free(segs);
+    }
+
+    // display arrangement: fills and outlines batched, primary outlined twice as thick
+    XRectangle rects[MAX_GUI_DISPLAYS];
+    for (int i = 0; i < s_display_count; i++) {
+        const GuiDisplay* d = &s_displays[i];
+        short x0 = to_win_x(d->x), y0 = to_win_y(d->y);
+        short x1 = to_win_x((double)d->x + d->width), y1 = to_win_y((double)d->y + d->height);
+        rects[i] = (XRectangle){ x0, y0, (unsigned short)(x1 - x0 > 1 ? x1 - x0 - 1 : 1),
+                                 (unsigned short)(y1 - y0 > 1 ? y1 - y0 - 1 : 1) };
+    }
+    if (s_display_count > 0) {
+        XSetForeground(s_dpy, s_gc, 0xE3F2FD);
+        XFillRectangles(s_dpy, s_grid, s_gc, rects, s_display_count);
+        XSetForeground(s_dpy, s_gc, 0x90A4AE);
+        XDrawRectangles(s_dpy, s_grid, s_gc, rects, s_display_count);
+        XSetForeground(s_dpy, s_gc, 0x546E7A);
+        for (int i = 0; i < s_display_count; i++) {
+            const GuiDisplay* d = &s_displays[i];
+            if (d->primary) {
+                XSetLineAttributes(s_dpy, s_gc, 2, LineSolid, CapButt, JoinMiter);
+                XDrawRectangles(s_dpy, s_grid, s_gc, &rects[i], 1);
+                XSetLineAttributes(s_dpy, s_gc, 0, LineSolid, CapButt, JoinMiter);
+            }
+            if (rects[i].width > 40 && rects[i].height > 16) {
+                XDrawString(s_dpy, s_grid, s_gc, rects[i].x + 4, rects[i].y + 14, d->name, (int)strlen(d->name));
+            }
+        }
+    }
+
+    s_cross = (XRectangle){ 0, 0, 0, 0 };
+    s_mark_count = 0;
+    s_full_redraw = true;
+}
+
+static XRectangle mark_bounds(const Mark* m) {
+    return (XRectangle){ (short)(m->x - m->r - 1), (short)(m->y - m->r - 1),
+                         (unsigned short)(2 * m->r + 3), (unsigned short)(2 * m->r + 3) };
+}
+
+static void add_damage(XRectangle* damage, int* ndamage, XRectangle rect) {
+    if (*ndamage < MAX_DAMAGE + 1) damage[(*ndamage)++] = rect;
+}
+
+static void draw_scene(const GuiSnapshot* snap) {
     if (!s_dpy || !s_win) return;
-    XClearWindow(s_dpy, s_win);
-    // background gradient-like grid
-    XSetForeground(s_dpy, s_gc, 0xEEEEEE);
-    int grid = 50;
-    for (int x = 0; x <= s_w; x += grid) XDrawLine(s_dpy, s_win, s_gc, x, 0, x, s_h);
-    for (int y = 0; y <= s_h; y += grid) XDrawLine(s_dpy, s_win, s_gc, 0, y, s_w, y);
-
-    // draw crosshair at scaled position
-    double cx = (host_x / 1920.0) * (double)s_w;
-    double cy = (host_y / 1080.0) * (double)s_h;
-    int x = (int)(cx + 0.5);
-    int y = (int)(cy + 0.5);
+    sync_layout();
+    ensure_buffers();
+
+    // fused crosshair in layout space
+    int x = to_win_x(snap->host_x);
+    int y = to_win_y(snap->host_y);
+
+    // one marker per present mouse: size from weight, color from activity
+    Mark marks[GUI_MAX_MICE];
+    int mark_count = snap->mouse_count < GUI_MAX_MICE ? snap->mouse_count : GUI_MAX_MICE;
+    for (int i = 0; i < mark_count; i++) {
+        const GuiMouse* gm = &snap->mice[i];
+        float weight = gm->weight < 0.0f ? 0.0f : (gm->weight > 2.0f ? 2.0f : gm->weight);
+        unsigned short style = (snap->individual && gm->id == snap->active_mouse) ? MARK_SELECTED :
+                               (snap->now_ms - gm->last_activity_ms <= ACTIVE_WINDOW_MS) ? MARK_ACTIVE : MARK_IDLE;
+        marks[i] = (Mark){ to_win_x(gm->x), to_win_y(gm->y), (unsigned short)(3.0f + weight * 4.5f), style };
+    }
+
+    // Nothing moved and nothing invalidated: no requests at all
+    bool marks_same = (mark_count == s_mark_count) &&
+                      memcmp(marks, s_marks, (size_t)mark_count * sizeof(Mark)) == 0;
+    if (!s_full_redraw && !s_text_dirty && x == s_last_x && y == s_last_y && marks_same) return;
+
+    XRectangle cross = { (short)(x - CROSS_ARM), (short)(y - CROSS_ARM), 2 * CROSS_ARM + 1, 2 * CROSS_ARM + 1 };
+    XRectangle text = { TEXT_X, 0, TEXT_W, TEXT_H };
+    XRectangle damage[MAX_DAMAGE + 1];
+    int ndamage = 0;
+    if (!s_full_redraw) {
+        if (x != s_last_x || y != s_last_y) {
+            if (s_cross.width) add_damage(damage, &ndamage, s_cross);
+            add_damage(damage, &ndamage, cross);
+        }
+        int n = mark_count > s_mark_count ? mark_count : s_mark_count;
+        for (int i = 0; i < n && ndamage <= MAX_DAMAGE; i++) {
+            if (i < mark_count && i < s_mark_count && memcmp(&marks[i], &s_marks[i], sizeof(Mark)) == 0) continue;
+            if (i < s_mark_count) add_damage(damage, &ndamage, mark_bounds(&s_marks[i]));
+            if (i < mark_count) add_damage(damage, &ndamage, mark_bounds(&marks[i]));
+        }
+        if (s_text_dirty) add_damage(damage, &ndamage, text);
+    }
+    if (s_full_redraw || ndamage > MAX_DAMAGE) {
+        ndamage = 0;
+        damage[ndamage++] = (XRectangle){ 0, 0, (unsigned short)s_w, (unsigned short)s_h };
+    }
+
+    // restore background under damage, then redraw everything clipped to it
+    for (int i = 0; i < ndamage; i++) {
+        XCopyArea(s_dpy, s_grid, s_back, s_gc, damage[i].x, damage[i].y,
+                  damage[i].width, damage[i].height, damage[i].x, damage[i].y);
+    }
+    XSetClipRectangles(s_dpy, s_gc, 0, 0, damage, ndamage, Unsorted);
+
+    // mice: one fill request per style plus one outline request for all
+    XArc arcs[GUI_MAX_MICE];
+    for (int style = 0; style < MARK_STYLES; style++) {
+        int n = 0;
+        for (int i = 0; i < mark_count; i++) if (marks[i].style == style) {
+            arcs[n++] = (XArc){ (short)(marks[i].x - marks[i].r), (short)(marks[i].y - marks[i].r),
+                                (unsigned short)(2 * marks[i].r), (unsigned short)(2 * marks[i].r), 0, 360 * 64 };
+        }
+        if (n == 0) continue;
+        XSetForeground(s_dpy, s_gc, k_mark_colors[style]);
+        XFillArcs(s_dpy, s_back, s_gc, arcs, n);
+    }
+    if (mark_count > 0) {
+        for (int i = 0; i < mark_count; i++) {
+            arcs[i] = (XArc){ (short)(marks[i].x - marks[i].r), (short)(marks[i].y - marks[i].r),
+                              (unsigned short)(2 * marks[i].r), (unsigned short)(2 * marks[i].r), 0, 360 * 64 };
+        }
+        XSetForeground(s_dpy, s_gc, 0x455A64);
+        XDrawArcs(s_dpy, s_back, s_gc, arcs, mark_count);
+    }
+
+    XSegment arms[2] = {
+        { (short)(x - CROSS_ARM), (short)y, (short)(x + CROSS_ARM), (short)y },
+        { (short)x, (short)(y - CROSS_ARM), (short)x, (short)(y + CROSS_ARM) },
+    };
     XSetForeground(s_dpy, s_gc, 0x333333);
-    XDrawLine(s_dpy, s_win, s_gc, x - 12, y, x + 12, y);
-    XDrawLine(s_dpy, s_win, s_gc, x, y - 12, x, y + 12);
+    XDrawSegments(s_dpy, s_back, s_gc, arms, 2);
 
     // overlays
     XSetForeground(s_dpy, s_gc, 0x111111);
-    if (s_mode_text[0]) XDrawString(s_dpy, s_win, s_gc, 10, 20, s_mode_text, (int)strlen(s_mode_text));
-    if (s_status_text[0]) XDrawString(s_dpy, s_win, s_gc, 10, 40, s_status_text, (int)strlen(s_status_text));
+    if (s_mode_text[0]) XDrawString(s_dpy, s_back, s_gc, 10, 20, s_mode_text, (int)strlen(s_mode_text));
+    if (s_status_text[0]) XDrawString(s_dpy, s_back, s_gc, 10, 40, s_status_text, (int)strlen(s_status_text));
+    XSetClipMask(s_dpy, s_gc, None);
+
+    for (int i = 0; i < ndamage; i++) {
+        XCopyArea(s_dpy, s_back, s_win, s_gc, damage[i].x, damage[i].y,
+                  damage[i].width, damage[i].height, damage[i].x, damage[i].y);
+    }
     XFlush(s_dpy);
+
+    s_cross = cross;
+    s_last_x = x;
+    s_last_y = y;
+    memcpy(s_marks, marks, (size_t)mark_count * sizeof(Mark));
+    s_mark_count = mark_count;
+    s_text_dirty = false;
+    s_full_redraw = false;
 }
 
-void gui_update(double host_x, double host_y) {
-    if (!s_dpy) return;
-    // handle pending events (resize, expose)
+// Drain pending X events (resize, expose)
+static void handle_events(void) {
     while (XPending(s_dpy)) {
         XEvent ev; XNextEvent(s_dpy, &ev);
         if (ev.type == ConfigureNotify) {
             XConfigureEvent ce = ev.xconfigure;
-            s_w = ce.width;
-            s_h = ce.height;
+            if (ce.width != s_w || ce.height != s_h) {
+                s_w = ce.width;
+                s_h = ce.height;
+                s_full_redraw = true;
+            }
+        } else if (ev.type == Expose) {
+            s_full_redraw = true;
         }
     }
-    draw_scene(host_x, host_y);
+}
+
+static void sync_text(void) {
+    unsigned version = atomic_load_explicit(&s_text_version, memory_order_acquire);
+    if (version == s_seen_text_version) return;
+    pthread_mutex_lock(&s_text_lock);
+    memcpy(s_mode_text, s_shared_mode_text, sizeof(s_mode_text));
+    memcpy(s_status_text, s_shared_status_text, sizeof(s_status_text));
+    pthread_mutex_unlock(&s_text_lock);
+    s_seen_text_version = version;
+    s_text_dirty = true;
+}
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void read_snapshot(GuiSnapshot* out) {
+    uint32_t seq;
+    do {
+        seq = seqlock_read_begin(&s_snap_lock);
+        memcpy(out, &s_snap, sizeof(*out));
+    } while (seqlock_read_retry(&s_snap_lock, seq));
+}
+
+// Render loop: wakes for X events or the next frame slot, whichever is
+// first, and draws at most max_fps frames per second
+static void* render_thread(void* arg) {
+    (void)arg;
+    struct pollfd fds[2];
+    fds[0].fd = ConnectionNumber(s_dpy);
+    fds[0].events = POLLIN;
+    fds[1].fd = s_wake_pipe[0];
+    fds[1].events = POLLIN;
+
+    int64_t next_frame = monotonic_ms();
+    while (atomic_load(&s_thread_running)) {
+        int64_t wait = next_frame - monotonic_ms();
+        if (wait > 0 && poll(fds, 2, (int)wait) > 0) {
+            if (fds[1].revents) break;
+            if (fds[0].revents & (POLLERR | POLLHUP)) break;
+        }
+        handle_events();
+        if (monotonic_ms() < next_frame) continue;
+
+        sync_text();
+        read_snapshot(&s_frame);
+        uint64_t start_us = metrics_now_us();
+        draw_scene(&s_frame);
+        metrics_observe_us(METRIC_GUI_FRAME_US, metrics_now_us() - start_us);
+        metrics_count(METRIC_GUI_FRAMES, 1);
+        next_frame += s_frame_interval_ms;
+        int64_t now = monotonic_ms();
+        if (next_frame < now) next_frame = now; // don't burst to catch up after a stall
+    }
+    return NULL;
+}
+
+int gui_start_thread(int max_fps) {
+    if (!s_dpy || atomic_load(&s_thread_running)) return 0;
+    s_frame_interval_ms = max_fps > 0 ? 1000 / max_fps : 16;
+    if (s_frame_interval_ms < 1) s_frame_interval_ms = 1;
+    if (pipe(s_wake_pipe) != 0) return 0;
+    atomic_store(&s_thread_running, true);
+    if (pthread_create(&s_thread, NULL, render_thread, NULL) != 0) {
+        atomic_store(&s_thread_running, false);
+        close(s_wake_pipe[0]); close(s_wake_pipe[1]);
+        s_wake_pipe[0] = s_wake_pipe[1] = -1;
+        return 0;
+    }
+    return 1;
+}
+
+void gui_publish(const GuiSnapshot* snapshot) {
+    if (!snapshot) return;
+    // Only the used part of the mouse table is copied
+    int32_t count = snapshot->mouse_count < 0 ? 0 :
+                    (snapshot->mouse_count > GUI_MAX_MICE ? GUI_MAX_MICE : snapshot->mouse_count);
+    seqlock_write_begin(&s_snap_lock);
+    memcpy(&s_snap, snapshot, offsetof(GuiSnapshot, mice));
+    s_snap.mouse_count = count;
+    memcpy(s_snap.mice, snapshot->mice, (size_t)count * sizeof(GuiMouse));
+    seqlock_write_end(&s_snap_lock);
+}
+
+void gui_update(double host_x, double host_y) {
+    if (!s_dpy) return;
+    if (atomic_load(&s_thread_running)) {
+        GuiSnapshot snapshot;
+        memset(&snapshot, 0, offsetof(GuiSnapshot, mice));
+        snapshot.host_x = host_x;
+        snapshot.host_y = host_y;
+        snapshot.now_ms = monotonic_ms();
+        gui_publish(&snapshot);
+        return;
+    }
+    handle_events();
+    sync_text();
+    memset(&s_frame, 0, offsetof(GuiSnapshot, mice));
+    s_frame.host_x = host_x;
+    s_frame.host_y = host_y;
+    s_frame.now_ms = monotonic_ms();
+    draw_scene(&s_frame);
 }
 
 void gui_close(void) {
+    if (atomic_exchange(&s_thread_running, false)) {
+        char c = 0;
+        if (write(s_wake_pipe[1], &c, 1) < 0) { /* thread also re-checks the flag each frame */ }
+        pthread_join(s_thread, NULL);
+        close(s_wake_pipe[0]); close(s_wake_pipe[1]);
+        s_wake_pipe[0] = s_wake_pipe[1] = -1;
+    }
     if (s_dpy) {
+        if (s_grid) { XFreePixmap(s_dpy, s_grid); s_grid = 0; }
+        if (s_back) { XFreePixmap(s_dpy, s_back); s_back = 0; }
         if (s_gc) { XFreeGC(s_dpy, s_gc); s_gc = 0; }
         if (s_win) { XDestroyWindow(s_dpy, s_win); s_win = 0; }
         XCloseDisplay(s_dpy);
         s_dpy = NULL;
     }
+    display_manager_unregister_reader(s_layout_reader);
+    s_layout_reader = -1;
 }
 
 void gui_set_mode_text(const char* mode_text) {
-    if (!mode_text) { s_mode_text[0] = '\0'; return; }
-    snprintf(s_mode_text, sizeof(s_mode_text), "%s", mode_text);
+    pthread_mutex_lock(&s_text_lock);
+    snprintf(s_shared_mode_text, sizeof(s_shared_mode_text), "%s", mode_text ? mode_text : "");
+    pthread_mutex_unlock(&s_text_lock);
+    atomic_fetch_add_explicit(&s_text_version, 1, memory_order_release);
 }
 
 void gui_set_status_text(const char* status_text) {
-    if (!status_text) { s_status_text[0] = '\0'; return; }
-    snprintf(s_status_text, sizeof(s_status_text), "%s", status_text);
+    pthread_mutex_lock(&s_text_lock);
+    snprintf(s_shared_status_text, sizeof(s_shared_status_text), "%s", status_text ? status_text : "");
+    pthread_mutex_unlock(&s_text_lock);
+    atomic_fetch_add_explicit(&s_text_version, 1, memory_order_release);
 }
-
-
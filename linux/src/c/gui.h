@@ -1,15 +1,43 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define GUI_MAX_MICE 128
+
+typedef struct {
+    uint32_t id;
+    int32_t x, y;
+    float weight;
+    int64_t last_activity_ms;
+} GuiMouse;
+
+// Everything the render thread needs for one frame
+typedef struct {
+    double host_x, host_y;
+    bool individual;
+    uint32_t active_mouse;
+    int64_t now_ms;
+    int32_t mouse_count;
+    GuiMouse mice[GUI_MAX_MICE];
+} GuiSnapshot;
+
 // Initialize a simple X11 window. Returns 1 on success, 0 on failure.
 int gui_init(int width, int height, const char* title);
 
-// Update the GUI with the current fused cursor position (screen coords 0..1920/1080 scaled to window).
+// Move event handling and drawing onto a render thread capped at max_fps.
+// Afterwards the window is only touched by that thread. Returns 1 on success.
+int gui_start_thread(int max_fps);
+
+// Publish the latest state for the render thread. Never blocks on X.
+void gui_publish(const GuiSnapshot* snapshot);
+
+// Update the GUI with the current fused cursor position (screen coords, mapped through the display layout).
+// Draws inline without a render thread; publishes a position-only snapshot with one.
 void gui_update(double host_x, double host_y);
 
 // Close the GUI and free resources.
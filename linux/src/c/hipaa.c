@@ -1,66 +1,508 @@
 #include "hipaa.h"
+#include "audit_format.h"
+#include "audit_store.h"
+#include "audit_crypto.h"
+#include "audit_index.h"
+#include "audit_chain.h"
+#include "audit_aggregate.h"
+#include "metrics.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+// Record kinds carried through the ring
+enum { REC_MOUSE_INPUT = 1 };
+
+// Fixed-size binary record; formatting happens on the logger thread
+typedef struct {
+    int64_t ts_ms;
+    uint32_t device_id;
+    int32_t dx, dy;
+    uint32_t kind;
+} audit_record_t;
+
+// Bounded MPSC ring (per-slot sequence numbers, Vyukov style): producers
+// claim a slot with one CAS on s_tail, the logger consumes in order
+typedef struct {
+    _Atomic uint64_t seq;
+    audit_record_t rec;
+} ring_slot_t;
+
+#define BATCH_BUFFER_SIZE (256 * 1024)
+// Payload cap per binary segment; a sealed segment (header + full dict +
+// payload) always fits in the batch buffer
+#define SEGMENT_PAYLOAD_SIZE (128 * 1024)
+
 static char s_log_dir[512] = "";
-static FILE* s_log = NULL;
+static int s_fd = -1;
+static hipaa_options_t s_opts;
+
+static ring_slot_t* s_ring = NULL;
+static size_t s_ring_mask = 0;
+static _Atomic uint64_t s_tail = 0;   // next slot to claim (producers)
+static uint64_t s_head = 0;           // next slot to consume (logger only)
+static _Atomic uint64_t s_dropped = 0;
+static uint64_t s_dropped_reported = 0;
+
+static pthread_t s_thread;
+static atomic_bool s_running = false;
+static pthread_mutex_t s_wake_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_wake_cond = PTHREAD_COND_INITIALIZER;
+
+static char* s_batch = NULL;
+static size_t s_batch_len = 0;
+static int64_t s_last_fsync_ms = 0;
+static bool s_unsynced = false;
+static audit_encoder_t s_enc;
+static audit_index_writer_t s_index = { .fd = -1 };
+// Hash chain over written batches; the head carries over rotation
+static audit_chain_writer_t s_chain = { .fd = -1 };
+// Records and time range of what is in s_batch, for its chain entry
+static uint32_t s_batch_records = 0;
+static int64_t s_batch_first_ts = 0, s_batch_last_ts = 0;
+// Records carry CLOCK_MONOTONIC ms from the input path; the log stores
+// wall-clock (epoch) ms so auditors can ask for calendar time ranges.
+// Re-sampled every batch so clock adjustments are followed.
+static int64_t s_wall_offset_ms = 0;
+// Per-frame / windowed fidelity: per-device aggregation on the logger thread
+static audit_aggregator_t s_agg;
+
+// Rotation thresholds requested via hipaa_rotate; applied by the logger thread
+static _Atomic size_t s_rotate_max_bytes = 0;
+// Logger-owned rotation state: bytes in the active file and the next time boundary
+static uint64_t s_bytes_written = 0;
+static int64_t s_next_rotate_at = 0;
+static char s_last_stem[32] = "";
+static int s_stem_seq = 0;
+
+static bool binary_format(void){ return s_opts.format == HIPAA_FORMAT_BINARY; }
+static const char* log_ext(void){ return binary_format() ? "bin" : "log"; }
+
+// First rotate_interval_sec boundary after now, counted from local midnight
+static int64_t next_boundary(int64_t now){
+    if (s_opts.rotate_interval_sec <= 0) return INT64_MAX;
+    time_t t = (time_t)now; struct tm tm; localtime_r(&t, &tm);
+    tm.tm_hour = tm.tm_min = tm.tm_sec = 0; tm.tm_isdst = -1;
+    int64_t midnight = (int64_t)mktime(&tm);
+    int64_t interval = s_opts.rotate_interval_sec;
+    return midnight + ((now - midnight) / interval + 1) * interval;
+}
 
 static void ensure_dir(const char* path){ mkdir(path, 0700); }
 static void open_log(){
     if (!s_log_dir[0]) return;
     char path[1024];
-    snprintf(path, sizeof(path), "%s/audit.log", s_log_dir);
-    s_log = fopen(path, "a");
+    snprintf(path, sizeof(path), "%s/audit.%s" AUDIT_INDEX_SUFFIX, s_log_dir, log_ext());
+    audit_index_writer_open(&s_index, path);
+    snprintf(path, sizeof(path), "%s/audit.%s" AUDIT_CHAIN_SUFFIX, s_log_dir, log_ext());
+    audit_chain_writer_open(&s_chain, path);
+    snprintf(path, sizeof(path), "%s/audit.%s", s_log_dir, log_ext());
+    s_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    // Size is read once per open; afterwards the logger counts its own writes
+    struct stat st;
+    s_bytes_written = (s_fd >= 0 && fstat(s_fd, &st) == 0) ? (uint64_t)st.st_size : 0;
+    s_next_rotate_at = next_boundary((int64_t)time(NULL));
+}
+
+// Close the active file and its sidecars (the last index block is written out)
+static void close_log(){
+    audit_index_flushed(&s_index, s_bytes_written, true);
+    audit_index_writer_close(&s_index);
+    audit_chain_writer_close(&s_chain);
+    if (s_fd >= 0){ close(s_fd); s_fd = -1; }
+}
+
+static int64_t monotonic_ms(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int64_t wall_ms(void){
+    struct timespec ts; clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void hipaa_default_options(hipaa_options_t* options){
+    if (!options) return;
+    options->ring_capacity = 65536;
+    options->flush_interval_ms = 100;
+    options->fsync_interval_ms = 1000;
+    options->overflow = HIPAA_OVERFLOW_DROP;
+    options->format = HIPAA_FORMAT_TEXT;
+    options->fidelity = HIPAA_FIDELITY_RAW;
+    options->frame_ms = 16;
+    options->window_ms = 1000;
+    options->rotate_interval_sec = 86400;
+    options->archive_dir = NULL;
+    options->compress_segments = true;
+    options->encryption_passphrase = NULL;
+}
+
+static void wake_logger(void){
+    pthread_mutex_lock(&s_wake_lock);
+    pthread_cond_signal(&s_wake_cond);
+    pthread_mutex_unlock(&s_wake_lock);
+}
+
+static void write_all(const char* buf, size_t len){
+    while (len > 0 && s_fd >= 0) {
+        ssize_t n = write(s_fd, buf, len);
+        if (n < 0) { if (errno == EINTR) continue; return; }
+        buf += n; len -= (size_t)n;
+        s_bytes_written += (uint64_t)n;
+    }
+}
+
+// Account records that are now part of the batch buffer
+static void batch_note(uint32_t records, int64_t first_ts, int64_t last_ts){
+    if (s_batch_records == 0) { s_batch_first_ts = first_ts; s_batch_last_ts = last_ts; }
+    if (first_ts < s_batch_first_ts) s_batch_first_ts = first_ts;
+    if (last_ts > s_batch_last_ts) s_batch_last_ts = last_ts;
+    s_batch_records += records;
+}
+
+static void write_batch(void){
+    if (s_batch_len == 0) return;
+    uint64_t start_us = metrics_now_us();
+    uint64_t offset = s_bytes_written;
+    write_all(s_batch, s_batch_len);
+    // One chain entry per batch, hashed here on the logger thread
+    audit_chain_append(&s_chain, offset, (const uint8_t*)s_batch, s_batch_len,
+                       s_batch_records, s_batch_first_ts, s_batch_last_ts);
+    metrics_observe_us(METRIC_AUDIT_WRITE_US, metrics_now_us() - start_us);
+    metrics_count(METRIC_AUDIT_BATCHES, 1);
+    metrics_count(METRIC_AUDIT_RECORDS, s_batch_records);
+    metrics_count(METRIC_AUDIT_BYTES, s_bytes_written - offset);
+    s_batch_len = 0;
+    s_batch_records = 0;
+    s_unsynced = true;
+}
+
+// Close the open binary segment into the batch buffer
+static void seal_segment(void){
+    if (s_enc.record_count == 0) return;
+    if (s_batch_len + audit_encoder_segment_size(&s_enc) > BATCH_BUFFER_SIZE) write_batch();
+    batch_note(s_enc.record_count, s_enc.first_ts, s_enc.last_ts);
+    s_batch_len += audit_encoder_finish(&s_enc, (uint8_t*)s_batch + s_batch_len);
+    // Segment boundary: the index block may end here
+    audit_index_flushed(&s_index, s_bytes_written + s_batch_len, false);
+}
+
+static void flush_batch(void){
+    if (binary_format()) seal_segment();
+    write_batch();
+}
+
+static void append_line(int64_t ts, const char* fmt_line, int len){
+    if (len <= 0) return;
+    if (s_batch_len + (size_t)len > BATCH_BUFFER_SIZE) write_batch();
+    memcpy(s_batch + s_batch_len, fmt_line, (size_t)len);
+    s_batch_len += (size_t)len;
+    batch_note(1, ts, ts);
+}
+
+static void write_input(int64_t ts, uint32_t pseudo, int32_t dx, int32_t dy){
+    // The record lands right after what is buffered; index blocks end only on
+    // line or segment boundaries, so a block never splits a record
+    audit_index_note(&s_index, s_bytes_written + s_batch_len, ts, pseudo);
+    if (binary_format()) {
+        audit_encoder_add_input(&s_enc, ts, pseudo, dx, dy);
+        if (audit_encoder_full(&s_enc)) seal_segment();
+        return;
+    }
+    char line[96];
+    int len = snprintf(line, sizeof(line), "%lld,MOUSE_INPUT,%u,%d,%d\n", (long long)ts, pseudo, dx, dy);
+    append_line(ts, line, len);
+    audit_index_flushed(&s_index, s_bytes_written + s_batch_len, false);
+}
+
+static int32_t clamp_i32(int64_t v){ return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (int32_t)v; }
+
+// Aggregator output: a coalesced input record (per-frame) or a window summary
+static void write_window(int64_t start_ms, uint32_t pseudo, const audit_window_t* w, void* ctx){
+    (void)ctx;
+    if (s_opts.fidelity == HIPAA_FIDELITY_FRAME) {
+        write_input(start_ms, pseudo, clamp_i32(w->sum_dx), clamp_i32(w->sum_dy));
+        return;
+    }
+    audit_index_note(&s_index, s_bytes_written + s_batch_len, start_ms, pseudo);
+    if (binary_format()) {
+        audit_encoder_add_window(&s_enc, start_ms, pseudo, w);
+        if (audit_encoder_full(&s_enc)) seal_segment();
+        return;
+    }
+    audit_entry_t entry = { .kind = AUDIT_KIND_MOUSE_WINDOW, .ts_ms = start_ms, .pseudo_id = pseudo, .window = *w };
+    char line[256];
+    append_line(start_ms, line, audit_format_csv(&entry, line, sizeof(line)));
+    audit_index_flushed(&s_index, s_bytes_written + s_batch_len, false);
+}
+
+static void emit_record(const audit_record_t* rec){
+    // redact device id to pseudonymous form
+    uint32_t pseudo = rec->device_id ^ 0xA5A5A5A5u;
+    int64_t ts = rec->ts_ms + s_wall_offset_ms;
+    if (s_opts.fidelity != HIPAA_FIDELITY_RAW &&
+        audit_aggregator_add(&s_agg, ts, pseudo, rec->dx, rec->dy, write_window, NULL)) return;
+    // raw fidelity, or the aggregator's device table is full
+    write_input(ts, pseudo, rec->dx, rec->dy);
+}
+
+// Overflow is reported in-band so gaps in the audit trail are visible
+static void emit_dropped(void){
+    uint64_t dropped = atomic_load_explicit(&s_dropped, memory_order_relaxed);
+    if (dropped == s_dropped_reported) return;
+    int64_t ts = wall_ms();
+    metrics_count(METRIC_AUDIT_DROPPED, dropped - s_dropped_reported);
+    audit_index_note(&s_index, s_bytes_written + s_batch_len, ts, AUDIT_INDEX_ID_DROPPED);
+    if (binary_format()) {
+        audit_encoder_add_dropped(&s_enc, ts, dropped - s_dropped_reported);
+        s_dropped_reported = dropped;
+        return;
+    }
+    char line[96];
+    int len = snprintf(line, sizeof(line), "%lld,AUDIT_DROPPED,%llu\n", (long long)ts,
+                       (unsigned long long)(dropped - s_dropped_reported));
+    append_line(ts, line, len);
+    audit_index_flushed(&s_index, s_bytes_written + s_batch_len, false);
+    s_dropped_reported = dropped;
+}
+
+// Consume what is published in the ring, at most one ring's worth so a
+// producer that never pauses cannot starve flushing, fsync and rotation
+static size_t drain_ring(void){
+    size_t n = 0;
+    s_wall_offset_ms = wall_ms() - monotonic_ms();
+    metrics_gauge_set(METRIC_AUDIT_BACKLOG, (int64_t)(atomic_load_explicit(&s_tail, memory_order_relaxed) - s_head));
+    while (n <= s_ring_mask) {
+        ring_slot_t* slot = &s_ring[s_head & s_ring_mask];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != s_head + 1) break;
+        audit_record_t rec = slot->rec;
+        atomic_store_explicit(&slot->seq, s_head + s_ring_mask + 1, memory_order_release);
+        s_head++;
+        n++;
+        if (rec.kind == REC_MOUSE_INPUT) emit_record(&rec);
+    }
+    // Close windows that ended before this batch; events arriving later than
+    // one flush interval open a fresh window with the same start
+    if (s_opts.fidelity != HIPAA_FIDELITY_RAW) {
+        audit_aggregator_flush(&s_agg, wall_ms() - s_opts.flush_interval_ms, write_window, NULL);
+    }
+    emit_dropped();
+    return n;
+}
+
+static void rotate_if_needed(void);
+
+static void maybe_fsync(bool force){
+    if (!s_unsynced || s_fd < 0 || s_opts.fsync_interval_ms < 0) return;
+    int64_t now = monotonic_ms();
+    if (force || now - s_last_fsync_ms >= s_opts.fsync_interval_ms) {
+        uint64_t start_us = metrics_now_us();
+        fdatasync(s_fd);
+        metrics_observe_us(METRIC_AUDIT_FSYNC_US, metrics_now_us() - start_us);
+        s_last_fsync_ms = now;
+        s_unsynced = false;
+    }
+}
+
+static void* logger_thread(void* arg){
+    (void)arg;
+    bool backlog = false;
+    while (atomic_load(&s_running)) {
+        // Only sleep when the last drain emptied the ring
+        if (!backlog) {
+            pthread_mutex_lock(&s_wake_lock);
+            struct timespec deadline; clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += (long)s_opts.flush_interval_ms * 1000000L;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+            pthread_cond_timedwait(&s_wake_cond, &s_wake_lock, &deadline);
+            pthread_mutex_unlock(&s_wake_lock);
+        }
+
+        backlog = drain_ring() > s_ring_mask;
+        flush_batch();
+        maybe_fsync(false);
+        rotate_if_needed();
+    }
+    while (drain_ring() > s_ring_mask) flush_batch();
+    audit_aggregator_flush_all(&s_agg, write_window, NULL);
+    flush_batch();
+    maybe_fsync(true);
+    return NULL;
 }
 
 void hipaa_init(const char* log_dir){
-    if (!log_dir) return;
+    hipaa_init_ex(log_dir, NULL);
+}
+
+void hipaa_init_ex(const char* log_dir, const hipaa_options_t* options){
+    if (!log_dir || atomic_load(&s_running)) return;
+    if (options) s_opts = *options; else hipaa_default_options(&s_opts);
+    if (s_opts.flush_interval_ms <= 0) s_opts.flush_interval_ms = 100;
+    if (s_opts.frame_ms <= 0) s_opts.frame_ms = 16;
+    if (s_opts.window_ms <= 0) s_opts.window_ms = 1000;
+
+    size_t capacity = 1024;
+    while (capacity < s_opts.ring_capacity) capacity <<= 1;
+    s_ring = calloc(capacity, sizeof(ring_slot_t));
+    s_batch = malloc(BATCH_BUFFER_SIZE);
+    bool enc_ok = !binary_format() || audit_encoder_init(&s_enc, SEGMENT_PAYLOAD_SIZE);
+    audit_aggregator_init(&s_agg, (uint32_t)(s_opts.fidelity == HIPAA_FIDELITY_FRAME ? s_opts.frame_ms : s_opts.window_ms));
+    if (!s_ring || !s_batch || !enc_ok) {
+        free(s_ring); free(s_batch); s_ring = NULL; s_batch = NULL;
+        audit_encoder_free(&s_enc);
+        return;
+    }
+    for (size_t i = 0; i < capacity; i++) atomic_init(&s_ring[i].seq, i);
+    s_ring_mask = capacity - 1;
+    atomic_store(&s_tail, 0);
+    s_head = 0;
+
     snprintf(s_log_dir, sizeof(s_log_dir), "%s", log_dir);
     ensure_dir(s_log_dir);
     open_log();
+    s_last_fsync_ms = monotonic_ms();
+    audit_store_set_compression(s_opts.compress_segments);
+    audit_store_set_encryption(s_opts.encryption_passphrase);
+    audit_store_start(s_log_dir, s_opts.archive_dir);
+    // The store keeps its own locked copy
+    s_opts.encryption_passphrase = NULL;
+
+    atomic_store(&s_running, true);
+    if (pthread_create(&s_thread, NULL, logger_thread, NULL) != 0) {
+        atomic_store(&s_running, false);
+        close_log();
+    }
 }
 
-void hipaa_shutdown(void){ if (s_log){ fclose(s_log); s_log=NULL; } }
+void hipaa_shutdown(void){
+    if (atomic_exchange(&s_running, false)) {
+        wake_logger();
+        pthread_join(s_thread, NULL);
+    }
+    audit_store_stop();
+    close_log();
+    free(s_ring); s_ring = NULL;
+    free(s_batch); s_batch = NULL;
+    audit_encoder_free(&s_enc);
+    audit_chain_hash_free(&s_chain.hash);
+}
 
 void hipaa_log_input(uint32_t device_id, int32_t dx, int32_t dy, int64_t ts_ms){
-    if (!s_log) return;
-    // redact device id to pseudonymous form
-    uint32_t pseudo = device_id ^ 0xA5A5A5A5u;
-    fprintf(s_log, "%lld,MOUSE_INPUT,%u,%d,%d\n", (long long)ts_ms, pseudo, dx, dy);
-    fflush(s_log);
+    if (!atomic_load_explicit(&s_running, memory_order_relaxed)) return;
+    uint64_t pos = atomic_load_explicit(&s_tail, memory_order_relaxed);
+    ring_slot_t* slot;
+    while (1) {
+        slot = &s_ring[pos & s_ring_mask];
+        uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&s_tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // ring full
+            if (s_opts.overflow == HIPAA_OVERFLOW_DROP) {
+                atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+                return;
+            }
+            if (!atomic_load_explicit(&s_running, memory_order_relaxed)) return;
+            wake_logger();
+            sched_yield();
+            pos = atomic_load_explicit(&s_tail, memory_order_relaxed);
+        } else {
+            pos = atomic_load_explicit(&s_tail, memory_order_relaxed);
+        }
+    }
+    slot->rec = (audit_record_t){ ts_ms, device_id, dx, dy, REC_MOUSE_INPUT };
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
 }
 
-static long file_size(const char* p){ struct stat st; if (stat(p,&st)==0) return st.st_size; return 0; }
+uint64_t hipaa_dropped_count(void){
+    return atomic_load_explicit(&s_dropped, memory_order_relaxed);
+}
 
-void hipaa_rotate(size_t max_bytes, int max_days){
-    if (!s_log_dir[0]) return;
-    char path[1024]; snprintf(path,sizeof(path),"%s/audit.log",s_log_dir);
-    long sz = file_size(path);
-    if ((size_t)sz > max_bytes){
-        // rotate with timestamp suffix
-        char bak[1024];
-        time_t t=time(NULL); struct tm tm; localtime_r(&t,&tm);
-        snprintf(bak,sizeof(bak),"%s/audit-%04d%02d%02d-%02d%02d%02d.log",s_log_dir,tm.tm_year+1900,tm.tm_mon+1,tm.tm_mday,tm.tm_hour,tm.tm_min,tm.tm_sec);
-        if (s_log){ fclose(s_log); s_log=NULL; }
-        rename(path,bak);
-        open_log();
+// Runs on the logger thread, which owns the log descriptor. Both checks are
+// in-memory: no stat() of the active file.
+static void rotate_if_needed(void){
+    if (!s_log_dir[0] || s_fd < 0) return;
+    size_t max_bytes = atomic_load_explicit(&s_rotate_max_bytes, memory_order_relaxed);
+    int64_t now = (int64_t)time(NULL);
+    if (s_bytes_written == 0) {
+        // nothing to rotate; an empty file just moves on to the next boundary
+        if (now >= s_next_rotate_at) s_next_rotate_at = next_boundary(now);
+        return;
     }
-    // day-based retention left as an exercise or cron job
-}
+    bool by_size = max_bytes > 0 && s_bytes_written >= max_bytes;
+    bool by_time = now >= s_next_rotate_at;
+    if (!by_size && !by_time) return;
 
-int hipaa_encrypt_export(const char* dest_path, const char* passphrase){
-    if (!dest_path || !passphrase) return 0;
-    char src[1024]; snprintf(src,sizeof(src),"%s/audit.log",s_log_dir);
-    // Best-effort using openssl enc (AES-256-CBC)
-    char cmd[2048];
-    snprintf(cmd,sizeof(cmd),"openssl enc -aes-256-cbc -salt -in '%s' -out '%s' -pass pass:%s 2>/dev/null", src, dest_path, passphrase);
-    int rc = system(cmd);
-    return rc==0 ? 1 : 0;
+    // rotate with timestamp suffix; a counter keeps same-second rotations apart
+    char stem[32];
+    time_t t = (time_t)now; struct tm tm; localtime_r(&t, &tm);
+    strftime(stem, sizeof(stem), "audit-%Y%m%d-%H%M%S", &tm);
+    s_stem_seq = strcmp(stem, s_last_stem) == 0 ? s_stem_seq + 1 : 0;
+    snprintf(s_last_stem, sizeof(s_last_stem), "%s", stem);
+    char name[64];
+    if (s_stem_seq) snprintf(name, sizeof(name), "%s-%d.%s", stem, s_stem_seq, log_ext());
+    else snprintf(name, sizeof(name), "%s.%s", stem, log_ext());
+
+    char path[1024], bak[1024];
+    snprintf(path, sizeof(path), "%s/audit.%s", s_log_dir, log_ext());
+    snprintf(bak, sizeof(bak), "%s/%s", s_log_dir, name);
+    // Open windows belong to the file being closed
+    if (s_opts.fidelity != HIPAA_FIDELITY_RAW) {
+        audit_aggregator_flush_all(&s_agg, write_window, NULL);
+        flush_batch();
+    }
+    uint64_t bytes = s_bytes_written;
+    maybe_fsync(true);
+    close_log();
+    if (rename(path, bak) == 0) {
+        // The sidecar index and hash chain travel with their segment
+        char side[sizeof(path) + sizeof(AUDIT_CHAIN_SUFFIX)], side_bak[sizeof(bak) + sizeof(AUDIT_CHAIN_SUFFIX)];
+        snprintf(side, sizeof(side), "%s" AUDIT_INDEX_SUFFIX, path);
+        snprintf(side_bak, sizeof(side_bak), "%s" AUDIT_INDEX_SUFFIX, bak);
+        rename(side, side_bak);
+        snprintf(side, sizeof(side), "%s" AUDIT_CHAIN_SUFFIX, path);
+        snprintf(side_bak, sizeof(side_bak), "%s" AUDIT_CHAIN_SUFFIX, bak);
+        rename(side, side_bak);
+        audit_store_add(name, now, bytes);
+        metrics_count(METRIC_AUDIT_ROTATIONS, 1);
+    }
+    open_log();
 }
 
+void hipaa_rotate(size_t max_bytes, int max_days){
+    // The size check runs on the logger thread after each batch
+    atomic_store_explicit(&s_rotate_max_bytes, max_bytes, memory_order_relaxed);
+    audit_store_set_retention(max_days);
+}
 
+int hipaa_encrypt_export(const char* dest_path, const char* passphrase){
+    if (!dest_path || !passphrase || !s_log_dir[0]) return 0;
+    char src[1024]; snprintf(src,sizeof(src),"%s/audit.%s",s_log_dir,log_ext());
+    int in_fd = open(src, O_RDONLY | O_CLOEXEC);
+    if (in_fd < 0) return 0;
+    // The logger keeps appending; export what was on disk when we started
+    struct stat st;
+    if (fstat(in_fd, &st) != 0) { close(in_fd); return 0; }
+    char tmp[1024]; snprintf(tmp,sizeof(tmp),"%s.tmp",dest_path);
+    int out_fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out_fd < 0) { close(in_fd); return 0; }
+    bool ok = audit_crypto_encrypt_fd(in_fd, out_fd, (uint64_t)st.st_size, passphrase) && fdatasync(out_fd) == 0;
+    close(in_fd);
+    if (close(out_fd) != 0) ok = false;
+    if (ok) ok = rename(tmp, dest_path) == 0;
+    if (!ok) unlink(tmp);
+    return ok ? 1 : 0;
+}
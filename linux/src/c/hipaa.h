@@ -7,17 +7,65 @@
 extern "C" {
 #endif
 
+// What the input path does when the audit ring is full
+typedef enum {
+    HIPAA_OVERFLOW_DROP = 0,  // drop the record and count it (reported in the log)
+    HIPAA_OVERFLOW_BLOCK = 1  // wait for the logger thread to make room
+} hipaa_overflow_t;
+
+// On-disk record format
+typedef enum {
+    HIPAA_FORMAT_TEXT = 0,    // audit.log, one CSV line per event
+    HIPAA_FORMAT_BINARY = 1   // audit.bin, segmented binary (see audit_format.h)
+} hipaa_format_t;
+
+// How much input detail the audit trail keeps
+typedef enum {
+    HIPAA_FIDELITY_RAW = 0,     // every event (MOUSE_INPUT)
+    HIPAA_FIDELITY_FRAME = 1,   // per device, events summed over frame_ms (MOUSE_INPUT at frame start)
+    HIPAA_FIDELITY_WINDOW = 2   // per device aggregates over window_ms (MOUSE_WINDOW: count, sums,
+                                // min/max, active time)
+} hipaa_fidelity_t;
+
+typedef struct {
+    size_t ring_capacity;      // records buffered between input and logger (rounded up to a power of two)
+    int flush_interval_ms;     // how often the logger drains the ring and writes a batch
+    int fsync_interval_ms;     // fsync cadence; 0 = fsync after every batch, <0 = never
+    hipaa_overflow_t overflow;
+    hipaa_format_t format;
+    hipaa_fidelity_t fidelity;
+    int frame_ms;              // HIPAA_FIDELITY_FRAME bucket
+    int window_ms;             // HIPAA_FIDELITY_WINDOW bucket
+    int rotate_interval_sec;   // time-based rotation on local-midnight-aligned boundaries; 0 = size only
+    const char* archive_dir;   // expired segments are moved here (same filesystem); NULL = delete
+    bool compress_segments;    // rotated segments are compressed in the background (seekable, see audit_compress.h)
+    const char* encryption_passphrase; // rotated segments are encrypted in the background; NULL = off
+} hipaa_options_t;
+
 // Minimal HIPAA-style audit logging and retention controls
+void hipaa_default_options(hipaa_options_t* options);
 void hipaa_init(const char* log_dir);
+void hipaa_init_ex(const char* log_dir, const hipaa_options_t* options);
 void hipaa_shutdown(void);
+
+// Hot path: appends a fixed-size record to a lock-free ring; formatting and
+// I/O happen on the logger thread. Safe to call from any number of threads.
+// ts_ms is CLOCK_MONOTONIC ms; the log stores it as wall-clock epoch ms.
 void hipaa_log_input(uint32_t device_id, int32_t dx, int32_t dy, int64_t ts_ms);
+
+// Rotation/retention policy; call once (or on policy change), not per tick.
+// The logger rotates when the active file reaches max_bytes (tracked in
+// process, 0 = no size limit) or crosses a rotate_interval_sec boundary, and a
+// background sweeper expires rotated segments older than max_days (<= 0 = keep).
 void hipaa_rotate(size_t max_bytes, int max_days);
 
-// Best-effort encryption export (requires openssl CLI installed). Returns 1 on success.
+// Records dropped because the ring was full (HIPAA_OVERFLOW_DROP)
+uint64_t hipaa_dropped_count(void);
+
+// Encrypt the active audit file to dest_path (AES-256-GCM, see audit_crypto.h),
+// streaming in fixed-size chunks. Returns 1 on success.
 int hipaa_encrypt_export(const char* dest_path, const char* passphrase);
 
 #ifdef __cplusplus
 }
 #endif
-
-
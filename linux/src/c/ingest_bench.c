@@ -0,0 +1,125 @@
+// sendmmsg
+#define _GNU_SOURCE
+#include "net_ingest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Loopback load generator for the remote mouse ingestion server: simulates
+// many clients sending batched deltas at a fixed rate from one socket, so
+// the server side (threeblindmice_net_* metrics, CPU time) can be measured.
+
+#define SEND_BATCH 64
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [--clients N] [--rate HZ] [--seconds S] [--batch K] HOST:PORT\n"
+            "  Sends one datagram per client every 1/HZ seconds for S seconds,\n"
+            "  each carrying K deltas (defaults: 1000 clients, 120 Hz, 10 s, 1).\n",
+            argv0);
+}
+
+static int connect_udp(const char* spec) {
+    char host[256];
+    snprintf(host, sizeof(host), "%s", spec);
+    char* colon = strrchr(host, ':');
+    if (!colon) return -1;
+    *colon = '\0';
+    char* name = host;
+    if (name[0] == '[') {
+        name++;
+        char* close_bracket = strchr(name, ']');
+        if (close_bracket) *close_bracket = '\0';
+    }
+    struct addrinfo hints = { .ai_socktype = SOCK_DGRAM, .ai_flags = AI_NUMERICSERV };
+    struct addrinfo* res = NULL;
+    if (getaddrinfo(name, colon + 1, &hints, &res) != 0) return -1;
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) { close(fd); fd = -1; }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+int main(int argc, char** argv) {
+    int clients = 1000, rate = 120, seconds = 10, batch = 1;
+    const char* target = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) clients = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) rate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batch = atoi(argv[++i]);
+        else if (argv[i][0] != '-' && !target) target = argv[i];
+        else { usage(argv[0]); return 2; }
+    }
+    if (!target || clients <= 0 || rate <= 0 || seconds <= 0 || batch < 1 || batch > NET_INGEST_MAX_DELTAS) {
+        usage(argv[0]);
+        return 2;
+    }
+    int fd = connect_udp(target);
+    if (fd < 0) { fprintf(stderr, "❌ Cannot reach %s\n", target); return 1; }
+    int sndbuf = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    uint32_t* seqs = calloc((size_t)clients, sizeof(uint32_t));
+    uint8_t (*bufs)[NET_INGEST_MAX_MESSAGE] = malloc(SEND_BATCH * sizeof(*bufs));
+    if (!seqs || !bufs) return 1;
+    uint32_t base_id = (uint32_t)getpid() << 16;
+    int16_t deltas[NET_INGEST_MAX_DELTAS][2];
+
+    struct timespec start, next;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    next = start;
+    long period_ns = 1000000000L / rate;
+    unsigned long long sent = 0, failed = 0;
+    for (long round = 0; round < (long)rate * seconds; round++) {
+        for (int first = 0; first < clients; first += SEND_BATCH) {
+            int count = clients - first < SEND_BATCH ? clients - first : SEND_BATCH;
+            struct mmsghdr msgs[SEND_BATCH];
+            struct iovec iov[SEND_BATCH];
+            for (int k = 0; k < count; k++) {
+                int c = first + k;
+                // A small circle per client so the fused cursor stays put
+                for (int d = 0; d < batch; d++) {
+                    deltas[d][0] = (int16_t)(((round + d) & 3) < 2 ? 1 : -1);
+                    deltas[d][1] = (int16_t)(((round + d + 1) & 3) < 2 ? 1 : -1);
+                }
+                uint16_t flags = seqs[c] == 0 ? NET_INGEST_FLAG_RESET : 0;
+                size_t len = net_ingest_encode(bufs[k], base_id + (uint32_t)c, seqs[c]++, flags,
+                                               (const int16_t (*)[2])deltas, (uint8_t)batch);
+                iov[k] = (struct iovec){ .iov_base = bufs[k], .iov_len = len };
+                msgs[k].msg_hdr = (struct msghdr){ .msg_iov = &iov[k], .msg_iovlen = 1 };
+            }
+            int done = 0;
+            while (done < count) {
+                int n = sendmmsg(fd, msgs + done, (unsigned)(count - done), 0);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    failed += (unsigned long long)(count - done);
+                    break;
+                }
+                done += n;
+            }
+            sent += (unsigned long long)done;
+        }
+        next.tv_nsec += period_ns;
+        if (next.tv_nsec >= 1000000000L) { next.tv_sec++; next.tv_nsec -= 1000000000L; }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("📤 %llu datagrams in %.2fs (%.0f/s, %d clients at %d Hz), %llu send failures\n", sent, elapsed,
+           (double)sent / elapsed, clients, rate, failed);
+    free(bufs);
+    free(seqs);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include "inject_shm.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RING_MASK (INJECT_RING_FRAMES - 1)
+// How often the consumer looks for producers that exited without detaching
+#define REAP_INTERVAL_MS 1000
+
+static inject_shm_t* s_shm = NULL;
+static char s_name[256] = "";
+static uint32_t s_known_mask[INJECT_MAX_PRODUCERS];
+static uint64_t s_known_full[INJECT_MAX_PRODUCERS];
+static int64_t s_next_reap_ms = 0;
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void resolve_name(const char* name, char* out, size_t out_size) {
+    const char* env = getenv("THREEBLINDMICE_INJECT_SHM");
+    if (name && name[0] == '/') snprintf(out, out_size, "%s", name);
+    else snprintf(out, out_size, "%s", env && env[0] == '/' ? env : INJECT_SHM_NAME);
+}
+
+bool inject_shm_open(void) {
+    if (s_shm) return true;
+    resolve_name(NULL, s_name, sizeof(s_name));
+    // Producers attached to a previous run's object keep their old mapping
+    // and simply stop being read; they reattach to the new one
+    shm_unlink(s_name);
+    int fd = shm_open(s_name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+    if (ftruncate(fd, sizeof(inject_shm_t)) != 0) {
+        close(fd);
+        shm_unlink(s_name);
+        return false;
+    }
+    void* map = mmap(NULL, sizeof(inject_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        shm_unlink(s_name);
+        return false;
+    }
+    s_shm = map;
+    memset(s_known_mask, 0, sizeof(s_known_mask));
+    memset(s_known_full, 0, sizeof(s_known_full));
+    // ftruncate zero-fills: every slot starts FREE with empty rings
+    s_shm->version = INJECT_SHM_VERSION;
+    s_shm->size = sizeof(inject_shm_t);
+    s_shm->consumer_pid = (uint32_t)getpid();
+    atomic_thread_fence(memory_order_release);
+    s_shm->magic = INJECT_SHM_MAGIC;
+    return true;
+}
+
+void inject_shm_close(void) {
+    if (!s_shm) return;
+    munmap(s_shm, sizeof(inject_shm_t));
+    s_shm = NULL;
+    shm_unlink(s_name);
+}
+
+const char* inject_shm_name(void) {
+    return s_name;
+}
+
+// Report registrations and removals; names are written before the mask bit
+static void sync_devices(int index, uint32_t mask) {
+    uint32_t changed = mask ^ s_known_mask[index];
+    if (!changed) return;
+    inject_slot_t* slot = &s_shm->slots[index];
+    for (int d = 0; d < INJECT_MAX_DEVICES; d++) {
+        if (!(changed & (1u << d))) continue;
+        char label[INJECT_NAME_SIZE];
+        memcpy(label, slot->names[d], sizeof(label));
+        label[sizeof(label) - 1] = '\0';
+        if (mask & (1u << d)) printf("🔌 Virtual device added: %s (ID: %u)\n", label, INJECT_DEVICE_ID(index, d));
+        else printf("🔌 Virtual device removed: %s (ID: %u)\n", label, INJECT_DEVICE_ID(index, d));
+    }
+    s_known_mask[index] = mask;
+}
+
+static void reap_exited_producers(void) {
+    for (int i = 0; i < INJECT_MAX_PRODUCERS; i++) {
+        inject_slot_t* slot = &s_shm->slots[i];
+        if (atomic_load_explicit(&slot->state, memory_order_acquire) != INJECT_SLOT_ACTIVE) continue;
+        pid_t pid = (pid_t)atomic_load_explicit(&slot->owner_pid, memory_order_relaxed);
+        if (pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH) continue;
+        // Discard what the dead producer left and hand the slot back
+        atomic_store_explicit(&slot->device_mask, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->tail, atomic_load_explicit(&slot->head, memory_order_acquire), memory_order_release);
+        uint32_t expected = INJECT_SLOT_ACTIVE;
+        atomic_compare_exchange_strong_explicit(&slot->state, &expected, INJECT_SLOT_FREE, memory_order_release, memory_order_relaxed);
+        printf("🔌 Injection producer %d exited; slot %d reclaimed\n", (int)pid, i);
+    }
+}
+
+size_t inject_shm_drain(inject_shm_deliver_t deliver) {
+    if (!s_shm) return 0;
+    int64_t now = monotonic_ms();
+    if (now >= s_next_reap_ms) {
+        reap_exited_producers();
+        s_next_reap_ms = now + REAP_INTERVAL_MS;
+    }
+    size_t delivered = 0;
+    uint32_t ids[INJECT_DRAIN_BATCH];
+    int32_t dx[INJECT_DRAIN_BATCH], dy[INJECT_DRAIN_BATCH];
+    size_t batch = 0;
+    for (int i = 0; i < INJECT_MAX_PRODUCERS; i++) {
+        inject_slot_t* slot = &s_shm->slots[i];
+        uint32_t state = atomic_load_explicit(&slot->state, memory_order_acquire);
+        if (state == INJECT_SLOT_DETACHING) {
+            // The producer is done with the slot; drop what it left so the
+            // next producer starts with head == tail
+            sync_devices(i, 0);
+            s_known_full[i] = 0;
+            atomic_store_explicit(&slot->tail, atomic_load_explicit(&slot->head, memory_order_acquire), memory_order_relaxed);
+            atomic_store_explicit(&slot->state, INJECT_SLOT_FREE, memory_order_release);
+            continue;
+        }
+        bool active = state == INJECT_SLOT_ACTIVE;
+        uint32_t mask = active ? atomic_load_explicit(&slot->device_mask, memory_order_acquire) : 0;
+        sync_devices(i, mask);
+        if (!active) { s_known_full[i] = 0; continue; }
+
+        uint64_t full = atomic_load_explicit(&slot->full_count, memory_order_relaxed);
+        if (full > s_known_full[i]) metrics_count(METRIC_INJECT_BACKPRESSURE, full - s_known_full[i]);
+        s_known_full[i] = full;
+
+        uint64_t head = atomic_load_explicit(&slot->head, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&slot->tail, memory_order_relaxed);
+        // A producer can only run ahead by one ring; anything else is garbage
+        if (head - tail > INJECT_RING_FRAMES) tail = head - INJECT_RING_FRAMES;
+        for (; tail != head; tail++) {
+            const inject_frame_t* f = &slot->frames[tail & RING_MASK];
+            uint32_t device = f->device;
+            if (device >= INJECT_MAX_DEVICES || !(mask & (1u << device))) continue;
+            ids[batch] = INJECT_DEVICE_ID(i, device);
+            dx[batch] = f->dx;
+            dy[batch] = f->dy;
+            if (++batch == INJECT_DRAIN_BATCH) {
+                deliver(ids, dx, dy, batch);
+                delivered += batch;
+                batch = 0;
+            }
+        }
+        atomic_store_explicit(&slot->tail, tail, memory_order_release);
+    }
+    if (batch > 0) {
+        deliver(ids, dx, dy, batch);
+        delivered += batch;
+    }
+    if (delivered) metrics_count(METRIC_INJECT_FRAMES, delivered);
+    return delivered;
+}
+
+int inject_shm_device_count(void) {
+    int count = 0;
+    for (int i = 0; i < INJECT_MAX_PRODUCERS; i++) count += __builtin_popcount(s_known_mask[i]);
+    return count;
+}
+
+bool inject_producer_attach(inject_producer_t* p, const char* name) {
+    memset(p, 0, sizeof(*p));
+    p->index = -1;
+    char path[256];
+    resolve_name(name, path, sizeof(path));
+    int fd = shm_open(path, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(inject_shm_t)) { close(fd); return false; }
+    void* map = mmap(NULL, sizeof(inject_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+    inject_shm_t* shm = map;
+    if (shm->magic != INJECT_SHM_MAGIC || shm->version != INJECT_SHM_VERSION || shm->size != sizeof(inject_shm_t)) {
+        munmap(map, sizeof(inject_shm_t));
+        return false;
+    }
+    for (int i = 0; i < INJECT_MAX_PRODUCERS; i++) {
+        inject_slot_t* slot = &shm->slots[i];
+        uint32_t expected = INJECT_SLOT_FREE;
+        if (!atomic_compare_exchange_strong_explicit(&slot->state, &expected, INJECT_SLOT_CLAIMED,
+                                                     memory_order_acquire, memory_order_relaxed)) continue;
+        // The consumer left head == tail when the slot was freed
+        atomic_store_explicit(&slot->owner_pid, (uint32_t)getpid(), memory_order_relaxed);
+        atomic_store_explicit(&slot->device_mask, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->full_count, 0, memory_order_relaxed);
+        memset(slot->names, 0, sizeof(slot->names));
+        atomic_store_explicit(&slot->state, INJECT_SLOT_ACTIVE, memory_order_release);
+        p->shm = shm;
+        p->slot = slot;
+        p->index = i;
+        return true;
+    }
+    munmap(map, sizeof(inject_shm_t));
+    return false;
+}
+
+int inject_producer_add_device(inject_producer_t* p, const char* label) {
+    if (!p->slot) return -1;
+    uint32_t mask = atomic_load_explicit(&p->slot->device_mask, memory_order_relaxed);
+    for (int d = 0; d < INJECT_MAX_DEVICES; d++) {
+        if (mask & (1u << d)) continue;
+        snprintf(p->slot->names[d], INJECT_NAME_SIZE, "%s", label ? label : "virtual");
+        atomic_store_explicit(&p->slot->device_mask, mask | (1u << d), memory_order_release);
+        return d;
+    }
+    return -1;
+}
+
+void inject_producer_remove_device(inject_producer_t* p, int device) {
+    if (!p->slot || device < 0 || device >= INJECT_MAX_DEVICES) return;
+    uint32_t mask = atomic_load_explicit(&p->slot->device_mask, memory_order_relaxed);
+    atomic_store_explicit(&p->slot->device_mask, mask & ~(1u << device), memory_order_release);
+}
+
+bool inject_producer_push(inject_producer_t* p, int device, int32_t dx, int32_t dy) {
+    inject_slot_t* slot = p->slot;
+    if (!slot) return false;
+    uint64_t head = atomic_load_explicit(&slot->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&slot->tail, memory_order_acquire);
+    if (head - tail >= INJECT_RING_FRAMES) {
+        // Only this producer writes the counter
+        atomic_store_explicit(&slot->full_count, atomic_load_explicit(&slot->full_count, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        return false;
+    }
+    slot->frames[head & RING_MASK] = (inject_frame_t){ (uint32_t)device, dx, dy, 0 };
+    atomic_store_explicit(&slot->head, head + 1, memory_order_release);
+    return true;
+}
+
+void inject_producer_detach(inject_producer_t* p) {
+    inject_slot_t* slot = p->slot;
+    if (!slot) return;
+    // Give the main loop a few ticks to take what is queued
+    for (int i = 0; i < 100; i++) {
+        if (atomic_load_explicit(&slot->tail, memory_order_acquire) == atomic_load_explicit(&slot->head, memory_order_relaxed)) break;
+        struct timespec pause = { 0, 1000000 };
+        nanosleep(&pause, NULL);
+    }
+    atomic_store_explicit(&slot->device_mask, 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->state, INJECT_SLOT_DETACHING, memory_order_release);
+    munmap(p->shm, sizeof(inject_shm_t));
+    p->shm = NULL;
+    p->slot = NULL;
+    p->index = -1;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Virtual mice from other local processes (web bridges, scripted tests,
+// accessibility switches) delivered through a POSIX shared memory object.
+//
+// The object holds INJECT_MAX_PRODUCERS slots. A producer claims one slot,
+// registers up to INJECT_MAX_DEVICES virtual devices in it and pushes delta
+// frames into the slot's single-producer/single-consumer ring. The main loop
+// drains every ring once per fusion tick and feeds the frames to the same
+// input path as evdev devices. Neither side makes a syscall per event.
+//
+// Back-pressure: a push into a full ring fails and is counted; the producer
+// decides whether to retry, coalesce or drop. Slots of producers that exit
+// without detaching are reclaimed by the main loop.
+
+#define INJECT_SHM_NAME "/threeblindmice-inject"
+#define INJECT_SHM_MAGIC 0x4A4D4254u // "TBMJ"
+#define INJECT_SHM_VERSION 2
+#define INJECT_MAX_PRODUCERS 8
+#define INJECT_MAX_DEVICES 16
+#define INJECT_NAME_SIZE 32
+#define INJECT_RING_FRAMES 4096   // power of two
+
+// Virtual device ids never collide with evdev device indices
+#define INJECT_DEVICE_ID(slot, device) (0x80000000u | ((uint32_t)(slot) << 8) | (uint32_t)(device))
+
+enum {
+    INJECT_SLOT_FREE = 0,
+    INJECT_SLOT_CLAIMED = 1,   // producer is resetting the slot
+    INJECT_SLOT_ACTIVE = 2,
+    INJECT_SLOT_DETACHING = 3  // producer left; the consumer empties the ring and frees the slot
+};
+
+typedef struct {
+    uint32_t device;   // index within the producer's slot
+    int32_t dx, dy;
+    uint32_t reserved;
+} inject_frame_t;
+
+typedef struct {
+    _Atomic uint32_t state;
+    _Atomic uint32_t owner_pid;
+    _Atomic uint32_t device_mask;             // registered devices
+    uint32_t reserved;
+    _Atomic uint64_t full_count;              // pushes refused because the ring was full
+    char names[INJECT_MAX_DEVICES][INJECT_NAME_SIZE];
+    // Producer and consumer indices on separate cache lines
+    _Alignas(64) _Atomic uint64_t head;       // next frame to write (producer)
+    _Alignas(64) _Atomic uint64_t tail;       // next frame to read (consumer)
+    _Alignas(64) inject_frame_t frames[INJECT_RING_FRAMES];
+} inject_slot_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                            // sizeof(inject_shm_t)
+    uint32_t consumer_pid;
+    _Alignas(64) inject_slot_t slots[INJECT_MAX_PRODUCERS];
+} inject_shm_t;
+
+// Consumer (main loop)
+bool inject_shm_open(void);
+void inject_shm_close(void);
+const char* inject_shm_name(void);
+// Frames handed over per drain callback, as parallel arrays
+#define INJECT_DRAIN_BATCH 256
+// device_ids are INJECT_DEVICE_IDs; dx and dy may be modified in place
+typedef void (*inject_shm_deliver_t)(const uint32_t* device_ids, int32_t* dx, int32_t* dy, size_t count);
+// Deliver queued frames in batches of up to INJECT_DRAIN_BATCH; returns frames delivered.
+// Also reclaims slots of producers that have exited (checked about once a second).
+size_t inject_shm_drain(inject_shm_deliver_t deliver);
+// Registered virtual devices over all slots
+int inject_shm_device_count(void);
+
+// Producer (other processes)
+typedef struct {
+    inject_shm_t* shm;
+    inject_slot_t* slot;
+    int index;
+} inject_producer_t;
+
+// name NULL: $THREEBLINDMICE_INJECT_SHM or INJECT_SHM_NAME
+bool inject_producer_attach(inject_producer_t* p, const char* name);
+// Returns the device index (0..INJECT_MAX_DEVICES-1) or -1 when the slot is full
+int inject_producer_add_device(inject_producer_t* p, const char* label);
+void inject_producer_remove_device(inject_producer_t* p, int device);
+// False when the ring is full (back-pressure)
+bool inject_producer_push(inject_producer_t* p, int device, int32_t dx, int32_t dy);
+// Waits briefly for queued frames to be consumed, then hands the slot back
+// to the consumer, which frees it on its next drain. Only the consumer
+// writes tail.
+void inject_producer_detach(inject_producer_t* p);
+
+#ifdef __cplusplus
+}
+#endif
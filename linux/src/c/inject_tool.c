@@ -0,0 +1,67 @@
+#include "inject_shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Feeds virtual mice to a running instance through the shared-memory
+// injection rings. Each stdin line "LABEL DX DY" moves the virtual device
+// named LABEL, registering it on first use. Useful for scripted tests and
+// for bridging other input sources without touching uinput.
+
+#define MAX_LABELS INJECT_MAX_DEVICES
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [--shm NAME]\n"
+            "  Reads \"LABEL DX DY\" lines from stdin and injects each as a motion\n"
+            "  frame of virtual device LABEL (up to %d devices). When the ring is\n"
+            "  full the tool waits for the main loop instead of dropping frames.\n"
+            "  NAME defaults to $THREEBLINDMICE_INJECT_SHM or %s.\n",
+            argv0, INJECT_MAX_DEVICES, INJECT_SHM_NAME);
+}
+
+int main(int argc, char** argv) {
+    const char* name = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) name = argv[++i];
+        else { usage(argv[0]); return 2; }
+    }
+    inject_producer_t producer;
+    if (!inject_producer_attach(&producer, name)) {
+        fprintf(stderr, "❌ Cannot attach to the injection rings (is ThreeBlindMice running? all slots taken?)\n");
+        return 1;
+    }
+    fprintf(stderr, "💉 Attached to injection slot %d\n", producer.index);
+
+    char labels[MAX_LABELS][INJECT_NAME_SIZE];
+    int devices[MAX_LABELS];
+    int label_count = 0;
+    unsigned long long frames = 0, waits = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), stdin)) {
+        char label[INJECT_NAME_SIZE];
+        int dx, dy;
+        if (sscanf(line, "%31s %d %d", label, &dx, &dy) != 3) continue;
+        int device = -1;
+        for (int i = 0; i < label_count && device < 0; i++) if (strcmp(labels[i], label) == 0) device = devices[i];
+        if (device < 0) {
+            if (label_count == MAX_LABELS || (device = inject_producer_add_device(&producer, label)) < 0) {
+                fprintf(stderr, "⚠️  No room for device %s\n", label);
+                continue;
+            }
+            snprintf(labels[label_count], sizeof(labels[0]), "%s", label);
+            devices[label_count++] = device;
+        }
+        // Back-pressure: the consumer drains every tick, so a short sleep suffices
+        while (!inject_producer_push(&producer, device, dx, dy)) {
+            struct timespec pause = { 0, 1000000 };
+            nanosleep(&pause, NULL);
+            waits++;
+        }
+        frames++;
+    }
+    inject_producer_detach(&producer);
+    fprintf(stderr, "✅ Injected %llu frames (%llu waits on a full ring)\n", frames, waits);
+    return 0;
+}
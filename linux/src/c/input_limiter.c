@@ -0,0 +1,199 @@
+#include "input_limiter.h"
+#include "metrics.h"
+#include <string.h>
+
+// id -> slot index size, kept below ~60% full
+#define INDEX_BITS 13
+#define INDEX_MASK ((1u << INDEX_BITS) - 1)
+// Buckets idle this long are dropped; a new one starts full, which is
+// where an idle bucket would be anyway
+#define IDLE_US 10000000ull
+#define SWEEP_PER_FLUSH 64
+
+typedef struct {
+    uint32_t id;
+    bool present;
+    bool pending;
+    mouse_frame_t frame;    // pending frame
+    double tokens;
+    uint64_t last_us;
+    uint64_t admitted, coalesced;
+} bucket_t;
+
+static bucket_t s_buckets[INPUT_LIMITER_MAX_DEVICES];
+static uint16_t s_index[1u << INDEX_BITS];   // slot + 1, 0 = empty
+static int s_slots = 0;                      // slots in use lie below this
+static int s_count = 0;
+static uint16_t s_pending[INPUT_LIMITER_MAX_DEVICES];
+static int s_pending_count = 0;
+static int s_sweep = 0;
+static double s_rate = 0.0;     // tokens per microsecond
+static double s_burst = INPUT_LIMITER_DEFAULT_BURST;
+static input_limiter_deliver_t s_deliver = NULL;
+
+static uint32_t bucket_home(uint32_t id) {
+    return (id * 0x9E3779B1u) >> (32 - INDEX_BITS);
+}
+
+void input_limiter_init(double rate_hz, double burst, input_limiter_deliver_t deliver) {
+    memset(s_buckets, 0, sizeof(s_buckets));
+    memset(s_index, 0, sizeof(s_index));
+    s_slots = s_count = s_pending_count = s_sweep = 0;
+    s_rate = rate_hz > 0.0 ? rate_hz / 1e6 : 0.0;
+    s_burst = burst >= 1.0 ? burst : 1.0;
+    s_deliver = deliver;
+}
+
+static bucket_t* find_bucket(uint32_t id, uint32_t* at) {
+    uint32_t h = bucket_home(id);
+    for (; s_index[h]; h = (h + 1) & INDEX_MASK) {
+        bucket_t* b = &s_buckets[s_index[h] - 1];
+        if (b->id == id) { if (at) *at = h; return b; }
+    }
+    if (at) *at = h;
+    return NULL;
+}
+
+static bucket_t* get_bucket(uint32_t id, uint64_t now_us) {
+    uint32_t h;
+    bucket_t* b = find_bucket(id, &h);
+    if (b) return b;
+    for (int i = 0; i < INPUT_LIMITER_MAX_DEVICES; i++) if (!s_buckets[i].present) {
+        b = &s_buckets[i];
+        s_index[h] = (uint16_t)(i + 1);
+        if (i >= s_slots) s_slots = i + 1;
+        s_count++;
+        *b = (bucket_t){ .id = id, .present = true, .tokens = s_burst, .last_us = now_us };
+        return b;
+    }
+    return NULL;
+}
+
+static void remove_bucket(uint32_t h) {
+    s_buckets[s_index[h] - 1].present = false;
+    s_count--;
+    while (s_slots > 0 && !s_buckets[s_slots - 1].present) s_slots--;
+    // Backward-shift deletion, as in the fusion tables
+    uint32_t hole = h;
+    for (uint32_t j = (h + 1) & INDEX_MASK; s_index[j]; j = (j + 1) & INDEX_MASK) {
+        uint32_t home = bucket_home(s_buckets[s_index[j] - 1].id);
+        bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (stays) continue;
+        s_index[hole] = s_index[j];
+        hole = j;
+    }
+    s_index[hole] = 0;
+}
+
+static void refill(bucket_t* b, uint64_t now_us) {
+    if (now_us > b->last_us) {
+        b->tokens += (double)(now_us - b->last_us) * s_rate;
+        if (b->tokens > s_burst) b->tokens = s_burst;
+    }
+    b->last_us = now_us;
+}
+
+static void deliver_pending(bucket_t* b) {
+    b->pending = false;
+    const mouse_frame_t* f = &b->frame;
+    if (f->dx != 0 || f->dy != 0 || f->wheel != 0 || f->hwheel != 0) s_deliver(b->id, f);
+    b->frame = (mouse_frame_t){ 0 };
+}
+
+static void unlist_pending(bucket_t* b) {
+    uint16_t slot = (uint16_t)(b - s_buckets);
+    for (int i = 0; i < s_pending_count; i++) if (s_pending[i] == slot) {
+        s_pending[i] = s_pending[--s_pending_count];
+        break;
+    }
+}
+
+void input_limiter_submit(uint32_t device_id, const mouse_frame_t* frame) {
+    if (s_rate <= 0.0) { s_deliver(device_id, frame); return; }
+    uint64_t now_us = metrics_now_us();
+    bucket_t* b = get_bucket(device_id, now_us);
+    // A full table fails open: limiting is an optimisation, motion is not optional
+    if (!b) { s_deliver(device_id, frame); return; }
+    refill(b, now_us);
+    if (frame->changed) {
+        // Clicks go out at once, behind whatever motion was held back, so
+        // they land where the pointer was meant to be
+        if (b->pending) { deliver_pending(b); unlist_pending(b); }
+        if (b->tokens >= 1.0) b->tokens -= 1.0;
+        b->admitted++;
+        s_deliver(device_id, frame);
+        return;
+    }
+    if (!b->pending && b->tokens >= 1.0) {
+        b->tokens -= 1.0;
+        b->admitted++;
+        s_deliver(device_id, frame);
+        return;
+    }
+    // Over budget, or already waiting: fold into the pending frame so the
+    // device's frames stay in order
+    if (!b->pending) {
+        b->pending = true;
+        b->frame = (mouse_frame_t){ 0 };
+        s_pending[s_pending_count++] = (uint16_t)(b - s_buckets);
+    }
+    b->frame.dx += frame->dx;
+    b->frame.dy += frame->dy;
+    b->frame.wheel += frame->wheel;
+    b->frame.hwheel += frame->hwheel;
+    b->frame.buttons = frame->buttons;
+    b->coalesced++;
+    metrics_count(METRIC_INPUT_COALESCED, 1);
+    metrics_device_coalesced(device_id, 1);
+}
+
+void input_limiter_submit_motion(uint32_t device_id, int32_t dx, int32_t dy) {
+    mouse_frame_t frame = { .dx = dx, .dy = dy };
+    input_limiter_submit(device_id, &frame);
+}
+
+void input_limiter_flush(void) {
+    for (int i = 0; i < s_pending_count; i++) deliver_pending(&s_buckets[s_pending[i]]);
+    s_pending_count = 0;
+    if (s_slots == 0) return;
+    uint64_t now_us = metrics_now_us();
+    for (int n = 0; n < SWEEP_PER_FLUSH && s_slots > 0; n++) {
+        if (s_sweep >= s_slots) s_sweep = 0;
+        bucket_t* b = &s_buckets[s_sweep++];
+        uint32_t h;
+        if (b->present && !b->pending && now_us - b->last_us > IDLE_US && find_bucket(b->id, &h)) remove_bucket(h);
+    }
+}
+
+void input_limiter_forget(uint32_t device_id) {
+    uint32_t h;
+    bucket_t* b = find_bucket(device_id, &h);
+    if (!b) return;
+    if (b->pending) {
+        deliver_pending(b);
+        unlist_pending(b);
+    }
+    remove_bucket(h);
+}
+
+double input_limiter_rate(void) {
+    return s_rate * 1e6;
+}
+
+int input_limiter_device_count(void) {
+    return s_count;
+}
+
+int input_limiter_list(input_limiter_device_t* out, int max) {
+    int n = 0;
+    uint64_t now_us = metrics_now_us();
+    for (int i = 0; i < s_slots && n < max; i++) if (s_buckets[i].present) {
+        const bucket_t* b = &s_buckets[i];
+        // Read-only refill, so listing does not keep idle buckets alive
+        double tokens = b->tokens + (now_us > b->last_us ? (double)(now_us - b->last_us) * s_rate : 0.0);
+        if (tokens > s_burst) tokens = s_burst;
+        out[n++] = (input_limiter_device_t){ .id = b->id, .tokens = tokens, .admitted = b->admitted,
+                                             .coalesced = b->coalesced, .pending = b->pending };
+    }
+    return n;
+}
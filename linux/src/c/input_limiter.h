@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "mouse_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-device admission control between the input sources (evdev, injection
+// rings, remote mice) and the fusion loop.
+//
+// Each device has a token bucket refilled at the configured frame rate.
+// A frame that finds a token is delivered at once; one that does not is
+// added to the device's pending frame instead. Pending frames are delivered
+// by input_limiter_flush() at the top of every tick, so the fusion loop sees
+// the same motion and scroll sums, just in fewer frames: a device costs at
+// most rate + tick rate deliveries (audit records, metrics) per second
+// however fast it reports, plus its button transitions. Nothing is ever
+// dropped; frames that press or release a button are never coalesced.
+
+#define INPUT_LIMITER_DEFAULT_HZ 1000
+#define INPUT_LIMITER_DEFAULT_BURST 16
+// Every device fusion can track; beyond that frames pass unlimited
+#define INPUT_LIMITER_MAX_DEVICES 4608
+
+typedef void (*input_limiter_deliver_t)(uint32_t device_id, const mouse_frame_t* frame);
+
+typedef struct {
+    uint32_t id;
+    double tokens;
+    uint64_t admitted;     // frames delivered as they came
+    uint64_t coalesced;    // frames folded into a pending frame
+    bool pending;
+} input_limiter_device_t;
+
+// rate_hz <= 0 disables limiting: every frame is delivered as it comes
+void input_limiter_init(double rate_hz, double burst, input_limiter_deliver_t deliver);
+void input_limiter_submit(uint32_t device_id, const mouse_frame_t* frame);
+// Motion-only frame, for sources without wheels or buttons
+void input_limiter_submit_motion(uint32_t device_id, int32_t dx, int32_t dy);
+// Deliver every pending frame; call once per tick before fusing
+void input_limiter_flush(void);
+// Deliver the device's pending frame, then drop its bucket
+void input_limiter_forget(uint32_t device_id);
+
+double input_limiter_rate(void);
+int input_limiter_device_count(void);
+// Copies up to max devices' budgets; returns how many were written
+int input_limiter_list(input_limiter_device_t* out, int max);
+
+#ifdef __cplusplus
+}
+#endif
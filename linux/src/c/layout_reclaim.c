@@ -0,0 +1,108 @@
+#include "layout_reclaim.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Slot value of an unregistered reader
+#define SLOT_FREE UINT64_MAX
+
+typedef struct RetiredBlock {
+    void* block;
+    uint64_t generation;
+    struct RetiredBlock* next;
+} RetiredBlock;
+
+// Generation each registered reader last reported; 0 until its first report
+// protects everything
+static _Atomic uint64_t s_seen[LAYOUT_RECLAIM_MAX_READERS] = {
+    SLOT_FREE, SLOT_FREE, SLOT_FREE, SLOT_FREE, SLOT_FREE, SLOT_FREE, SLOT_FREE, SLOT_FREE
+};
+
+// Guards the retired list; short readers hold it while they copy
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static RetiredBlock* s_retired = NULL;
+static atomic_bool s_pending = false;
+
+int layout_reclaim_register(void) {
+    for (int i = 0; i < LAYOUT_RECLAIM_MAX_READERS; i++) {
+        uint64_t expected = SLOT_FREE;
+        if (!atomic_compare_exchange_strong(&s_seen[i], &expected, 0)) continue;
+        // The slot must be visible before the reader's first load of the
+        // shared pointer, or a collect could miss it (pairs with the fence
+        // in layout_reclaim_collect)
+        atomic_thread_fence(memory_order_seq_cst);
+        return i;
+    }
+    return -1;
+}
+
+void layout_reclaim_unregister(int reader) {
+    if (reader < 0 || reader >= LAYOUT_RECLAIM_MAX_READERS) return;
+    atomic_store_explicit(&s_seen[reader], SLOT_FREE, memory_order_release);
+}
+
+void layout_reclaim_seen(int reader, uint64_t generation) {
+    if (reader < 0 || reader >= LAYOUT_RECLAIM_MAX_READERS) return;
+    // Only the owner writes its slot
+    if (generation > atomic_load_explicit(&s_seen[reader], memory_order_relaxed)) {
+        atomic_store_explicit(&s_seen[reader], generation, memory_order_release);
+    }
+}
+
+void layout_reclaim_read_begin(void) {
+    pthread_mutex_lock(&s_lock);
+}
+
+void layout_reclaim_read_end(void) {
+    pthread_mutex_unlock(&s_lock);
+}
+
+bool layout_reclaim_retire(void* block, uint64_t generation) {
+    RetiredBlock* retired = malloc(sizeof(RetiredBlock));
+    if (!retired) return false;
+    retired->block = block;
+    retired->generation = generation;
+    pthread_mutex_lock(&s_lock);
+    retired->next = s_retired;
+    s_retired = retired;
+    atomic_store_explicit(&s_pending, true, memory_order_relaxed);
+    pthread_mutex_unlock(&s_lock);
+    return true;
+}
+
+static void collect(layout_reclaim_free_t free_block, bool force) {
+    pthread_mutex_lock(&s_lock);
+    // Slots are read after the swap that retired the blocks (pairs with the
+    // fence in layout_reclaim_register)
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < LAYOUT_RECLAIM_MAX_READERS; i++) {
+        uint64_t seen = atomic_load_explicit(&s_seen[i], memory_order_acquire);
+        if (seen < oldest) oldest = seen;
+    }
+    RetiredBlock** link = &s_retired;
+    while (*link) {
+        RetiredBlock* retired = *link;
+        if (force || retired->generation < oldest) {
+            *link = retired->next;
+            free_block(retired->block);
+            free(retired);
+        } else {
+            link = &retired->next;
+        }
+    }
+    atomic_store_explicit(&s_pending, s_retired != NULL, memory_order_relaxed);
+    pthread_mutex_unlock(&s_lock);
+}
+
+void layout_reclaim_collect(layout_reclaim_free_t free_block) {
+    collect(free_block, false);
+}
+
+void layout_reclaim_drain(layout_reclaim_free_t free_block) {
+    collect(free_block, true);
+}
+
+bool layout_reclaim_pending(void) {
+    return atomic_load_explicit(&s_pending, memory_order_relaxed);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Deferred freeing of replaced display layouts (any generation-stamped
+// block). One publisher swaps blocks into an atomic pointer and retires the
+// old ones here. Readers on other threads come in two kinds:
+//
+// - Readers that keep a block between calls (the fusion loop holds
+//   fusion_t.layout across ticks, the GUI across frames) register a slot
+//   and report the generation they switched to. A retired block is freed
+//   only once every registered reader has reported a newer generation.
+// - Readers that copy something out and let go bracket the access with
+//   layout_reclaim_read_begin/end; nothing is freed in between.
+//
+// There is no timeout: a reader that stalls keeps what it holds.
+
+#define LAYOUT_RECLAIM_MAX_READERS 8
+
+typedef void (*layout_reclaim_free_t)(void* block);
+
+// Register before the first load of the shared pointer. Returns the reader
+// slot, or -1 when all are taken (use read_begin/end instead).
+int layout_reclaim_register(void);
+void layout_reclaim_unregister(int reader);
+// The reader now holds nothing older than generation
+void layout_reclaim_seen(int reader, uint64_t generation);
+
+void layout_reclaim_read_begin(void);
+void layout_reclaim_read_end(void);
+
+// Publisher: hand over a block swapped out of the shared pointer. False on
+// allocation failure; the block is then leaked rather than freed under a reader.
+bool layout_reclaim_retire(void* block, uint64_t generation);
+// Publisher: free retired blocks no reader can still hold
+void layout_reclaim_collect(layout_reclaim_free_t free_block);
+// Free every retired block; only once no reader is left
+void layout_reclaim_drain(layout_reclaim_free_t free_block);
+bool layout_reclaim_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,188 @@
+#include "layout_reclaim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+
+// Stress check of layout reclamation with two registered readers: one that
+// keeps a block across stalls of up to STALL_MAX_MS, as the fusion loop keeps
+// its layout across blocking calls, and one that copies and acknowledges
+// every frame, as the GUI does. A third thread uses the short read section
+// of the one-shot getters. A publisher swaps blocks in as fast as it can.
+// Freed blocks are poisoned, so any block freed under a reader shows up as a
+// payload mismatch (and as a use-after-free under -fsanitize=address).
+
+#define PAYLOAD_WORDS 64
+#define STALL_MAX_MS 20
+#define POISON 0xdddddddddddddddduLL
+
+typedef struct {
+    uint64_t generation;
+    uint64_t payload[PAYLOAD_WORDS];
+} Block;
+
+static _Atomic(Block*) s_current = NULL;
+static atomic_bool s_stop = false;
+static atomic_long s_errors = 0;
+static atomic_long s_freed = 0;
+static atomic_long s_holder_reads = 0, s_copier_reads = 0, s_getter_reads = 0;
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [--seconds N]\n"
+            "  Publishes layouts for N seconds (default 3) against a holding reader,\n"
+            "  a copying reader and a getter; fails if any reads freed memory.\n",
+            argv0);
+}
+
+static void sleep_us(long us) {
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+static uint32_t next_random(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static Block* make_block(uint64_t generation) {
+    Block* block = malloc(sizeof(Block));
+    if (!block) return NULL;
+    block->generation = generation;
+    for (int i = 0; i < PAYLOAD_WORDS; i++) block->payload[i] = generation;
+    return block;
+}
+
+static void free_block(void* ptr) {
+    Block* block = ptr;
+    block->generation = POISON;
+    for (int i = 0; i < PAYLOAD_WORDS; i++) block->payload[i] = POISON;
+    free(block);
+    atomic_fetch_add(&s_freed, 1);
+}
+
+static bool check_block(const Block* block, const char* who) {
+    uint64_t generation = block->generation;
+    for (int i = 0; i < PAYLOAD_WORDS; i++) {
+        if (block->payload[i] != generation || generation == POISON) {
+            if (atomic_fetch_add(&s_errors, 1) == 0) {
+                printf("❌ %s read a freed layout (generation %llu, word %d = %llx)\n",
+                       who, (unsigned long long)generation, i, (unsigned long long)block->payload[i]);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+// Like the fusion loop: switches to the newest block, acknowledges it, then
+// keeps using it across a stall before looking again
+static void* holder_thread(void* arg) {
+    (void)arg;
+    uint32_t rng = 0x9e3779b9u;
+    int reader = layout_reclaim_register();
+    if (reader < 0) { atomic_fetch_add(&s_errors, 1); return NULL; }
+    while (!atomic_load(&s_stop)) {
+        Block* held = atomic_load_explicit(&s_current, memory_order_acquire);
+        layout_reclaim_seen(reader, held->generation);
+        int passes = 1 + (int)(next_random(&rng) % 4);
+        for (int i = 0; i < passes; i++) {
+            check_block(held, "holding reader");
+            uint32_t r = next_random(&rng);
+            sleep_us(r % 8 == 0 ? (long)(r % (STALL_MAX_MS * 1000)) : (long)(r % 200));
+            check_block(held, "holding reader");
+        }
+        atomic_fetch_add(&s_holder_reads, 1);
+    }
+    layout_reclaim_unregister(reader);
+    return NULL;
+}
+
+// Like the GUI: copies the newest block, then acknowledges it
+static void* copier_thread(void* arg) {
+    (void)arg;
+    int reader = layout_reclaim_register();
+    if (reader < 0) { atomic_fetch_add(&s_errors, 1); return NULL; }
+    Block copy;
+    while (!atomic_load(&s_stop)) {
+        const Block* block = atomic_load_explicit(&s_current, memory_order_acquire);
+        memcpy(&copy, block, sizeof(copy));
+        layout_reclaim_seen(reader, copy.generation);
+        check_block(&copy, "copying reader");
+        atomic_fetch_add(&s_copier_reads, 1);
+        sleep_us(50);
+    }
+    layout_reclaim_unregister(reader);
+    return NULL;
+}
+
+// Like the display_manager_get_* getters: no slot, a short read section
+static void* getter_thread(void* arg) {
+    (void)arg;
+    while (!atomic_load(&s_stop)) {
+        layout_reclaim_read_begin();
+        check_block(atomic_load_explicit(&s_current, memory_order_acquire), "getter");
+        layout_reclaim_read_end();
+        atomic_fetch_add(&s_getter_reads, 1);
+        sleep_us(20);
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    int seconds = 3;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atoi(argv[++i]);
+        else { usage(argv[0]); return 2; }
+    }
+    if (seconds <= 0) { usage(argv[0]); return 2; }
+
+    uint64_t generation = 1;
+    atomic_store(&s_current, make_block(generation));
+    if (!atomic_load(&s_current)) { printf("❌ Out of memory\n"); return 1; }
+
+    pthread_t threads[3];
+    void* (*bodies[3])(void*) = { holder_thread, copier_thread, getter_thread };
+    for (int i = 0; i < 3; i++) {
+        if (pthread_create(&threads[i], NULL, bodies[i], NULL) != 0) { printf("❌ Failed to start reader\n"); return 1; }
+    }
+
+    // Publisher, as the RandR watcher: swap, retire, collect
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long pending_max = 0;
+    do {
+        Block* block = make_block(++generation);
+        if (!block) { printf("❌ Out of memory\n"); return 1; }
+        Block* old = atomic_exchange_explicit(&s_current, block, memory_order_acq_rel);
+        if (!layout_reclaim_retire(old, old->generation)) { printf("❌ Out of memory\n"); return 1; }
+        layout_reclaim_collect(free_block);
+        long pending = (long)(generation - 1) - atomic_load(&s_freed);
+        if (pending > pending_max) pending_max = pending;
+        if (generation % 64 == 0) sleep_us(100);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while (now.tv_sec - start.tv_sec < seconds);
+
+    atomic_store(&s_stop, true);
+    for (int i = 0; i < 3; i++) pthread_join(threads[i], NULL);
+    layout_reclaim_drain(free_block);
+    free_block(atomic_exchange(&s_current, NULL));
+
+    printf("🔁 %llu layouts published, %ld retired at most at once\n", (unsigned long long)generation, pending_max);
+    printf("   reads: holding %ld, copying %ld, getter %ld\n",
+           atomic_load(&s_holder_reads), atomic_load(&s_copier_reads), atomic_load(&s_getter_reads));
+    if (atomic_load(&s_errors)) {
+        printf("❌ %ld reads of freed layouts\n", atomic_load(&s_errors));
+        return 1;
+    }
+    if (atomic_load(&s_freed) != (long)generation) {
+        printf("❌ %ld of %llu layouts freed\n", atomic_load(&s_freed), (unsigned long long)generation);
+        return 1;
+    }
+    printf("✅ No reader saw a freed layout\n");
+    return 0;
+}
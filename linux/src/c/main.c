@@ -4,132 +4,422 @@
  #include <stdbool.h>
  #include <string.h>
  #include <time.h>
+ #include <errno.h>
+ #include <math.h>
  #include <unistd.h>
- #include <pthread.h>
+ #include <poll.h>
+ #include <sys/stat.h>
+ #include <sys/timerfd.h>
  #include "evdev_manager.h"
  #include "display_manager.h"
 #include "gui.h"
 #include "tray.h"
 #include "hipaa.h"
+#include "control_socket.h"
+#include "metrics.h"
+#include "state_shm.h"
+#include "inject_shm.h"
+#include "net_ingest.h"
+#include "state_stream.h"
+#include "fusion.h"
+#include "input_limiter.h"
+#include "device_transform.h"
+#include "pointer_accel.h"
 
- #define MAX_MICE 128
-
- typedef struct MouseState {
-     uint32_t id;
-     int32_t pos_x;
-     int32_t pos_y;
-     int32_t delta_x;
-     int32_t delta_y;
-     double  weight;
-     int64_t last_activity_ms;
-     bool    active;
-     bool    present;
- } MouseState;
-
- static MouseState g_mice[MAX_MICE];
- static volatile bool g_use_individual = false;
- static volatile uint32_t g_active_mouse = 0;
- static int32_t g_host_x = 960;
- static int32_t g_host_y = 540;
- static double  g_smoothing = 0.7; // similar to Swift
- static int32_t g_total_w = 1920, g_total_h = 1080, g_total_x = 0, g_total_y = 0;
+ #define MAX_MOUSE_FDS 16
+ #define MICE_REPLY_MAX 512
+ #define TICK_NS 5000000L // ~200 Hz
+
+ // Mice, weights and the host cursor; the display layout is refreshed from the
+ // RandR watcher's published snapshot at the top of every tick (no X round trips)
+ static fusion_t g_fusion;
+ static int g_layout_reader = -1;
+ static bool g_gui_threaded = false;
+ static int64_t g_start_ms = 0;
+ static uint64_t g_tick_count = 0;
 
  static int64_t now_ms(void) {
      struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
      return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
  }
 
- static MouseState* get_mouse(uint32_t id) {
-     for (int i = 0; i < MAX_MICE; i++) if (g_mice[i].present && g_mice[i].id == id) return &g_mice[i];
-     for (int i = 0; i < MAX_MICE; i++) if (!g_mice[i].present) {
-         g_mice[i].present = true;
-         g_mice[i].id = id;
-         g_mice[i].weight = 1.0;
-         g_mice[i].pos_x = g_total_x + g_total_w/2;
-         g_mice[i].pos_y = g_total_y + g_total_h/2;
-         g_mice[i].delta_x = g_mice[i].delta_y = 0;
-         g_mice[i].last_activity_ms = now_ms();
-         return &g_mice[i];
+ static void on_mouse_input(uint32_t device_id, const mouse_frame_t* frame) {
+     fusion_mouse_t* m = fusion_input_frame(&g_fusion, device_id, frame, now_ms());
+     if (!m) return;
+     metrics_count(METRIC_INPUT_EVENTS, 1);
+     metrics_device_event(device_id, frame->dx, frame->dy);
+     // The audit trail records motion; scroll and clicks are not logged
+    if (frame->dx != 0 || frame->dy != 0) hipaa_log_input(device_id, frame->dx, frame->dy, m->last_activity_ms);
+ }
+
+ // Ingestion stage shared by every source: the device's acceleration, its
+ // transform, then its rate limit
+ static void ingest_frame(uint32_t device_id, const mouse_frame_t* frame) {
+     mouse_frame_t f = *frame;
+     pointer_accel_apply(device_id, &f.dx, &f.dy);
+     device_transform_apply(device_id, &f.dx, &f.dy);
+     input_limiter_submit(device_id, &f);
+ }
+
+ static void ingest_motion(uint32_t device_id, int32_t dx, int32_t dy) {
+     pointer_accel_apply(device_id, &dx, &dy);
+     device_transform_apply(device_id, &dx, &dy);
+     input_limiter_submit_motion(device_id, dx, dy);
+ }
+
+ static void ingest_batch(const uint32_t* device_ids, int32_t* dx, int32_t* dy, size_t count) {
+     for (size_t i = 0; i < count; i++) pointer_accel_apply(device_ids[i], &dx[i], &dy[i]);
+     device_transform_batch(device_ids, dx, dy, count);
+     for (size_t i = 0; i < count; i++) input_limiter_submit_motion(device_ids[i], dx[i], dy[i]);
+ }
+
+ // Remote clients come and go; their slots are reused
+ static void forget_mouse(uint32_t id) {
+     input_limiter_forget(id);
+     fusion_forget_mouse(&g_fusion, id);
+ }
+
+ static void set_mode(bool individual) {
+     if (individual != g_fusion.individual) metrics_count(METRIC_MODE_SWITCHES, 1);
+     g_fusion.individual = individual;
+     tray_set_mode(g_fusion.individual ? "Individual" : "Fused");
+     gui_set_mode_text(g_fusion.individual ? "Mode: Individual" : "Mode: Fused");
+     printf("🔄 Mode switched to: %s\n", g_fusion.individual ? "Individual" : "Fused");
+ }
+
+ // Single-key commands on stdin, for interactive runs
+ static void handle_key(int c) {
+     if (c == 'm' || c == 'M') {
+         set_mode(!g_fusion.individual);
+     } else if (c == 'i' || c == 'I') {
+         printf("📊 Individual positions:\n");
+         for (int i = 0; i < g_fusion.slots; i++) if (g_fusion.mice[i].present) {
+             printf("  id=%u pos=(%d,%d) weight=%.2f\n", g_fusion.mice[i].id, g_fusion.mice[i].pos_x, g_fusion.mice[i].pos_y, g_fusion.mice[i].weight);
+         }
+     } else if (c == 'a' || c == 'A') {
+         printf("🎯 Active mouse: %u\n", g_fusion.active_mouse);
      }
-     return NULL;
  }
 
- static void clamp_to_bounds(int32_t* x, int32_t* y) {
-     if (*x < g_total_x) *x = g_total_x;
-     if (*y < g_total_y) *y = g_total_y;
-     if (*x > g_total_x + g_total_w - 1) *x = g_total_x + g_total_w - 1;
-     if (*y > g_total_y + g_total_h - 1) *y = g_total_y + g_total_h - 1;
+ static void reply_transform(control_reply_t* reply, uint32_t id, const device_transform_params_t* p) {
+     control_reply_printf(reply, "transform %u rotate=%.1f gain=%.3f flip=%s\n", id, p->rotation_deg, p->gain,
+                          p->flip_x ? (p->flip_y ? "xy" : "x") : (p->flip_y ? "y" : "none"));
  }
 
- static void on_mouse_input(uint32_t device_id, int32_t dx, int32_t dy) {
-     MouseState* m = get_mouse(device_id);
-     if (!m) return;
-     m->delta_x += dx;
-     m->delta_y += dy;
-     m->last_activity_ms = now_ms();
-    hipaa_log_input(device_id, dx, dy, m->last_activity_ms);
+ // Numbers in control commands must be the whole token and finite, like the IDs
+ static bool parse_double(const char* text, double* out) {
+     char* end = NULL;
+     errno = 0;
+     double v = strtod(text, &end);
+     if (end == text || *end || errno == ERANGE || !isfinite(v)) return false;
+     *out = v;
+     return true;
  }
 
- static void* keyboard_thread(void* arg) {
-     (void)arg;
-     while (1) {
-         int c = getchar();
-         if (c == EOF) { usleep(10000); continue; }
-         if (c == 'm' || c == 'M') {
-             g_use_individual = !g_use_individual;
-             tray_set_mode(g_use_individual ? "Individual" : "Fused");
-             printf("🔄 Mode switched to: %s\n", g_use_individual ? "Individual" : "Fused");
-         } else if (c == 'i' || c == 'I') {
-             printf("📊 Individual positions:\n");
-             for (int i = 0; i < MAX_MICE; i++) if (g_mice[i].present) {
-                 printf("  id=%u pos=(%d,%d) weight=%.2f\n", g_mice[i].id, g_mice[i].pos_x, g_mice[i].pos_y, g_mice[i].weight);
+ static bool parse_int(const char* text, int* out) {
+     char* end = NULL;
+     errno = 0;
+     long v = strtol(text, &end, 10);
+     if (end == text || *end || errno == ERANGE || v < INT32_MIN || v > INT32_MAX) return false;
+     *out = (int)v;
+     return true;
+ }
+
+ // transform ID [reset] [rotate DEG] [turn STEPS] [gain G] [flip none|x|y|xy]
+ // turn rotates by DEVICE_TRANSFORM_ROTATE_STEP per step, like the Swift
+ // managers' scroll gesture
+ static void handle_transform_command(const char* args, control_reply_t* reply) {
+     char buf[256];
+     snprintf(buf, sizeof(buf), "%s", args);
+     char* save = NULL;
+     char* tok = strtok_r(buf, " ", &save);
+     char* end = NULL;
+     unsigned long id = tok ? strtoul(tok, &end, 0) : 0;
+     if (!tok || *end || id > UINT32_MAX) { control_reply_error(reply, "usage: transform ID [reset] [rotate DEG] [turn STEPS] [gain G] [flip none|x|y|xy]"); return; }
+     device_transform_params_t p = device_transform_get((uint32_t)id);
+     while ((tok = strtok_r(NULL, " ", &save))) {
+         if (strcmp(tok, "reset") == 0) { p = (device_transform_params_t){ .gain = 1.0 }; continue; }
+         char* value = strtok_r(NULL, " ", &save);
+         if (!value) { control_reply_error(reply, "missing value"); return; }
+         double number = 0.0;
+         if (strcmp(tok, "flip") == 0) {
+             if (strcmp(value, "none") != 0 && strcmp(value, "x") != 0 && strcmp(value, "y") != 0 && strcmp(value, "xy") != 0) {
+                 control_reply_error(reply, "flip must be none, x, y or xy");
+                 return;
              }
-         } else if (c == 'a' || c == 'A') {
-             printf("🎯 Active mouse: %u\n", g_active_mouse);
-         }
+             p.flip_x = strchr(value, 'x') != NULL;
+             p.flip_y = strchr(value, 'y') != NULL;
+         } else if (strcmp(tok, "rotate") != 0 && strcmp(tok, "turn") != 0 && strcmp(tok, "gain") != 0) {
+             control_reply_error(reply, "unknown transform option");
+             return;
+         } else if (!parse_double(value, &number)) {
+             control_reply_error(reply, "invalid number");
+             return;
+         } else if (strcmp(tok, "rotate") == 0) p.rotation_deg = number;
+         else if (strcmp(tok, "turn") == 0) p.rotation_deg += number * DEVICE_TRANSFORM_ROTATE_STEP;
+         else p.gain = number;
      }
-     return NULL;
+     if (!device_transform_set((uint32_t)id, &p)) { control_reply_error(reply, "gain out of range or too many transforms"); return; }
+     p = device_transform_get((uint32_t)id);
+     reply_transform(reply, (uint32_t)id, &p);
  }
 
- static void update_weights(void) {
-     const int64_t timeout_ms = 2000;
-     int64_t t = now_ms();
-     for (int i = 0; i < MAX_MICE; i++) if (g_mice[i].present) {
-         int64_t dt = t - g_mice[i].last_activity_ms;
-         if (dt > timeout_ms) {
-             g_mice[i].weight = g_mice[i].weight * 0.9; if (g_mice[i].weight < 0.1) g_mice[i].weight = 0.1;
-         } else {
-             g_mice[i].weight = g_mice[i].weight * 1.1; if (g_mice[i].weight > 2.0) g_mice[i].weight = 2.0;
+ static void reply_accel(control_reply_t* reply, const char* who, const pointer_accel_config_t* c) {
+     control_reply_printf(reply, "accel %s profile=%s speed=%.2f cpi=%d\n", who, pointer_accel_profile_name(c->profile),
+                          c->speed, c->cpi);
+ }
+
+ // accel default|ID [reset] [profile flat|linear|adaptive] [speed -1..1] [cpi N]
+ static void handle_accel_command(const char* args, control_reply_t* reply) {
+     char buf[256];
+     snprintf(buf, sizeof(buf), "%s", args);
+     char* save = NULL;
+     char* who = strtok_r(buf, " ", &save);
+     char* end = NULL;
+     bool is_default = who && strcmp(who, "default") == 0;
+     unsigned long id = who && !is_default ? strtoul(who, &end, 0) : 0;
+     if (!who || (!is_default && (*end || id > UINT32_MAX))) {
+         control_reply_error(reply, "usage: accel default|ID [reset] [profile flat|linear|adaptive] [speed S] [cpi N]");
+         return;
+     }
+     pointer_accel_config_t c = pointer_accel_get_default();
+     if (!is_default) pointer_accel_get_device((uint32_t)id, &c, NULL);
+     bool reset = false, changed = false;
+     char* tok;
+     while ((tok = strtok_r(NULL, " ", &save))) {
+         if (strcmp(tok, "reset") == 0) { reset = true; continue; }
+         char* value = strtok_r(NULL, " ", &save);
+         if (!value) { control_reply_error(reply, "missing value"); return; }
+         changed = true;
+         if (strcmp(tok, "profile") == 0) {
+             if (!pointer_accel_parse_profile(value, &c.profile)) { control_reply_error(reply, "profile must be flat, linear or adaptive"); return; }
+         } else if (strcmp(tok, "speed") == 0) {
+             if (!parse_double(value, &c.speed)) { control_reply_error(reply, "invalid number"); return; }
+         } else if (strcmp(tok, "cpi") == 0) {
+             if (!parse_int(value, &c.cpi)) { control_reply_error(reply, "invalid number"); return; }
+         } else { control_reply_error(reply, "unknown accel option"); return; }
+     }
+     if (reset && is_default) c = (pointer_accel_config_t){ POINTER_ACCEL_FLAT, 0.0, POINTER_ACCEL_REFERENCE_CPI };
+     if (reset && !is_default) pointer_accel_reset_device((uint32_t)id);
+     if (changed || (reset && is_default)) {
+         bool ok = is_default ? pointer_accel_set_default(&c) : pointer_accel_set_device((uint32_t)id, &c);
+         if (!ok) { control_reply_error(reply, "speed must be -1..1, cpi 100..51200 (or too many devices)"); return; }
+     }
+     if (is_default) {
+         c = pointer_accel_get_default();
+         reply_accel(reply, "default", &c);
+     } else {
+         char label[16];
+         snprintf(label, sizeof(label), "%lu", id);
+         pointer_accel_get_device((uint32_t)id, &c, NULL);
+         reply_accel(reply, label, &c);
+     }
+ }
+
+ // Control socket commands; runs on the main loop, so state is read directly
+ static void handle_control_command(const char* line, control_reply_t* reply) {
+     metrics_count(METRIC_CONTROL_COMMANDS, 1);
+     const char* mode = g_fusion.individual ? "individual" : "fused";
+     if (strcmp(line, "mode") == 0) {
+         control_reply_printf(reply, "mode %s\n", mode);
+     } else if (strncmp(line, "mode ", 5) == 0) {
+         const char* arg = line + 5;
+         if (strcmp(arg, "individual") == 0) set_mode(true);
+         else if (strcmp(arg, "fused") == 0) set_mode(false);
+         else if (strcmp(arg, "toggle") == 0) set_mode(!g_fusion.individual);
+         else { control_reply_error(reply, "mode must be individual, fused or toggle"); return; }
+         control_reply_printf(reply, "mode %s\n", g_fusion.individual ? "individual" : "fused");
+     } else if (strcmp(line, "mice") == 0) {
+         int64_t t = now_ms();
+         int listed = 0;
+         for (int i = 0; i < g_fusion.slots; i++) if (g_fusion.mice[i].present) {
+             // With thousands of remote mice the full table would not fit a reply
+             if (listed++ == MICE_REPLY_MAX) { control_reply_printf(reply, "truncated %d\n", g_fusion.count); break; }
+             const fusion_mouse_t* m = &g_fusion.mice[i];
+             control_reply_printf(reply, "mouse %u x=%d y=%d weight=%.2f idle_ms=%lld display=%d\n", m->id, m->pos_x,
+                                  m->pos_y, m->weight, (long long)(t - m->last_activity_ms), m->display);
          }
+     } else if (strncmp(line, "transform ", 10) == 0) {
+         handle_transform_command(line + 10, reply);
+     } else if (strncmp(line, "accel ", 6) == 0) {
+         handle_accel_command(line + 6, reply);
+     } else if (strcmp(line, "accels") == 0) {
+         pointer_accel_config_t c = pointer_accel_get_default();
+         reply_accel(reply, "default", &c);
+         static uint32_t ids[POINTER_ACCEL_MAX_CONFIGURED];
+         int n = pointer_accel_list(ids, POINTER_ACCEL_MAX_CONFIGURED);
+         for (int i = 0; i < n; i++) {
+             char label[16];
+             snprintf(label, sizeof(label), "%u", ids[i]);
+             pointer_accel_get_device(ids[i], &c, NULL);
+             reply_accel(reply, label, &c);
+         }
+     } else if (strcmp(line, "transforms") == 0) {
+         static device_transform_info_t transforms[DEVICE_TRANSFORM_MAX];
+         int n = device_transform_list(transforms, DEVICE_TRANSFORM_MAX);
+         for (int i = 0; i < n; i++) reply_transform(reply, transforms[i].id, &transforms[i].params);
+     } else if (strcmp(line, "limits") == 0) {
+         // Token-bucket budget of every device that sent input recently
+         static input_limiter_device_t devices[INPUT_LIMITER_MAX_DEVICES];
+         int n = input_limiter_list(devices, INPUT_LIMITER_MAX_DEVICES);
+         control_reply_printf(reply, "rate_hz %.0f devices %d\n", input_limiter_rate(), n);
+         for (int i = 0; i < n; i++) {
+             if (i == MICE_REPLY_MAX) { control_reply_printf(reply, "truncated %d\n", n); break; }
+             control_reply_printf(reply, "device %u tokens=%.1f admitted=%llu coalesced=%llu pending=%d\n", devices[i].id,
+                                  devices[i].tokens, (unsigned long long)devices[i].admitted,
+                                  (unsigned long long)devices[i].coalesced, devices[i].pending ? 1 : 0);
+         }
+     } else if (strcmp(line, "active") == 0) {
+         control_reply_printf(reply, "active %u\n", g_fusion.active_mouse);
+     } else if (strcmp(line, "stats") == 0) {
+         control_reply_printf(reply, "uptime_ms %lld\n", (long long)(now_ms() - g_start_ms));
+         control_reply_printf(reply, "mode %s\n", mode);
+         control_reply_printf(reply, "mice %d\n", g_fusion.count);
+         control_reply_printf(reply, "active_mouse %u\n", g_fusion.active_mouse);
+         control_reply_printf(reply, "host %d %d\n", g_fusion.host_x, g_fusion.host_y);
+         control_reply_printf(reply, "input_events %llu\n", (unsigned long long)metrics_counter_total(METRIC_INPUT_EVENTS));
+         control_reply_printf(reply, "input_coalesced %llu\n", (unsigned long long)metrics_counter_total(METRIC_INPUT_COALESCED));
+         control_reply_printf(reply, "ticks %llu\n", (unsigned long long)metrics_counter_total(METRIC_TICKS));
+         control_reply_printf(reply, "tick_overruns %llu\n", (unsigned long long)metrics_counter_total(METRIC_TICK_OVERRUNS));
+         control_reply_printf(reply, "mode_switches %llu\n", (unsigned long long)metrics_counter_total(METRIC_MODE_SWITCHES));
+         control_reply_printf(reply, "audit_dropped %llu\n", (unsigned long long)hipaa_dropped_count());
+         control_reply_printf(reply, "control_clients %d\n", control_socket_client_count());
+         control_reply_printf(reply, "remote_clients %d\n", net_ingest_client_count());
+         control_reply_printf(reply, "control_commands %llu\n", (unsigned long long)metrics_counter_total(METRIC_CONTROL_COMMANDS));
+     } else if (strcmp(line, "metrics") == 0) {
+         // Prometheus text exposition, same as the textfile export
+         static char text[48 * 1024];
+         size_t len = metrics_render(text, sizeof(text));
+         if (len == 0) { control_reply_error(reply, "metrics too large"); return; }
+         control_reply_printf(reply, "%s", text);
+     } else if (strcmp(line, "help") == 0) {
+         control_reply_printf(reply, "commands: mode [individual|fused|toggle], mice, limits, transform ID ..., transforms, accel default|ID ..., accels, active, stats, metrics, help\n");
+     } else {
+         control_reply_error(reply, "unknown command (try help)");
+     }
+ }
+
+ // Hand the render thread the latest fused and per-mouse state
+ static void publish_gui_snapshot(void) {
+     static GuiSnapshot snap;
+     snap.host_x = (double)g_fusion.host_x;
+     snap.host_y = (double)g_fusion.host_y;
+     snap.individual = g_fusion.individual;
+     snap.active_mouse = g_fusion.active_mouse;
+     snap.now_ms = now_ms();
+     int32_t n = 0;
+     for (int i = 0; i < g_fusion.slots && n < GUI_MAX_MICE; i++) if (g_fusion.mice[i].present) {
+         GuiMouse* gm = &snap.mice[n++];
+         gm->id = g_fusion.mice[i].id;
+         gm->x = g_fusion.mice[i].pos_x;
+         gm->y = g_fusion.mice[i].pos_y;
+         gm->weight = (float)g_fusion.mice[i].weight;
+         gm->last_activity_ms = g_fusion.mice[i].last_activity_ms;
+     }
+     snap.mouse_count = n;
+     gui_publish(&snap);
+ }
+
+ // Fused and per-mouse state for other processes; readers never block this
+ static void publish_shared_state(void) {
+     state_shm_state_t* st = state_shm_begin();
+     if (!st) return;
+     st->tick = g_tick_count;
+     st->now_ms = now_ms();
+     st->host_x = g_fusion.host_x;
+     st->host_y = g_fusion.host_y;
+     st->host_display = g_fusion.host_display;
+     st->mode = g_fusion.individual ? STATE_SHM_MODE_INDIVIDUAL : STATE_SHM_MODE_FUSED;
+     st->active_mouse = g_fusion.active_mouse;
+     uint32_t n = 0, total = 0;
+     for (int i = 0; i < g_fusion.slots; i++) if (g_fusion.mice[i].present && total++ < STATE_SHM_MAX_MICE) {
+         state_shm_mouse_t* sm = &st->mice[n++];
+         sm->id = g_fusion.mice[i].id;
+         sm->x = g_fusion.mice[i].pos_x;
+         sm->y = g_fusion.mice[i].pos_y;
+         sm->weight = (float)g_fusion.mice[i].weight;
+         sm->display = g_fusion.mice[i].display;
+         sm->last_activity_ms = g_fusion.mice[i].last_activity_ms;
      }
+     st->mouse_count = n;
+     st->total_mice = total;
+     st->flags = total > n ? STATE_SHM_FLAG_TRUNCATED : 0;
+     state_shm_end();
  }
 
- static void apply_deltas_individual(uint32_t id) {
-     MouseState* m = get_mouse(id); if (!m) return;
-     g_active_mouse = id;
-     m->pos_x += m->delta_x; m->pos_y += m->delta_y;
-     m->delta_x = m->delta_y = 0;
-     clamp_to_bounds(&m->pos_x, &m->pos_y);
-     g_host_x = m->pos_x; g_host_y = m->pos_y;
+ // Observers on the state stream get a sample at the stream rate, not every tick
+ static void publish_state_stream(void) {
+     static state_stream_mouse_t mice[FUSION_MAX_MICE];
+     int64_t now = now_ms();
+     if (!state_stream_due(now)) return;
+     state_stream_sample_t sample = {
+         .tick = g_tick_count,
+         .now_ms = now,
+         .host_x = g_fusion.host_x,
+         .host_y = g_fusion.host_y,
+         .host_display = g_fusion.host_display,
+         .active_mouse = g_fusion.active_mouse,
+         .mode = g_fusion.individual ? STATE_SHM_MODE_INDIVIDUAL : STATE_SHM_MODE_FUSED,
+         .mice = mice,
+     };
+     uint32_t n = 0;
+     for (int i = 0; i < g_fusion.slots; i++) if (g_fusion.mice[i].present) {
+         state_stream_mouse_t* sm = &mice[n++];
+         sm->id = g_fusion.mice[i].id;
+         sm->x = g_fusion.mice[i].pos_x;
+         sm->y = g_fusion.mice[i].pos_y;
+         sm->weight = (uint16_t)(g_fusion.mice[i].weight * 10000.0 + 0.5);
+         sm->display = (int16_t)g_fusion.mice[i].display;
+     }
+     sample.mouse_count = n;
+     state_stream_publish(&sample);
  }
 
- static void apply_deltas_fused(void) {
-     double wx = 0.0, wy = 0.0, tw = 0.0;
-     for (int i = 0; i < MAX_MICE; i++) if (g_mice[i].present) {
-         wx += (double)g_mice[i].delta_x * g_mice[i].weight;
-         wy += (double)g_mice[i].delta_y * g_mice[i].weight;
-         tw += g_mice[i].weight;
+ static void tick(void) {
+     uint64_t start_us = metrics_now_us();
+     metrics_count(METRIC_TICKS, 1);
+     g_tick_count++;
+     // Virtual mice from other processes join the evdev input of this tick
+     inject_shm_drain(ingest_batch);
+     metrics_gauge_set(METRIC_VIRTUAL_DEVICES, inject_shm_device_count());
+     net_ingest_expire();
+     // Frames held back by per-device budgets join this tick; no motion is lost
+     input_limiter_flush();
+     pointer_accel_expire();
+     fusion_set_layout(&g_fusion, display_manager_get_layout());
+     // Everything on this thread now reads g_fusion.layout; older ones can go
+     display_manager_layout_seen(g_layout_reader, g_fusion.layout_generation);
+     fusion_tick(&g_fusion, now_ms());
+     metrics_gauge_set(METRIC_MICE, g_fusion.count);
+     if (g_fusion.individual && g_fusion.active_mouse != 0) {
+         char buf[64]; snprintf(buf, sizeof(buf), "Mouse_%u", g_fusion.active_mouse);
+         tray_set_active_mouse(buf);
      }
-     if (tw > 0.0) {
-         double avgx = wx / tw;
-         double avgy = wy / tw;
-         double new_x = (double)g_host_x + avgx;
-         double new_y = (double)g_host_y + avgy;
-         g_host_x = (int32_t)((1.0 - g_smoothing) * (double)g_host_x + g_smoothing * new_x);
-         g_host_y = (int32_t)((1.0 - g_smoothing) * (double)g_host_y + g_smoothing * new_y);
+     // Motion, clicks and scroll of this tick go to the X server in one flush
+     evdev_manager_inject_frame(g_fusion.host_x, g_fusion.host_y, g_fusion.button_events, g_fusion.button_event_count,
+                                g_fusion.wheel_steps, g_fusion.hwheel_steps);
+     fusion_clear_output(&g_fusion);
+     if (g_gui_threaded) publish_gui_snapshot();
+     else gui_update((double)g_fusion.host_x, (double)g_fusion.host_y);
+     publish_shared_state();
+     publish_state_stream();
+     metrics_observe_us(METRIC_TICK_US, metrics_now_us() - start_us);
+ }
+
+ // First line of a passphrase file; refuses files readable by group/other
+ static bool read_key_file(const char* path, char* out, size_t out_size) {
+     if (!path || !path[0]) return false;
+     struct stat st;
+     if (stat(path, &st) != 0 || (st.st_mode & 077)) {
+         printf("⚠️  Ignoring audit key file %s (missing or not mode 0600)\n", path);
+         return false;
      }
-     for (int i = 0; i < MAX_MICE; i++) if (g_mice[i].present) { g_mice[i].delta_x = 0; g_mice[i].delta_y = 0; }
-     clamp_to_bounds(&g_host_x, &g_host_y);
+     FILE* f = fopen(path, "r");
+     if (!f) return false;
+     bool ok = fgets(out, (int)out_size, f) != NULL;
+     fclose(f);
+     if (ok) out[strcspn(out, "\r\n")] = '\0';
+     return ok && out[0];
  }
 
  int main(void) {
@@ -141,9 +431,9 @@
      }
 
      display_manager_init();
-     display_manager_get_total_screen_bounds(&g_total_x, &g_total_y, &g_total_w, &g_total_h);
-     g_host_x = g_total_x + g_total_w/2;
-     g_host_y = g_total_y + g_total_h/2;
+     // fusion keeps its layout across ticks, so this thread is a layout reader
+     g_layout_reader = display_manager_register_reader();
+     fusion_init(&g_fusion, display_manager_get_layout());
     if (!gui_init(800, 600, "3 Blind Mice - Linux GUI")) {
         const char* disp = getenv("DISPLAY");
         printf("❌ Failed to open X display.\n");
@@ -153,38 +443,156 @@
         printf("     sudo -E env DISPLAY=:0 XAUTHORITY=~$SUDO_USER/.Xauthority ./build/bin/ThreeBlindMiceC\n");
         return 1;
     }
+    bool gui_threaded = gui_start_thread(60);
+    if (!gui_threaded) {
+        printf("⚠️  GUI render thread unavailable, drawing inline\n");
+    }
     tray_init("3 Blind Mice");
      tray_set_mode("Fused");
-    hipaa_init("/var/log/threeblindmice");
+     gui_set_mode_text("Mode: Fused");
+    hipaa_options_t audit_opts; hipaa_default_options(&audit_opts);
+    audit_opts.format = HIPAA_FORMAT_BINARY; // export with: ThreeBlindMiceAudit export <file>
+    // Rotated segments are encrypted when a passphrase file (0600) is configured
+    char audit_key[256];
+    if (read_key_file(getenv("THREEBLINDMICE_AUDIT_KEYFILE"), audit_key, sizeof(audit_key))) {
+        audit_opts.encryption_passphrase = audit_key;
+        printf("🔒 Audit segments will be encrypted after rotation\n");
+    }
+    hipaa_init_ex("/var/log/threeblindmice", &audit_opts);
+    explicit_bzero(audit_key, sizeof(audit_key));
+    hipaa_rotate(1024*1024*5, 7);
 
      evdev_manager_t* mgr = evdev_manager_create();
      if (!mgr) { printf("❌ Failed to create evdev manager\n"); return 1; }
      if (!evdev_manager_initialize(mgr)) { printf("❌ Failed to initialize evdev manager\n"); return 1; }
-     evdev_manager_set_callback(mgr, on_mouse_input);
+     // Every input source goes through per-device token buckets; frames over
+     // budget are coalesced until the next tick (THREEBLINDMICE_INPUT_RATE_HZ=0 disables)
+     const char* input_rate = getenv("THREEBLINDMICE_INPUT_RATE_HZ");
+     const char* input_burst = getenv("THREEBLINDMICE_INPUT_BURST");
+     input_limiter_init(input_rate && input_rate[0] ? atof(input_rate) : INPUT_LIMITER_DEFAULT_HZ,
+                        input_burst && input_burst[0] ? atof(input_burst) : INPUT_LIMITER_DEFAULT_BURST, on_mouse_input);
+     if (input_limiter_rate() > 0.0) printf("🚦 Input frames limited to %.0f Hz per device\n", input_limiter_rate());
+     device_transform_init();
+     // Default acceleration for every device, e.g. THREEBLINDMICE_ACCEL_PROFILE=adaptive;
+     // per-device profiles and CPI are set over the control socket (accel ID ...)
+     pointer_accel_init();
+     const char* accel_profile = getenv("THREEBLINDMICE_ACCEL_PROFILE");
+     const char* accel_speed = getenv("THREEBLINDMICE_ACCEL_SPEED");
+     pointer_accel_config_t accel = pointer_accel_get_default();
+     if (accel_profile && accel_profile[0] && !pointer_accel_parse_profile(accel_profile, &accel.profile)) {
+         printf("⚠️  Unknown acceleration profile %s, using flat\n", accel_profile);
+     }
+     if (accel_speed && accel_speed[0]) accel.speed = atof(accel_speed);
+     if (pointer_accel_set_default(&accel)) printf("🏎️  Pointer acceleration: %s, speed %.2f\n", pointer_accel_profile_name(accel.profile), accel.speed);
+     else printf("⚠️  Invalid acceleration settings, using flat\n");
+     evdev_manager_set_callback(mgr, ingest_frame);
+     // Buttons an unplugged mouse held are released through fusion
+     evdev_manager_set_removed_callback(mgr, forget_mouse);
 
-     pthread_t th; pthread_create(&th, NULL, keyboard_thread, NULL);
+     g_gui_threaded = gui_threaded;
+     g_start_ms = now_ms();
+
+     // One thread serves everything: a timerfd paces the ticks and poll()
+     // wakes for mouse input, stdin keys and control socket clients
+     int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+     struct itimerspec period = { { 0, TICK_NS }, { 0, TICK_NS } };
+     if (timer_fd >= 0 && timerfd_settime(timer_fd, 0, &period, NULL) != 0) { close(timer_fd); timer_fd = -1; }
+     char control_path[108];
+     control_socket_default_path(control_path, sizeof(control_path));
+     if (control_socket_open(control_path, handle_control_command)) printf("🔌 Control socket: %s\n", control_path);
+     else printf("⚠️  Control socket unavailable at %s\n", control_path);
+     int mouse_fds[MAX_MOUSE_FDS];
+     int mouse_fd_count = evdev_manager_get_fds(mgr, mouse_fds, MAX_MOUSE_FDS);
+     metrics_gauge_set(METRIC_DEVICES, mouse_fd_count);
+     if (state_shm_open()) printf("🧭 Publishing state in shared memory %s\n", state_shm_name());
+     else printf("⚠️  Shared state unavailable (shm_open failed)\n");
+     if (inject_shm_open()) printf("💉 Accepting virtual mice via shared memory %s\n", inject_shm_name());
+     else printf("⚠️  Virtual mouse injection unavailable (shm_open failed)\n");
+     // Remote mice, off unless an address is given, e.g. 127.0.0.1:7447
+     const char* ingest_udp = getenv("THREEBLINDMICE_INGEST_UDP");
+     const char* ingest_ws = getenv("THREEBLINDMICE_INGEST_WS");
+     if (ingest_udp && !ingest_udp[0]) ingest_udp = NULL;
+     if (ingest_ws && !ingest_ws[0]) ingest_ws = NULL;
+     if (ingest_udp || ingest_ws) {
+         // Browser pages are refused unless their origin is listed here
+         const char* ws_origins = getenv("THREEBLINDMICE_INGEST_WS_ORIGINS");
+         if (!net_ingest_set_ws_origins(ws_origins)) printf("⚠️  THREEBLINDMICE_INGEST_WS_ORIGINS too long, no origins allowed\n");
+         if (net_ingest_open(ingest_udp, ingest_ws, ingest_motion, forget_mouse)) {
+             printf("🌐 Remote mice: udp=%s ws=%s\n", ingest_udp ? ingest_udp : "off", ingest_ws ? ingest_ws : "off");
+         } else {
+             printf("⚠️  Remote mouse ingestion unavailable (cannot bind)\n");
+         }
+     }
+     char stream_path[108];
+     state_stream_default_path(stream_path, sizeof(stream_path));
+     const char* stream_hz = getenv("THREEBLINDMICE_STREAM_HZ");
+     int stream_rate = stream_hz && stream_hz[0] ? atoi(stream_hz) : STATE_STREAM_DEFAULT_HZ;
+     if (state_stream_open(stream_path, stream_rate)) printf("📡 State stream: %s\n", stream_path);
+     else printf("⚠️  State stream unavailable at %s\n", stream_path);
+     // Optional node_exporter textfile, e.g. /var/lib/node_exporter/textfile_collector/threeblindmice.prom
+     const char* metrics_file = getenv("THREEBLINDMICE_METRICS_TEXTFILE");
+     if (metrics_file && metrics_file[0] && metrics_start_textfile(metrics_file, 15)) {
+         printf("📈 Writing metrics to %s\n", metrics_file);
+     }
+     // Dropped at EOF, so a closed stdin (systemd) costs nothing
+     bool keys = true;
 
      printf("🎯 Event loop active (keys: m=toggle, i=list, a=active, Ctrl+C exit)\n");
      while (1) {
-        update_weights(); hipaa_rotate(1024*1024*5, 7);
-         if (g_use_individual) {
-             // pick most recently active mouse as active
-             int64_t latest = -1; uint32_t active = 0;
-             for (int i = 0; i < MAX_MICE; i++) if (g_mice[i].present) {
-                 if (g_mice[i].last_activity_ms > latest) { latest = g_mice[i].last_activity_ms; active = g_mice[i].id; }
-             }
-             if (active != 0) {
-                 apply_deltas_individual(active);
-                 char buf[64]; snprintf(buf, sizeof(buf), "Mouse_%u", active);
-                 tray_set_active_mouse(buf);
-             }
-         } else {
-             apply_deltas_fused();
+         struct pollfd fds[3 + MAX_MOUSE_FDS + 1 + CONTROL_MAX_CLIENTS + 1 + STATE_STREAM_MAX_SUBSCRIBERS];
+         int n = 0, timer_at = -1, keys_at = -1, net_at = -1;
+         if (timer_fd >= 0) { timer_at = n; fds[n++] = (struct pollfd){ .fd = timer_fd, .events = POLLIN }; }
+         if (keys) { keys_at = n; fds[n++] = (struct pollfd){ .fd = STDIN_FILENO, .events = POLLIN }; }
+         // All remote-mouse sockets sit behind one epoll fd
+         if (net_ingest_fd() >= 0) { net_at = n; fds[n++] = (struct pollfd){ .fd = net_ingest_fd(), .events = POLLIN }; }
+         int mice_at = n;
+         for (int i = 0; i < mouse_fd_count; i++) fds[n++] = (struct pollfd){ .fd = mouse_fds[i], .events = POLLIN };
+         int control_at = n;
+         n += control_socket_pollfds(fds + n, 1 + CONTROL_MAX_CLIENTS);
+         int stream_at = n;
+         n += state_stream_pollfds(fds + n, (int)(sizeof(fds) / sizeof(fds[0])) - n);
+
+         // Without a timer the poll timeout paces the ticks
+         if (poll(fds, (nfds_t)n, timer_fd >= 0 ? -1 : (int)(TICK_NS / 1000000)) < 0) {
+             if (errno == EINTR) continue;
+             perror("poll");
+             break;
+         }
+         bool devices_changed = false;
+         for (int i = mice_at; i < control_at; i++) {
+             if (fds[i].revents && !evdev_manager_handle_fd(mgr, fds[i].fd)) devices_changed = true;
+         }
+         if (devices_changed) {
+             mouse_fd_count = evdev_manager_get_fds(mgr, mouse_fds, MAX_MOUSE_FDS);
+             metrics_gauge_set(METRIC_DEVICES, mouse_fd_count);
+         }
+         if (net_at >= 0 && fds[net_at].revents) net_ingest_dispatch();
+         if (keys_at >= 0 && fds[keys_at].revents) {
+             char keybuf[64];
+             ssize_t got = read(STDIN_FILENO, keybuf, sizeof(keybuf));
+             if (got <= 0 && !(got < 0 && errno == EINTR)) keys = false;
+             for (ssize_t i = 0; i < got; i++) handle_key(keybuf[i]);
+         }
+         control_socket_dispatch(fds + control_at, stream_at - control_at);
+         state_stream_dispatch(fds + stream_at, n - stream_at);
+         metrics_gauge_set(METRIC_CONTROL_CLIENTS, control_socket_client_count());
+
+         bool due = timer_fd < 0;
+         uint64_t expirations = 0;
+         if (timer_at >= 0 && (fds[timer_at].revents & POLLIN) &&
+             read(timer_fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations)) {
+             due = true;
+             if (expirations > 1) metrics_count(METRIC_TICK_OVERRUNS, expirations - 1);
          }
-         evdev_manager_set_cursor_position(g_host_x, g_host_y);
-         gui_update((double)g_host_x, (double)g_host_y);
-         usleep(5000); // ~200 Hz
+         if (due) tick();
      }
+     control_socket_close();
+     metrics_stop_textfile();
+     state_shm_close();
+     inject_shm_close();
+     net_ingest_close();
+     state_stream_close();
+     pointer_accel_close();
 
      // not reached
      return 0;
@@ -0,0 +1,340 @@
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Device slot that collects ids past METRIC_MAX_DEVICES
+#define DEVICE_OTHER METRIC_MAX_DEVICES
+
+typedef struct {
+    _Atomic uint64_t buckets[METRIC_HIST_BUCKETS];
+    _Atomic uint64_t sum_us;
+} histogram_shard_t;
+
+typedef struct {
+    _Atomic uint32_t id;
+    _Atomic bool used;
+    _Atomic uint64_t events;
+    _Atomic uint64_t motion;
+    _Atomic uint64_t coalesced;
+} device_shard_t;
+
+typedef struct metrics_shard {
+    _Atomic uint64_t counters[METRIC_COUNTER_COUNT];
+    histogram_shard_t histograms[METRIC_HISTOGRAM_COUNT];
+    device_shard_t devices[METRIC_MAX_DEVICES + 1];
+    struct metrics_shard* next;
+} metrics_shard_t;
+
+static _Atomic(metrics_shard_t*) s_shards = NULL;
+static __thread metrics_shard_t* t_shard = NULL;
+static _Atomic int64_t s_gauges[METRIC_GAUGE_COUNT];
+
+static const char* const s_counter_names[METRIC_COUNTER_COUNT][2] = {
+    { "input_events_total", "Relative motion events read from input devices" },
+    { "input_coalesced_total", "Input frames folded into a pending frame by the rate limiter" },
+    { "fusion_ticks_total", "Fusion ticks run" },
+    { "fusion_tick_overruns_total", "Tick deadlines missed while the loop was busy" },
+    { "mode_switches_total", "Switches between fused and individual mode" },
+    { "cursor_injections_total", "Cursor positions sent to the X server" },
+    { "cursor_injection_failures_total", "Cursor positions that could not be injected" },
+    { "button_events_total", "Button presses and releases injected" },
+    { "scroll_steps_total", "Scroll detents injected, vertical and horizontal" },
+    { "control_commands_total", "Commands served on the control socket" },
+    { "audit_records_total", "Records written to the audit log" },
+    { "audit_batches_total", "Batches written to the audit log" },
+    { "audit_bytes_total", "Bytes written to the audit log" },
+    { "audit_dropped_total", "Input events lost to a full audit ring" },
+    { "audit_rotations_total", "Audit log rotations" },
+    { "gui_frames_total", "GUI frames rendered" },
+    { "inject_frames_total", "Frames taken from shared-memory injection rings" },
+    { "inject_backpressure_total", "Producer pushes refused by a full injection ring" },
+    { "net_messages_total", "Remote mouse messages accepted" },
+    { "net_lost_total", "Remote mouse messages missing from the sequence" },
+    { "net_out_of_order_total", "Stale or duplicate remote mouse messages dropped" },
+    { "net_rejected_total", "Malformed remote messages, full client table or connection limit" },
+    { "stream_frames_total", "State stream samples encoded" },
+    { "stream_keyframes_total", "State stream keyframes encoded" },
+    { "stream_bytes_total", "State stream bytes encoded, before fan-out" },
+    { "stream_skipped_total", "State stream frames dropped for slow subscribers" },
+};
+
+static const char* const s_gauge_names[METRIC_GAUGE_COUNT][2] = {
+    { "input_devices", "Open input devices" },
+    { "mice", "Mice tracked by the fusion loop" },
+    { "audit_backlog", "Records waiting in the audit ring at the last drain" },
+    { "control_clients", "Connected control socket clients" },
+    { "virtual_devices", "Devices registered by injection producers" },
+    { "net_clients", "Remote mice seen within the idle timeout" },
+    { "net_ws_connections", "Open WebSocket ingestion connections" },
+    { "stream_subscribers", "Connected state stream subscribers" },
+};
+
+static const char* const s_histogram_names[METRIC_HISTOGRAM_COUNT][2] = {
+    { "fusion_tick_seconds", "Duration of one fusion tick" },
+    { "audit_write_seconds", "Time to hash and write one audit batch" },
+    { "audit_fsync_seconds", "Time spent in fdatasync of the audit log" },
+    { "gui_frame_seconds", "Time to render one GUI frame" },
+};
+
+// First use on a thread allocates its shard and pushes it onto the list
+static metrics_shard_t* shard(void) {
+    if (t_shard) return t_shard;
+    metrics_shard_t* sh = calloc(1, sizeof(*sh));
+    if (!sh) return NULL;
+    sh->next = atomic_load_explicit(&s_shards, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&s_shards, &sh->next, sh, memory_order_release, memory_order_relaxed)) {}
+    t_shard = sh;
+    return sh;
+}
+
+// Single writer per shard: a load and a store, no read-modify-write
+static inline void bump(_Atomic uint64_t* v, uint64_t n) {
+    atomic_store_explicit(v, atomic_load_explicit(v, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+void metrics_count(metric_counter_t counter, uint64_t n) {
+    metrics_shard_t* sh = shard();
+    if (sh && (unsigned)counter < METRIC_COUNTER_COUNT) bump(&sh->counters[counter], n);
+}
+
+void metrics_gauge_set(metric_gauge_t gauge, int64_t value) {
+    if ((unsigned)gauge < METRIC_GAUGE_COUNT) atomic_store_explicit(&s_gauges[gauge], value, memory_order_relaxed);
+}
+
+void metrics_observe_us(metric_histogram_t histogram, uint64_t us) {
+    metrics_shard_t* sh = shard();
+    if (!sh || (unsigned)histogram >= METRIC_HISTOGRAM_COUNT) return;
+    // Bucket i holds values up to 2^i us
+    unsigned b = us <= 1 ? 0 : 64 - (unsigned)__builtin_clzll(us - 1);
+    if (b > METRIC_HIST_BUCKETS - 1) b = METRIC_HIST_BUCKETS - 1;
+    histogram_shard_t* h = &sh->histograms[histogram];
+    bump(&h->buckets[b], 1);
+    bump(&h->sum_us, us);
+}
+
+// This thread's slot for a device, or the shared "other" slot once all are taken
+static device_shard_t* device_slot(metrics_shard_t* sh, uint32_t device_id) {
+    device_shard_t* d = &sh->devices[DEVICE_OTHER];
+    for (int i = 0; i < METRIC_MAX_DEVICES; i++) {
+        device_shard_t* slot = &sh->devices[i];
+        if (!atomic_load_explicit(&slot->used, memory_order_relaxed)) {
+            // Publish the id before the slot becomes visible to readers
+            atomic_store_explicit(&slot->id, device_id, memory_order_relaxed);
+            atomic_store_explicit(&slot->used, true, memory_order_release);
+            d = slot;
+            break;
+        }
+        if (atomic_load_explicit(&slot->id, memory_order_relaxed) == device_id) { d = slot; break; }
+    }
+    return d;
+}
+
+void metrics_device_event(uint32_t device_id, int32_t dx, int32_t dy) {
+    metrics_shard_t* sh = shard();
+    if (!sh) return;
+    device_shard_t* d = device_slot(sh, device_id);
+    bump(&d->events, 1);
+    bump(&d->motion, (uint64_t)llabs((long long)dx) + (uint64_t)llabs((long long)dy));
+}
+
+void metrics_device_coalesced(uint32_t device_id, uint64_t n) {
+    metrics_shard_t* sh = shard();
+    if (sh) bump(&device_slot(sh, device_id)->coalesced, n);
+}
+
+uint64_t metrics_counter_total(metric_counter_t counter) {
+    uint64_t total = 0;
+    if ((unsigned)counter >= METRIC_COUNTER_COUNT) return 0;
+    for (metrics_shard_t* sh = atomic_load_explicit(&s_shards, memory_order_acquire); sh; sh = sh->next) {
+        total += atomic_load_explicit(&sh->counters[counter], memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t metrics_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+typedef struct {
+    char* out;
+    size_t size, len;
+    bool truncated;
+} render_buf_t;
+
+static void emit(render_buf_t* rb, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void emit(render_buf_t* rb, const char* fmt, ...) {
+    if (rb->truncated) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(rb->out + rb->len, rb->size - rb->len, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= rb->size - rb->len) { rb->truncated = true; return; }
+    rb->len += (size_t)n;
+}
+
+// Merged per-device totals; ids seen by several threads are summed
+typedef struct {
+    uint32_t id;
+    bool other;
+    uint64_t events, motion, coalesced;
+} device_total_t;
+
+static size_t merge_devices(metrics_shard_t* head, device_total_t* out, size_t cap) {
+    size_t n = 0;
+    for (metrics_shard_t* sh = head; sh; sh = sh->next) {
+        for (int i = 0; i <= METRIC_MAX_DEVICES; i++) {
+            device_shard_t* d = &sh->devices[i];
+            bool other = i == DEVICE_OTHER;
+            if (!other && !atomic_load_explicit(&d->used, memory_order_acquire)) break;
+            uint64_t events = atomic_load_explicit(&d->events, memory_order_relaxed);
+            uint64_t coalesced = atomic_load_explicit(&d->coalesced, memory_order_relaxed);
+            if (other && events == 0 && coalesced == 0) continue;
+            uint32_t id = other ? 0 : atomic_load_explicit(&d->id, memory_order_relaxed);
+            size_t k = 0;
+            while (k < n && !(out[k].other == other && out[k].id == id)) k++;
+            if (k == n) {
+                if (n == cap) continue;
+                out[n++] = (device_total_t){ .id = id, .other = other };
+            }
+            out[k].events += events;
+            out[k].motion += atomic_load_explicit(&d->motion, memory_order_relaxed);
+            out[k].coalesced += coalesced;
+        }
+    }
+    return n;
+}
+
+size_t metrics_render(char* out, size_t out_size) {
+    render_buf_t rb = { out, out_size, 0, out_size == 0 };
+    metrics_shard_t* head = atomic_load_explicit(&s_shards, memory_order_acquire);
+
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        emit(&rb, "# HELP threeblindmice_%s %s\n# TYPE threeblindmice_%s counter\nthreeblindmice_%s %llu\n",
+             s_counter_names[c][0], s_counter_names[c][1], s_counter_names[c][0], s_counter_names[c][0],
+             (unsigned long long)metrics_counter_total((metric_counter_t)c));
+    }
+    for (int g = 0; g < METRIC_GAUGE_COUNT; g++) {
+        emit(&rb, "# HELP threeblindmice_%s %s\n# TYPE threeblindmice_%s gauge\nthreeblindmice_%s %lld\n",
+             s_gauge_names[g][0], s_gauge_names[g][1], s_gauge_names[g][0], s_gauge_names[g][0],
+             (long long)atomic_load_explicit(&s_gauges[g], memory_order_relaxed));
+    }
+    for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+        uint64_t buckets[METRIC_HIST_BUCKETS] = { 0 };
+        uint64_t sum_us = 0;
+        for (metrics_shard_t* sh = head; sh; sh = sh->next) {
+            for (int b = 0; b < METRIC_HIST_BUCKETS; b++) {
+                buckets[b] += atomic_load_explicit(&sh->histograms[h].buckets[b], memory_order_relaxed);
+            }
+            sum_us += atomic_load_explicit(&sh->histograms[h].sum_us, memory_order_relaxed);
+        }
+        const char* name = s_histogram_names[h][0];
+        emit(&rb, "# HELP threeblindmice_%s %s\n# TYPE threeblindmice_%s histogram\n", name, s_histogram_names[h][1], name);
+        uint64_t cumulative = 0;
+        for (int b = 0; b < METRIC_HIST_BUCKETS - 1; b++) {
+            cumulative += buckets[b];
+            emit(&rb, "threeblindmice_%s_bucket{le=\"%g\"} %llu\n", name, (double)(1ull << b) / 1e6,
+                 (unsigned long long)cumulative);
+        }
+        cumulative += buckets[METRIC_HIST_BUCKETS - 1];
+        emit(&rb, "threeblindmice_%s_bucket{le=\"+Inf\"} %llu\nthreeblindmice_%s_sum %.6f\nthreeblindmice_%s_count %llu\n",
+             name, (unsigned long long)cumulative, name, (double)sum_us / 1e6, name, (unsigned long long)cumulative);
+    }
+
+    device_total_t devices[METRIC_MAX_DEVICES + 1];
+    size_t device_count = merge_devices(head, devices, METRIC_MAX_DEVICES + 1);
+    emit(&rb, "# HELP threeblindmice_device_events_total Motion events per input device\n"
+              "# TYPE threeblindmice_device_events_total counter\n");
+    for (size_t i = 0; i < device_count; i++) {
+        if (devices[i].other) emit(&rb, "threeblindmice_device_events_total{device=\"other\"} %llu\n", (unsigned long long)devices[i].events);
+        else emit(&rb, "threeblindmice_device_events_total{device=\"%u\"} %llu\n", devices[i].id, (unsigned long long)devices[i].events);
+    }
+    emit(&rb, "# HELP threeblindmice_device_motion_total Sum of |dx| + |dy| per input device\n"
+              "# TYPE threeblindmice_device_motion_total counter\n");
+    for (size_t i = 0; i < device_count; i++) {
+        if (devices[i].other) emit(&rb, "threeblindmice_device_motion_total{device=\"other\"} %llu\n", (unsigned long long)devices[i].motion);
+        else emit(&rb, "threeblindmice_device_motion_total{device=\"%u\"} %llu\n", devices[i].id, (unsigned long long)devices[i].motion);
+    }
+    emit(&rb, "# HELP threeblindmice_device_coalesced_total Frames per input device folded into a pending frame by the rate limiter\n"
+              "# TYPE threeblindmice_device_coalesced_total counter\n");
+    for (size_t i = 0; i < device_count; i++) {
+        if (devices[i].other) emit(&rb, "threeblindmice_device_coalesced_total{device=\"other\"} %llu\n", (unsigned long long)devices[i].coalesced);
+        else emit(&rb, "threeblindmice_device_coalesced_total{device=\"%u\"} %llu\n", devices[i].id, (unsigned long long)devices[i].coalesced);
+    }
+    return rb.truncated ? 0 : rb.len;
+}
+
+// Textfile exporter: node_exporter reads whole files, so every update is
+// written to a temporary name and renamed over the previous one
+static char s_textfile_path[1024];
+static int s_textfile_interval = 15;
+static pthread_t s_textfile_thread;
+static atomic_bool s_textfile_running = false;
+static pthread_mutex_t s_textfile_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_textfile_cond = PTHREAD_COND_INITIALIZER;
+
+static bool write_textfile(const char* text, size_t len) {
+    char tmp[1100];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", s_textfile_path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = true;
+    while (ok && len > 0) {
+        ssize_t n = write(fd, text, len);
+        if (n < 0) { if (errno == EINTR) continue; ok = false; break; }
+        text += n; len -= (size_t)n;
+    }
+    if (close(fd) != 0) ok = false;
+    if (ok) ok = rename(tmp, s_textfile_path) == 0;
+    if (!ok) unlink(tmp);
+    return ok;
+}
+
+static void* textfile_thread(void* arg) {
+    (void)arg;
+    static char text[64 * 1024];
+    bool warned = false;
+    while (atomic_load(&s_textfile_running)) {
+        size_t len = metrics_render(text, sizeof(text));
+        if ((len == 0 || !write_textfile(text, len)) && !warned) {
+            printf("⚠️  Could not write metrics to %s\n", s_textfile_path);
+            warned = true;
+        }
+        pthread_mutex_lock(&s_textfile_lock);
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += s_textfile_interval;
+        if (atomic_load(&s_textfile_running)) pthread_cond_timedwait(&s_textfile_cond, &s_textfile_lock, &deadline);
+        pthread_mutex_unlock(&s_textfile_lock);
+    }
+    return NULL;
+}
+
+bool metrics_start_textfile(const char* path, int interval_sec) {
+    if (!path || !path[0] || atomic_load(&s_textfile_running)) return false;
+    snprintf(s_textfile_path, sizeof(s_textfile_path), "%s", path);
+    s_textfile_interval = interval_sec > 0 ? interval_sec : 15;
+    atomic_store(&s_textfile_running, true);
+    if (pthread_create(&s_textfile_thread, NULL, textfile_thread, NULL) != 0) {
+        atomic_store(&s_textfile_running, false);
+        return false;
+    }
+    return true;
+}
+
+void metrics_stop_textfile(void) {
+    if (!atomic_exchange(&s_textfile_running, false)) return;
+    pthread_mutex_lock(&s_textfile_lock);
+    pthread_cond_signal(&s_textfile_cond);
+    pthread_mutex_unlock(&s_textfile_lock);
+    pthread_join(s_textfile_thread, NULL);
+}
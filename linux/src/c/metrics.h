@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Process metrics in Prometheus text exposition format.
+//
+// Counters, histograms and per-device counters are kept in one shard per
+// thread. Only the owning thread writes its shard (plain relaxed stores, no
+// locked instructions or shared cache lines on the hot path); readers sum
+// all shards with relaxed loads. Gauges are single values set by whoever
+// owns the quantity. Shards are never freed, so counts from exited threads
+// stay in the totals.
+
+typedef enum {
+    METRIC_INPUT_EVENTS,        // relative motion events read from evdev
+    METRIC_INPUT_COALESCED,     // frames folded into a pending frame by the input limiter
+    METRIC_TICKS,               // fusion ticks run
+    METRIC_TICK_OVERRUNS,       // tick deadlines missed while the loop was busy
+    METRIC_MODE_SWITCHES,
+    METRIC_INJECTIONS,          // cursor positions sent to the X server
+    METRIC_INJECTION_FAILURES,  // rejected by XTest or no display
+    METRIC_BUTTON_EVENTS,       // button presses and releases injected
+    METRIC_SCROLL_STEPS,        // scroll detents injected, both axes
+    METRIC_CONTROL_COMMANDS,
+    METRIC_AUDIT_RECORDS,       // records written to the audit log
+    METRIC_AUDIT_BATCHES,
+    METRIC_AUDIT_BYTES,
+    METRIC_AUDIT_DROPPED,       // input events lost to a full audit ring
+    METRIC_AUDIT_ROTATIONS,
+    METRIC_GUI_FRAMES,
+    METRIC_INJECT_FRAMES,       // frames taken from shared-memory injection rings
+    METRIC_INJECT_BACKPRESSURE, // producer pushes refused by a full injection ring
+    METRIC_NET_MESSAGES,        // remote mouse messages accepted (UDP or WebSocket)
+    METRIC_NET_LOST,            // sequence gaps: messages that never arrived
+    METRIC_NET_OUT_OF_ORDER,    // stale or duplicate messages dropped
+    METRIC_NET_REJECTED,        // malformed messages, full client table or connection limit
+    METRIC_STREAM_FRAMES,       // state stream samples encoded
+    METRIC_STREAM_KEYFRAMES,
+    METRIC_STREAM_BYTES,        // encoded bytes, before fan-out to subscribers
+    METRIC_STREAM_SKIPPED,      // frames a slow subscriber had no room for
+    METRIC_COUNTER_COUNT
+} metric_counter_t;
+
+typedef enum {
+    METRIC_DEVICES,             // open input devices
+    METRIC_MICE,                // mice tracked by the fusion loop
+    METRIC_AUDIT_BACKLOG,       // records waiting in the audit ring at the last drain
+    METRIC_CONTROL_CLIENTS,
+    METRIC_VIRTUAL_DEVICES,     // devices registered by injection producers
+    METRIC_NET_CLIENTS,         // remote mice seen within the idle timeout
+    METRIC_NET_WS_CONNECTIONS,
+    METRIC_STREAM_SUBSCRIBERS,
+    METRIC_GAUGE_COUNT
+} metric_gauge_t;
+
+// Durations in microseconds, exported in seconds
+typedef enum {
+    METRIC_TICK_US,             // one fusion tick, input to cursor injection
+    METRIC_AUDIT_WRITE_US,      // one audit batch: hash and write
+    METRIC_AUDIT_FSYNC_US,
+    METRIC_GUI_FRAME_US,        // one rendered GUI frame
+    METRIC_HISTOGRAM_COUNT
+} metric_histogram_t;
+
+// Power-of-two buckets: le 1us, 2us, 4us ... 2^21us (~2s), then +Inf
+#define METRIC_HIST_BUCKETS 23
+// Distinct device ids tracked per thread; later ones are counted as "other"
+#define METRIC_MAX_DEVICES 32
+
+void metrics_count(metric_counter_t counter, uint64_t n);
+void metrics_gauge_set(metric_gauge_t gauge, int64_t value);
+void metrics_observe_us(metric_histogram_t histogram, uint64_t us);
+// One motion event from a device: counts the event and its |dx| + |dy|
+void metrics_device_event(uint32_t device_id, int32_t dx, int32_t dy);
+// Frames of a device folded into a pending frame by the input limiter
+void metrics_device_coalesced(uint32_t device_id, uint64_t n);
+
+// Sum of a counter over all threads
+uint64_t metrics_counter_total(metric_counter_t counter);
+
+// Render the exposition into out; returns its length, 0 if out is too small
+size_t metrics_render(char* out, size_t out_size);
+
+// Rewrite path atomically every interval_sec from a background thread
+// (node_exporter textfile collector). Returns false if it could not start.
+bool metrics_start_textfile(const char* path, int interval_sec);
+void metrics_stop_textfile(void);
+
+// Monotonic microseconds, for timing sections
+uint64_t metrics_now_us(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One input frame of a mouse: everything a device reported between two
+// SYN_REPORTs. Sources without wheels or buttons (injection rings, remote
+// mice) send motion-only frames.
+
+// Scroll is carried in hi-res units, as REL_WHEEL_HI_RES reports it
+#define MOUSE_WHEEL_UNITS_PER_DETENT 120
+
+#define MOUSE_BUTTON_LEFT 0x01
+#define MOUSE_BUTTON_RIGHT 0x02
+#define MOUSE_BUTTON_MIDDLE 0x04
+#define MOUSE_BUTTON_COUNT 3
+
+typedef struct {
+    int32_t dx, dy;
+    int32_t wheel;      // vertical scroll, + away from the user
+    int32_t hwheel;     // horizontal scroll, + right
+    uint8_t buttons;    // MOUSE_BUTTON_* held after the frame
+    uint8_t changed;    // MOUSE_BUTTON_* pressed or released in the frame
+} mouse_frame_t;
+
+// A host button transition, as produced by fusion and injected into X
+typedef struct {
+    uint8_t button;     // MOUSE_BUTTON_*
+    bool pressed;
+} mouse_button_event_t;
+
+#ifdef __cplusplus
+}
+#endif
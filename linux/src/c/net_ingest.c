@@ -0,0 +1,484 @@
+// recvmmsg, accept4, strcasestr, memmem
+#define _GNU_SOURCE
+#include "net_ingest.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+
+// Open addressing with linear probing; at most half full
+#define TABLE_SIZE (NET_INGEST_MAX_CLIENTS * 2)
+#define TABLE_MASK (TABLE_SIZE - 1)
+// Datagrams taken per recvmmsg call, and calls per dispatch so a flood
+// cannot starve the tick (epoll is level triggered, the rest waits)
+#define RECV_BATCH 64
+#define RECV_ROUNDS 16
+#define WS_IN_SIZE 4096
+#define WS_ORIGINS_SIZE 1024
+#define EXPIRE_INTERVAL_MS 250
+
+enum { TAG_UDP = 0, TAG_WS_LISTEN = 1, TAG_WS_CONN = 2 };
+
+typedef struct {
+    uint8_t addr[16];        // IPv6, or IPv4-mapped
+    uint32_t client_id;
+    uint32_t device_id;
+    uint32_t last_seq;
+    bool used;
+    int64_t last_seen_ms;
+} remote_client_t;
+
+typedef struct {
+    int fd;
+    bool open;               // handshake done
+    uint8_t addr[16];
+    size_t in_len;
+    uint8_t in[WS_IN_SIZE];
+} ws_conn_t;
+
+static int s_epoll_fd = -1;
+static int s_udp_fd = -1;
+static int s_ws_listen_fd = -1;
+static net_ingest_deliver_t s_deliver = NULL;
+static net_ingest_forget_t s_forget = NULL;
+static remote_client_t s_clients[TABLE_SIZE];
+static int s_client_count = 0;
+static uint32_t s_next_device = 0;
+static ws_conn_t s_ws[NET_INGEST_MAX_WS];
+static int s_ws_count = 0;
+// Comma-separated Origin values accepted on the WebSocket endpoint
+static char s_ws_origins[WS_ORIGINS_SIZE];
+static int64_t s_now_ms = 0;
+static int64_t s_next_expire_ms = 0;
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint32_t get_u32(const uint8_t* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+static int16_t get_i16(const uint8_t* p) { return (int16_t)(uint16_t)(p[0] | p[1] << 8); }
+
+static void address_key(const struct sockaddr_storage* sa, uint8_t out[16]) {
+    memset(out, 0, 16);
+    if (sa->ss_family == AF_INET6) {
+        memcpy(out, &((const struct sockaddr_in6*)sa)->sin6_addr, 16);
+    } else if (sa->ss_family == AF_INET) {
+        out[10] = out[11] = 0xff;
+        memcpy(out + 12, &((const struct sockaddr_in*)sa)->sin_addr, 4);
+    }
+}
+
+static uint32_t client_hash(const uint8_t addr[16], uint32_t client_id) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 16; i++) h = (h ^ addr[i]) * 16777619u;
+    return ((h ^ client_id) * 0x9E3779B1u) >> 7;
+}
+
+static remote_client_t* find_client(const uint8_t addr[16], uint32_t client_id, bool create) {
+    uint32_t i = client_hash(addr, client_id) & TABLE_MASK;
+    for (; s_clients[i].used; i = (i + 1) & TABLE_MASK) {
+        if (s_clients[i].client_id == client_id && memcmp(s_clients[i].addr, addr, 16) == 0) return &s_clients[i];
+    }
+    if (!create || s_client_count >= NET_INGEST_MAX_CLIENTS) return NULL;
+    remote_client_t* c = &s_clients[i];
+    memcpy(c->addr, addr, 16);
+    c->client_id = client_id;
+    c->device_id = NET_INGEST_DEVICE_BASE | (s_next_device++ & 0x3FFFFFFFu);
+    c->used = true;
+    s_client_count++;
+    return c;
+}
+
+// Backward-shift deletion keeps probe chains intact without tombstones
+static void remove_client(uint32_t i) {
+    s_clients[i].used = false;
+    s_client_count--;
+    for (uint32_t j = (i + 1) & TABLE_MASK; s_clients[j].used; j = (j + 1) & TABLE_MASK) {
+        uint32_t home = client_hash(s_clients[j].addr, s_clients[j].client_id) & TABLE_MASK;
+        // Move j into the hole unless its home lies cyclically in (i, j]
+        bool stays = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+        if (stays) continue;
+        s_clients[i] = s_clients[j];
+        s_clients[j].used = false;
+        i = j;
+    }
+}
+
+// One protocol message from addr; false if it was malformed
+static bool ingest_message(const uint8_t addr[16], const uint8_t* msg, size_t len) {
+    if (len < NET_INGEST_HEADER_BYTES || get_u32(msg) != NET_INGEST_MAGIC || msg[4] != NET_INGEST_VERSION) return false;
+    uint32_t count = msg[5];
+    uint32_t flags = (uint32_t)msg[6] | (uint32_t)msg[7] << 8;
+    if (count == 0 || len != NET_INGEST_HEADER_BYTES + 4 * (size_t)count) return false;
+    uint32_t client_id = get_u32(msg + 8);
+    uint32_t seq = get_u32(msg + 12);
+
+    remote_client_t* c = find_client(addr, client_id, false);
+    bool fresh = c == NULL;
+    if (fresh) c = find_client(addr, client_id, true);
+    if (!c) { metrics_count(METRIC_NET_REJECTED, 1); return true; }
+    if (!fresh && !(flags & NET_INGEST_FLAG_RESET)) {
+        int32_t ahead = (int32_t)(seq - c->last_seq);
+        if (ahead <= 0) { metrics_count(METRIC_NET_OUT_OF_ORDER, 1); return true; }
+        if (ahead > 1) metrics_count(METRIC_NET_LOST, (uint64_t)(ahead - 1));
+    }
+    c->last_seq = seq;
+    c->last_seen_ms = s_now_ms;
+    metrics_count(METRIC_NET_MESSAGES, 1);
+
+    int32_t dx = 0, dy = 0;
+    const uint8_t* p = msg + NET_INGEST_HEADER_BYTES;
+    for (uint32_t i = 0; i < count; i++, p += 4) {
+        dx += get_i16(p);
+        dy += get_i16(p + 2);
+    }
+    if (dx || dy) s_deliver(c->device_id, dx, dy);
+    return true;
+}
+
+static void receive_datagrams(void) {
+    static uint8_t bufs[RECV_BATCH][NET_INGEST_MAX_MESSAGE + 1];
+    static struct sockaddr_storage addrs[RECV_BATCH];
+    struct mmsghdr msgs[RECV_BATCH];
+    struct iovec iov[RECV_BATCH];
+    for (int round = 0; round < RECV_ROUNDS; round++) {
+        for (int i = 0; i < RECV_BATCH; i++) {
+            iov[i] = (struct iovec){ .iov_base = bufs[i], .iov_len = sizeof(bufs[i]) };
+            msgs[i].msg_hdr = (struct msghdr){ .msg_name = &addrs[i], .msg_namelen = sizeof(addrs[i]), .msg_iov = &iov[i], .msg_iovlen = 1 };
+        }
+        int n = recvmmsg(s_udp_fd, msgs, RECV_BATCH, MSG_DONTWAIT, NULL);
+        if (n <= 0) return;
+        for (int i = 0; i < n; i++) {
+            uint8_t key[16];
+            address_key(&addrs[i], key);
+            if (!ingest_message(key, bufs[i], msgs[i].msg_len)) metrics_count(METRIC_NET_REJECTED, 1);
+        }
+        if (n < RECV_BATCH) return;
+    }
+}
+
+static bool watch(int fd, uint32_t tag) {
+    struct epoll_event ev = { .events = EPOLLIN, .data.u32 = tag };
+    return epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+static void drop_ws(ws_conn_t* c) {
+    if (c->fd < 0) return;
+    close(c->fd);   // also leaves the epoll set
+    c->fd = -1;
+    s_ws_count--;
+    metrics_gauge_set(METRIC_NET_WS_CONNECTIONS, s_ws_count);
+}
+
+static void accept_ws(void) {
+    while (1) {
+        struct sockaddr_storage sa;
+        socklen_t sa_len = sizeof(sa);
+        int fd = accept4(s_ws_listen_fd, (struct sockaddr*)&sa, &sa_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        int slot = -1;
+        for (int i = 0; i < NET_INGEST_MAX_WS && slot < 0; i++) if (s_ws[i].fd < 0) slot = i;
+        if (slot < 0 || !watch(fd, TAG_WS_CONN + (uint32_t)slot)) {
+            metrics_count(METRIC_NET_REJECTED, 1);
+            close(fd);
+            continue;
+        }
+        ws_conn_t* c = &s_ws[slot];
+        c->fd = fd;
+        c->open = false;
+        c->in_len = 0;
+        address_key(&sa, c->addr);
+        s_ws_count++;
+        metrics_gauge_set(METRIC_NET_WS_CONNECTIONS, s_ws_count);
+    }
+}
+
+// Replies are a few bytes and the socket buffer is empty in practice; a
+// client that cannot take them is dropped instead of buffered for
+static bool ws_send(ws_conn_t* c, const void* data, size_t len) {
+    return send(c->fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT) == (ssize_t)len;
+}
+
+static bool ws_send_frame(ws_conn_t* c, uint8_t opcode, const uint8_t* payload, size_t len) {
+    uint8_t frame[2 + 125];
+    if (len > 125) return false;
+    frame[0] = 0x80 | opcode;
+    frame[1] = (uint8_t)len;
+    memcpy(frame + 2, payload, len);
+    return ws_send(c, frame, 2 + len);
+}
+
+// True if the comma-separated list holds token (ASCII case-insensitive)
+static bool list_has_token(const char* list, size_t len, const char* token, size_t token_len) {
+    const char* p = list;
+    const char* end = list + len;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) p++;
+        const char* start = p;
+        while (p < end && *p != ',') p++;
+        const char* stop = p;
+        while (stop > start && (stop[-1] == ' ' || stop[-1] == '\t')) stop--;
+        if ((size_t)(stop - start) == token_len && strncasecmp(start, token, token_len) == 0) return true;
+    }
+    return false;
+}
+
+// Value of a request header, up to the end of its line; NULL if absent
+static const char* header_value(const char* request, const char* name, size_t* len) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\r\n%s:", name);
+    const char* value = strcasestr(request, pattern);
+    if (!value) return NULL;
+    value += strlen(pattern);
+    while (*value == ' ' || *value == '\t') value++;
+    *len = strcspn(value, "\r\n");
+    while (*len > 0 && (value[*len - 1] == ' ' || value[*len - 1] == '\t')) (*len)--;
+    return value;
+}
+
+static void ws_refuse(ws_conn_t* c, const char* status) {
+    char reply[128];
+    int n = snprintf(reply, sizeof(reply), "HTTP/1.1 %s\r\nConnection: close\r\nContent-Length: 0\r\n\r\n", status);
+    ws_send(c, reply, (size_t)n);
+}
+
+// RFC 6455 opening handshake; false if the request is not a WebSocket
+// upgrade or comes from an origin that is not allowed. Browsers send an
+// Origin with every WebSocket request and can reach loopback, so without an
+// allow-list any page the user visits could move the pointer; native
+// clients send none.
+static bool ws_handshake(ws_conn_t* c, size_t header_len) {
+    static const char guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    c->in[header_len - 1] = '\0';
+    const char* request = (const char*)c->in;
+    size_t line_len = strcspn(request, "\r\n");
+    if (strncmp(request, "GET ", 4) != 0 || line_len < 13 || strncmp(request + line_len - 9, " HTTP/1.1", 9) != 0) {
+        ws_refuse(c, "400 Bad Request");
+        return false;
+    }
+    size_t upgrade_len, connection_len, version_len, key_len, origin_len;
+    const char* upgrade = header_value(request, "Upgrade", &upgrade_len);
+    const char* connection = header_value(request, "Connection", &connection_len);
+    const char* version = header_value(request, "Sec-WebSocket-Version", &version_len);
+    const char* key = header_value(request, "Sec-WebSocket-Key", &key_len);
+    if (!upgrade || !list_has_token(upgrade, upgrade_len, "websocket", 9) ||
+        !connection || !list_has_token(connection, connection_len, "upgrade", 7) ||
+        !version || !list_has_token(version, version_len, "13", 2) ||
+        !key || key_len == 0 || key_len > 64) {
+        ws_refuse(c, "400 Bad Request");
+        return false;
+    }
+    const char* origin = header_value(request, "Origin", &origin_len);
+    if (origin && !list_has_token(s_ws_origins, strlen(s_ws_origins), origin, origin_len)) {
+        metrics_count(METRIC_NET_REJECTED, 1);
+        ws_refuse(c, "403 Forbidden");
+        return false;
+    }
+
+    char joined[64 + sizeof(guid)];
+    memcpy(joined, key, key_len);
+    memcpy(joined + key_len, guid, sizeof(guid) - 1);
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len = 0;
+    if (!EVP_Digest(joined, key_len + sizeof(guid) - 1, digest, &digest_len, EVP_sha1(), NULL)) return false;
+    char accept[64];
+    EVP_EncodeBlock((unsigned char*)accept, digest, (int)digest_len);
+
+    char reply[256];
+    int n = snprintf(reply, sizeof(reply),
+                     "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    return ws_send(c, reply, (size_t)n);
+}
+
+// Process complete frames in the buffer; false if the connection must go
+static bool ws_frames(ws_conn_t* c) {
+    size_t pos = 0;
+    while (c->in_len - pos >= 2) {
+        uint8_t* f = c->in + pos;
+        size_t avail = c->in_len - pos;
+        bool fin = f[0] & 0x80;
+        uint8_t opcode = f[0] & 0x0F;
+        // Client frames must be masked
+        if (!(f[1] & 0x80)) return false;
+        uint64_t len = f[1] & 0x7F;
+        size_t header = 2;
+        if (len == 126) {
+            if (avail < 4) break;
+            len = (uint64_t)f[2] << 8 | f[3];
+            header = 4;
+        } else if (len == 127) {
+            if (avail < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = len << 8 | f[2 + i];
+            header = 10;
+        }
+        // Messages are small; anything larger is not ours
+        if (len > NET_INGEST_MAX_MESSAGE) return false;
+        if (avail < header + 4 + len) break;
+        const uint8_t* mask = f + header;
+        uint8_t* payload = f + header + 4;
+        for (uint64_t i = 0; i < len; i++) payload[i] ^= mask[i & 3];
+        pos += header + 4 + (size_t)len;
+
+        // Fragmented messages are not used by the protocol
+        if (!fin || opcode == 0x0) return false;
+        if (opcode == 0x2) {
+            if (!ingest_message(c->addr, payload, (size_t)len)) metrics_count(METRIC_NET_REJECTED, 1);
+        } else if (opcode == 0x8) {
+            ws_send_frame(c, 0x8, payload, len >= 2 ? 2 : 0);
+            return false;
+        } else if (opcode == 0x9) {
+            if (!ws_send_frame(c, 0xA, payload, (size_t)len)) return false;
+        }
+        // Text and pong frames are ignored
+    }
+    memmove(c->in, c->in + pos, c->in_len - pos);
+    c->in_len -= pos;
+    return true;
+}
+
+static void service_ws(ws_conn_t* c) {
+    while (1) {
+        if (c->in_len == sizeof(c->in)) { drop_ws(c); return; }
+        ssize_t n = recv(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len, MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { drop_ws(c); return; }
+        c->in_len += (size_t)n;
+        if (!c->open) {
+            uint8_t* end = memmem(c->in, c->in_len, "\r\n\r\n", 4);
+            if (!end) continue;
+            size_t header_len = (size_t)(end - c->in) + 4;
+            if (!ws_handshake(c, header_len)) { drop_ws(c); return; }
+            c->open = true;
+            memmove(c->in, c->in + header_len, c->in_len - header_len);
+            c->in_len -= header_len;
+        }
+        if (!ws_frames(c)) { drop_ws(c); return; }
+    }
+}
+
+// Bind a nonblocking socket to "HOST:PORT" or "[V6]:PORT"
+static int bind_address(const char* spec, int type) {
+    char host[256];
+    snprintf(host, sizeof(host), "%s", spec);
+    char* colon = strrchr(host, ':');
+    if (!colon) return -1;
+    *colon = '\0';
+    const char* port = colon + 1;
+    char* name = host;
+    if (name[0] == '[') {
+        name++;
+        char* close_bracket = strchr(name, ']');
+        if (close_bracket) *close_bracket = '\0';
+    }
+    struct addrinfo hints = { .ai_flags = AI_PASSIVE | AI_NUMERICSERV, .ai_socktype = type };
+    struct addrinfo* res = NULL;
+    if (getaddrinfo(name[0] ? name : NULL, port, &hints, &res) != 0) return -1;
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || (type == SOCK_STREAM && listen(fd, 64) != 0)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd >= 0 && type == SOCK_DGRAM) {
+        // Room for bursts from thousands of clients between two dispatches
+        int size = 4 * 1024 * 1024;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    return fd;
+}
+
+bool net_ingest_set_ws_origins(const char* origins) {
+    if (!origins) origins = "";
+    if (strlen(origins) >= sizeof(s_ws_origins)) return false;
+    strcpy(s_ws_origins, origins);
+    return true;
+}
+
+bool net_ingest_open(const char* udp_addr, const char* ws_addr, net_ingest_deliver_t deliver, net_ingest_forget_t forget) {
+    if (s_epoll_fd >= 0 || !deliver || (!udp_addr && !ws_addr)) return false;
+    s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (s_epoll_fd < 0) return false;
+    s_deliver = deliver;
+    s_forget = forget;
+    memset(s_clients, 0, sizeof(s_clients));
+    s_client_count = 0;
+    for (int i = 0; i < NET_INGEST_MAX_WS; i++) s_ws[i].fd = -1;
+    s_ws_count = 0;
+    bool ok = true;
+    if (udp_addr) {
+        s_udp_fd = bind_address(udp_addr, SOCK_DGRAM);
+        ok = s_udp_fd >= 0 && watch(s_udp_fd, TAG_UDP);
+    }
+    if (ok && ws_addr) {
+        s_ws_listen_fd = bind_address(ws_addr, SOCK_STREAM);
+        ok = s_ws_listen_fd >= 0 && watch(s_ws_listen_fd, TAG_WS_LISTEN);
+    }
+    if (!ok) net_ingest_close();
+    return ok;
+}
+
+void net_ingest_close(void) {
+    for (int i = 0; i < NET_INGEST_MAX_WS; i++) drop_ws(&s_ws[i]);
+    if (s_udp_fd >= 0) { close(s_udp_fd); s_udp_fd = -1; }
+    if (s_ws_listen_fd >= 0) { close(s_ws_listen_fd); s_ws_listen_fd = -1; }
+    if (s_epoll_fd >= 0) { close(s_epoll_fd); s_epoll_fd = -1; }
+    s_client_count = 0;
+}
+
+int net_ingest_fd(void) {
+    return s_epoll_fd;
+}
+
+void net_ingest_dispatch(void) {
+    if (s_epoll_fd < 0) return;
+    struct epoll_event events[64];
+    int n = epoll_wait(s_epoll_fd, events, 64, 0);
+    s_now_ms = monotonic_ms();
+    for (int i = 0; i < n; i++) {
+        uint32_t tag = events[i].data.u32;
+        if (tag == TAG_UDP) receive_datagrams();
+        else if (tag == TAG_WS_LISTEN) accept_ws();
+        else if (tag - TAG_WS_CONN < NET_INGEST_MAX_WS && s_ws[tag - TAG_WS_CONN].fd >= 0) service_ws(&s_ws[tag - TAG_WS_CONN]);
+    }
+    metrics_gauge_set(METRIC_NET_CLIENTS, s_client_count);
+}
+
+void net_ingest_expire(void) {
+    if (s_epoll_fd < 0) return;
+    int64_t now = monotonic_ms();
+    if (now < s_next_expire_ms) return;
+    s_next_expire_ms = now + EXPIRE_INTERVAL_MS;
+    for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+        // A backward shift may move an unvisited entry into slot i
+        while (s_clients[i].used && now - s_clients[i].last_seen_ms > NET_INGEST_IDLE_MS) {
+            uint32_t device_id = s_clients[i].device_id;
+            remove_client(i);
+            if (s_forget) s_forget(device_id);
+        }
+    }
+    metrics_gauge_set(METRIC_NET_CLIENTS, s_client_count);
+}
+
+int net_ingest_client_count(void) {
+    return s_client_count;
+}
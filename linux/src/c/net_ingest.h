@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Remote mice over the network, fed into the same fusion tables as evdev
+// devices.
+//
+// Wire format (little endian), one message per UDP datagram or per binary
+// WebSocket message:
+//
+//   u32 magic      NET_INGEST_MAGIC ("TBMN")
+//   u8  version    NET_INGEST_VERSION
+//   u8  count      deltas that follow (1..NET_INGEST_MAX_DELTAS)
+//   u16 flags      NET_INGEST_FLAG_*
+//   u32 client_id  chosen by the client, unique per source address
+//   u32 seq        +1 per message; stale and duplicate messages are dropped
+//   count x { i16 dx, i16 dy }
+//
+// A client batches the deltas it sampled since its last send; the server
+// applies their sum as one motion event. Clients are keyed by (source
+// address, client_id), need no handshake and are forgotten after
+// NET_INGEST_IDLE_MS without traffic. There is no authentication: bind to
+// loopback or a trusted interface.
+//
+// The WebSocket endpoint takes only a well-formed upgrade (GET, HTTP/1.1,
+// Upgrade: websocket, Connection: Upgrade, version 13). Requests carrying an
+// Origin header, which every browser sends, are refused with 403 unless the
+// origin is on the allow-list: a web page must not be able to reach a
+// loopback endpoint and drive the pointer. The list is empty by default.
+//
+// All sockets live in one epoll set whose fd is polled by the main loop;
+// datagrams are read in batches with recvmmsg.
+
+#define NET_INGEST_MAGIC 0x4E4D4254u // "TBMN"
+#define NET_INGEST_VERSION 1
+#define NET_INGEST_HEADER_BYTES 16
+#define NET_INGEST_MAX_DELTAS 255
+#define NET_INGEST_MAX_MESSAGE (NET_INGEST_HEADER_BYTES + 4 * NET_INGEST_MAX_DELTAS)
+#define NET_INGEST_FLAG_RESET 0x0001u   // first message of a session: accept any seq
+#define NET_INGEST_MAX_CLIENTS 4096
+#define NET_INGEST_MAX_WS 256
+#define NET_INGEST_IDLE_MS 5000
+
+// Remote device ids: bit 30 set, never colliding with evdev or injected ids
+#define NET_INGEST_DEVICE_BASE 0x40000000u
+
+typedef void (*net_ingest_deliver_t)(uint32_t device_id, int32_t dx, int32_t dy);
+typedef void (*net_ingest_forget_t)(uint32_t device_id);
+
+// Addresses are "HOST:PORT" or "[V6]:PORT"; either may be NULL to disable
+// that endpoint. forget is called when an idle client is dropped.
+bool net_ingest_open(const char* udp_addr, const char* ws_addr, net_ingest_deliver_t deliver, net_ingest_forget_t forget);
+void net_ingest_close(void);
+// Origins allowed on the WebSocket endpoint, comma-separated and exact, e.g.
+// "http://localhost:3000"; NULL or "" allows none. False if too long.
+bool net_ingest_set_ws_origins(const char* origins);
+// Pollable fd for the main loop (-1 when closed); call dispatch when readable
+int net_ingest_fd(void);
+void net_ingest_dispatch(void);
+// Drop clients idle for NET_INGEST_IDLE_MS; cheap to call every tick
+void net_ingest_expire(void);
+int net_ingest_client_count(void);
+
+// Encode a message into out (at least NET_INGEST_MAX_MESSAGE bytes);
+// returns its length
+static inline size_t net_ingest_encode(uint8_t* out, uint32_t client_id, uint32_t seq, uint16_t flags,
+                                       const int16_t (*deltas)[2], uint8_t count) {
+    uint32_t words[4] = { NET_INGEST_MAGIC, (uint32_t)NET_INGEST_VERSION | (uint32_t)count << 8 | (uint32_t)flags << 16,
+                          client_id, seq };
+    for (int w = 0; w < 4; w++) for (int b = 0; b < 4; b++) out[4 * w + b] = (uint8_t)(words[w] >> (8 * b));
+    uint8_t* p = out + NET_INGEST_HEADER_BYTES;
+    for (int i = 0; i < count; i++, p += 4) {
+        p[0] = (uint8_t)deltas[i][0]; p[1] = (uint8_t)((uint16_t)deltas[i][0] >> 8);
+        p[2] = (uint8_t)deltas[i][1]; p[3] = (uint8_t)((uint16_t)deltas[i][1] >> 8);
+    }
+    return NET_INGEST_HEADER_BYTES + 4 * (size_t)count;
+}
+
+#ifdef __cplusplus
+}
+#endif
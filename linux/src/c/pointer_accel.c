@@ -0,0 +1,285 @@
+#include "pointer_accel.h"
+#include "metrics.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// id -> slot index size, kept below ~60% full
+#define INDEX_BITS 13
+#define INDEX_MASK ((1u << INDEX_BITS) - 1)
+// Speed is counts over at least this long, so bursts of frames delivered
+// together (injection batches, coalesced frames) do not read as infinitely fast
+#define SPEED_WINDOW_US 4000
+// A pause this long starts the estimate over from rest
+#define SPEED_IDLE_US 50000
+#define IDLE_US 10000000ull
+#define SWEEP_PER_EXPIRE 64
+
+// Adaptive profile, after libinput's mouse profile (1000 CPI units per ms)
+#define ADAPTIVE_THRESHOLD 0.4
+#define ADAPTIVE_INCLINE 1.1
+#define ADAPTIVE_MAX 2.0
+// Linear profile: gain at rest 1, +0.5 per unit/ms at speed 0, capped
+#define LINEAR_SLOPE 0.5
+#define LINEAR_MAX 4.0
+// Floor on any gain, as libinput's flat profile: speed -1 slows the pointer
+// right down but never freezes it
+#define MIN_GAIN 0.005
+
+typedef struct {
+    pointer_accel_config_t config;
+    double speed_scale;         // window counts * 1000 / elapsed us -> table index
+    int32_t gain[POINTER_ACCEL_LUT_SIZE];   // Q16, CPI normalisation included
+} accel_lut_t;
+
+typedef struct {
+    uint32_t id;
+    bool present;
+    accel_lut_t* lut;           // own profile, NULL for the default
+    uint64_t last_us;
+    uint64_t window_start_us;
+    uint32_t window_counts;
+    uint16_t speed_index;
+    int32_t rem_x, rem_y;       // Q16 fraction carried between frames
+} accel_device_t;
+
+static accel_device_t s_devices[POINTER_ACCEL_MAX_DEVICES];
+static uint16_t s_index[1u << INDEX_BITS];   // slot + 1, 0 = empty
+static int s_slots = 0;
+static int s_configured = 0;
+static int s_sweep = 0;
+// NULL while the default is flat at unit gain for 1000 CPI: nothing to do
+static accel_lut_t* s_default = NULL;
+static pointer_accel_config_t s_default_config = { POINTER_ACCEL_FLAT, 0.0, POINTER_ACCEL_REFERENCE_CPI };
+
+static uint32_t device_home(uint32_t id) {
+    return (id * 0x9E3779B1u) >> (32 - INDEX_BITS);
+}
+
+static bool config_valid(const pointer_accel_config_t* c) {
+    return c->profile >= POINTER_ACCEL_FLAT && c->profile <= POINTER_ACCEL_ADAPTIVE &&
+           c->speed >= -1.0 && c->speed <= 1.0 && c->cpi >= 100 && c->cpi <= 51200;
+}
+
+// Gain of a profile at a pointer speed in 1000 CPI counts per ms
+static double profile_gain(const pointer_accel_config_t* c, double v) {
+    double s = c->speed;
+    switch (c->profile) {
+    case POINTER_ACCEL_LINEAR: {
+        double gain = 1.0 + v * LINEAR_SLOPE * (1.0 + s);
+        return gain < LINEAR_MAX ? gain : LINEAR_MAX;
+    }
+    case POINTER_ACCEL_ADAPTIVE: {
+        // libinput's speed setting moves the threshold, incline and cap together
+        double threshold = ADAPTIVE_THRESHOLD - 0.25 * s;
+        if (threshold < 0.2) threshold = 0.2;
+        double incline = ADAPTIVE_INCLINE + 0.75 * s;
+        double max = ADAPTIVE_MAX + 1.5 * s;
+        double gain = v < threshold ? fmin(1.0, 0.3 + 10.0 * v) : 1.0 + (v - threshold) * incline;
+        return gain < max ? gain : max;
+    }
+    case POINTER_ACCEL_FLAT:
+    default:
+        return 1.0 + s;
+    }
+}
+
+static accel_lut_t* build_lut(const pointer_accel_config_t* c) {
+    accel_lut_t* lut = malloc(sizeof(*lut));
+    if (!lut) return NULL;
+    lut->config = *c;
+    double norm = (double)POINTER_ACCEL_REFERENCE_CPI / c->cpi;
+    lut->speed_scale = norm * 1000.0 * POINTER_ACCEL_LUT_STEPS_PER_UNIT;
+    for (int i = 0; i < POINTER_ACCEL_LUT_SIZE; i++) {
+        // Middle of the speed bucket
+        double v = (i + 0.5) / POINTER_ACCEL_LUT_STEPS_PER_UNIT;
+        lut->gain[i] = (int32_t)lround(norm * fmax(MIN_GAIN, profile_gain(c, v)) * 65536.0);
+    }
+    return lut;
+}
+
+static bool is_identity(const pointer_accel_config_t* c) {
+    return c->profile == POINTER_ACCEL_FLAT && c->speed == 0.0 && c->cpi == POINTER_ACCEL_REFERENCE_CPI;
+}
+
+void pointer_accel_init(void) {
+    memset(s_devices, 0, sizeof(s_devices));
+    memset(s_index, 0, sizeof(s_index));
+    s_slots = s_configured = s_sweep = 0;
+    s_default = NULL;
+    s_default_config = (pointer_accel_config_t){ POINTER_ACCEL_FLAT, 0.0, POINTER_ACCEL_REFERENCE_CPI };
+}
+
+void pointer_accel_close(void) {
+    for (int i = 0; i < s_slots; i++) {
+        free(s_devices[i].lut);
+        s_devices[i].lut = NULL;
+    }
+    free(s_default);
+    s_default = NULL;
+}
+
+static accel_device_t* find_device(uint32_t id, uint32_t* at) {
+    uint32_t h = device_home(id);
+    for (; s_index[h]; h = (h + 1) & INDEX_MASK) {
+        accel_device_t* d = &s_devices[s_index[h] - 1];
+        if (d->id == id) { if (at) *at = h; return d; }
+    }
+    if (at) *at = h;
+    return NULL;
+}
+
+static accel_device_t* get_device(uint32_t id) {
+    uint32_t h;
+    accel_device_t* d = find_device(id, &h);
+    if (d) return d;
+    for (int i = 0; i < POINTER_ACCEL_MAX_DEVICES; i++) if (!s_devices[i].present) {
+        d = &s_devices[i];
+        s_index[h] = (uint16_t)(i + 1);
+        if (i >= s_slots) s_slots = i + 1;
+        *d = (accel_device_t){ .id = id, .present = true };
+        return d;
+    }
+    return NULL;
+}
+
+static void remove_device(uint32_t h) {
+    accel_device_t* d = &s_devices[s_index[h] - 1];
+    if (d->lut) s_configured--;
+    free(d->lut);
+    d->lut = NULL;
+    d->present = false;
+    while (s_slots > 0 && !s_devices[s_slots - 1].present) s_slots--;
+    // Backward-shift deletion, as in the fusion tables
+    uint32_t hole = h;
+    for (uint32_t j = (h + 1) & INDEX_MASK; s_index[j]; j = (j + 1) & INDEX_MASK) {
+        uint32_t home = device_home(s_devices[s_index[j] - 1].id);
+        bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (stays) continue;
+        s_index[hole] = s_index[j];
+        hole = j;
+    }
+    s_index[hole] = 0;
+}
+
+bool pointer_accel_set_default(const pointer_accel_config_t* config) {
+    if (!config_valid(config)) return false;
+    // Built before it is swapped in, so frames always see a complete table
+    accel_lut_t* lut = is_identity(config) ? NULL : build_lut(config);
+    if (!lut && !is_identity(config)) return false;
+    accel_lut_t* old = s_default;
+    s_default = lut;
+    s_default_config = *config;
+    free(old);
+    return true;
+}
+
+bool pointer_accel_set_device(uint32_t device_id, const pointer_accel_config_t* config) {
+    if (!config_valid(config)) return false;
+    accel_device_t* d = find_device(device_id, NULL);
+    if ((!d || !d->lut) && s_configured >= POINTER_ACCEL_MAX_CONFIGURED) return false;
+    // A device configured as the identity still keeps its own (unit) table,
+    // so it is not affected by the default
+    accel_lut_t* lut = build_lut(config);
+    if (!lut) return false;
+    if (!d) d = get_device(device_id);
+    if (!d) { free(lut); return false; }
+    if (!d->lut) s_configured++;
+    accel_lut_t* old = d->lut;
+    d->lut = lut;
+    free(old);
+    return true;
+}
+
+void pointer_accel_reset_device(uint32_t device_id) {
+    accel_device_t* d = find_device(device_id, NULL);
+    if (!d || !d->lut) return;
+    free(d->lut);
+    d->lut = NULL;
+    s_configured--;
+}
+
+pointer_accel_config_t pointer_accel_get_default(void) {
+    return s_default_config;
+}
+
+bool pointer_accel_get_device(uint32_t device_id, pointer_accel_config_t* out, bool* configured) {
+    const accel_device_t* d = find_device(device_id, NULL);
+    bool own = d && d->lut;
+    if (configured) *configured = own;
+    if (out) *out = own ? d->lut->config : s_default_config;
+    return true;
+}
+
+int pointer_accel_list(uint32_t* ids, int max) {
+    int n = 0;
+    for (int i = 0; i < s_slots && n < max; i++) if (s_devices[i].present && s_devices[i].lut) ids[n++] = s_devices[i].id;
+    return n;
+}
+
+// Cheap |(dx, dy)|: max + min/2, within about 12% of the Euclidean length
+static uint32_t approx_length(int32_t dx, int32_t dy) {
+    uint32_t ax = (uint32_t)(dx < 0 ? -(int64_t)dx : dx), ay = (uint32_t)(dy < 0 ? -(int64_t)dy : dy);
+    return ax > ay ? ax + ay / 2 : ay + ax / 2;
+}
+
+static int32_t carry(int64_t product, int32_t* rem) {
+    int64_t total = product + *rem;
+    int64_t whole = total >> 16;
+    *rem = (int32_t)(total - (whole << 16));
+    return (int32_t)whole;
+}
+
+void pointer_accel_apply(uint32_t device_id, int32_t* dx, int32_t* dy) {
+    if (!s_default && s_configured == 0) return;
+    accel_device_t* d = s_default ? get_device(device_id) : find_device(device_id, NULL);
+    if (!d) return;
+    const accel_lut_t* lut = d->lut ? d->lut : s_default;
+    if (!lut) return;
+
+    uint64_t now_us = metrics_now_us();
+    if (now_us - d->last_us > SPEED_IDLE_US) {
+        d->window_start_us = now_us;
+        d->window_counts = 0;
+        d->speed_index = 0;
+    }
+    d->last_us = now_us;
+    uint32_t length = approx_length(*dx, *dy);
+    d->window_counts = d->window_counts > UINT32_MAX - length ? UINT32_MAX : d->window_counts + length;
+    uint64_t elapsed = now_us - d->window_start_us;
+    if (elapsed >= SPEED_WINDOW_US) {
+        double index = (double)d->window_counts * lut->speed_scale / (double)elapsed;
+        d->speed_index = (uint16_t)(index < POINTER_ACCEL_LUT_SIZE - 1 ? index : POINTER_ACCEL_LUT_SIZE - 1);
+        d->window_start_us = now_us;
+        d->window_counts = 0;
+    }
+    int64_t gain = lut->gain[d->speed_index];
+    *dx = carry(gain * *dx, &d->rem_x);
+    *dy = carry(gain * *dy, &d->rem_y);
+}
+
+void pointer_accel_expire(void) {
+    if (s_slots == 0) return;
+    uint64_t now_us = metrics_now_us();
+    for (int n = 0; n < SWEEP_PER_EXPIRE && s_slots > 0; n++) {
+        if (s_sweep >= s_slots) s_sweep = 0;
+        accel_device_t* d = &s_devices[s_sweep++];
+        uint32_t h;
+        // Configured devices keep their profile however long they are idle
+        if (d->present && !d->lut && now_us - d->last_us > IDLE_US && find_device(d->id, &h)) remove_device(h);
+    }
+}
+
+static const char* const s_profile_names[] = { "flat", "linear", "adaptive" };
+
+const char* pointer_accel_profile_name(pointer_accel_profile_t profile) {
+    return (unsigned)profile <= POINTER_ACCEL_ADAPTIVE ? s_profile_names[profile] : "unknown";
+}
+
+bool pointer_accel_parse_profile(const char* name, pointer_accel_profile_t* out) {
+    for (int i = 0; i <= POINTER_ACCEL_ADAPTIVE; i++) if (strcmp(name, s_profile_names[i]) == 0) {
+        *out = (pointer_accel_profile_t)i;
+        return true;
+    }
+    return false;
+}
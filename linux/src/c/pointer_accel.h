@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pointer acceleration in the ingestion stage, ahead of the per-device
+// transform.
+//
+// Motion is first normalised to 1000 CPI, so a 400 CPI office mouse and a
+// 16000 CPI gaming mouse move the cursor alike, then scaled by a profile
+// that depends on the device's speed. A profile is evaluated once into a
+// lookup table indexed by quantized speed. Per frame the cost is a table
+// lookup and a Q16 multiply; speed is re-estimated every few milliseconds
+// from the counts the device moved.
+//
+// Devices get the default profile unless configured. Changing a profile
+// builds a new table and swaps it in between two frames; input is never
+// held.
+
+typedef enum {
+    POINTER_ACCEL_FLAT = 0,     // constant gain 1 + speed, at least 0.005
+    POINTER_ACCEL_LINEAR,       // gain rises linearly with pointer speed, capped
+    POINTER_ACCEL_ADAPTIVE      // libinput-like: slowed when creeping, flat, then an incline up to a cap
+} pointer_accel_profile_t;
+
+typedef struct {
+    pointer_accel_profile_t profile;
+    double speed;               // -1..1, as libinput's speed setting
+    int cpi;                    // device resolution, counts per inch
+} pointer_accel_config_t;
+
+// Speeds covered by the table, in 1000 CPI counts per millisecond; faster
+// motion uses the last entry
+#define POINTER_ACCEL_LUT_SIZE 512
+#define POINTER_ACCEL_LUT_STEPS_PER_UNIT 32
+// Devices with a configuration of their own
+#define POINTER_ACCEL_MAX_CONFIGURED 256
+// Devices tracked for speed; beyond that frames pass unaccelerated
+#define POINTER_ACCEL_MAX_DEVICES 4608
+#define POINTER_ACCEL_REFERENCE_CPI 1000
+
+void pointer_accel_init(void);
+void pointer_accel_close(void);
+// False when the config is out of range (speed -1..1, cpi 100..51200)
+// or the table of configured devices is full
+bool pointer_accel_set_default(const pointer_accel_config_t* config);
+bool pointer_accel_set_device(uint32_t device_id, const pointer_accel_config_t* config);
+// Back to the default profile
+void pointer_accel_reset_device(uint32_t device_id);
+pointer_accel_config_t pointer_accel_get_default(void);
+// The device's own config, or the default; *configured tells which
+bool pointer_accel_get_device(uint32_t device_id, pointer_accel_config_t* out, bool* configured);
+// Ids of configured devices; returns how many were written
+int pointer_accel_list(uint32_t* ids, int max);
+
+// One frame, in place
+void pointer_accel_apply(uint32_t device_id, int32_t* dx, int32_t* dy);
+// Drop speed state of devices idle for a while; call once per tick
+void pointer_accel_expire(void);
+
+const char* pointer_accel_profile_name(pointer_accel_profile_t profile);
+bool pointer_accel_parse_profile(const char* name, pointer_accel_profile_t* out);
+
+#ifdef __cplusplus
+}
+#endif
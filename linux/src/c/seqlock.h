@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Single-writer sequence lock for publishing plain-data snapshots.
+// The writer never blocks or waits for readers; readers copy the payload and
+// retry if a write overlapped. The counter is odd while a write is in
+// progress. Works across processes when placed in shared memory.
+typedef struct {
+    _Atomic uint32_t seq;
+} seqlock_t;
+
+static inline void seqlock_write_begin(seqlock_t* lock) {
+    uint32_t seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void seqlock_write_end(seqlock_t* lock) {
+    uint32_t seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_release);
+}
+
+// Returns the sequence to validate against; spins while a write is in progress
+static inline uint32_t seqlock_read_begin(const seqlock_t* lock) {
+    uint32_t seq;
+    while ((seq = atomic_load_explicit((_Atomic uint32_t*)&lock->seq, memory_order_acquire)) & 1u) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+    return seq;
+}
+
+// True if the copy taken since seqlock_read_begin may be torn and must be retried
+static inline bool seqlock_read_retry(const seqlock_t* lock, uint32_t seq) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit((_Atomic uint32_t*)&lock->seq, memory_order_relaxed) != seq;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,62 @@
+#include "state_shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static state_shm_t* s_shm = NULL;
+static char s_name[256] = "";
+
+bool state_shm_open(void) {
+    if (s_shm) return true;
+    const char* env = getenv("THREEBLINDMICE_STATE_SHM");
+    snprintf(s_name, sizeof(s_name), "%s", env && env[0] == '/' ? env : STATE_SHM_NAME);
+    // A leftover from a crashed run is replaced rather than reused, so readers
+    // that still map it see a frozen state instead of a torn layout change
+    shm_unlink(s_name);
+    int fd = shm_open(s_name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+    if (ftruncate(fd, sizeof(state_shm_t)) != 0) {
+        close(fd);
+        shm_unlink(s_name);
+        return false;
+    }
+    void* map = mmap(NULL, sizeof(state_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        shm_unlink(s_name);
+        return false;
+    }
+    s_shm = map;
+    // The header is written last: readers ignore the object until magic matches
+    s_shm->version = STATE_SHM_VERSION;
+    s_shm->size = sizeof(state_shm_t);
+    s_shm->writer_pid = (uint32_t)getpid();
+    atomic_store_explicit(&s_shm->lock.seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    s_shm->magic = STATE_SHM_MAGIC;
+    return true;
+}
+
+void state_shm_close(void) {
+    if (!s_shm) return;
+    munmap(s_shm, sizeof(state_shm_t));
+    s_shm = NULL;
+    shm_unlink(s_name);
+}
+
+const char* state_shm_name(void) {
+    return s_name;
+}
+
+state_shm_state_t* state_shm_begin(void) {
+    if (!s_shm) return NULL;
+    seqlock_write_begin(&s_shm->lock);
+    return &s_shm->state;
+}
+
+void state_shm_end(void) {
+    if (s_shm) seqlock_write_end(&s_shm->lock);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "seqlock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fused and per-mouse state published to other processes through a POSIX
+// shared memory object, rewritten once per fusion tick under a seqlock.
+//
+// Readers map the object read-only (PROT_READ) and call state_shm_read at
+// any rate: no syscalls, no locks, and nothing they do can delay the writer.
+// The object is named STATE_SHM_NAME (or $THREEBLINDMICE_STATE_SHM), mode
+// 0600, and removed when the writer exits cleanly.
+//
+// The layout is fixed-size and little endian; readers check magic, version
+// and size before trusting it.
+//
+// The mouse table holds at most STATE_SHM_MAX_MICE entries, far fewer than
+// fusion tracks (FUSION_MAX_MICE), to keep the object small. With more mice
+// present it lists the first STATE_SHM_MAX_MICE in fusion slot order,
+// total_mice counts all of them and STATE_SHM_FLAG_TRUNCATED is set. The
+// state stream (state_stream.h) carries every mouse.
+
+#define STATE_SHM_NAME "/threeblindmice-state"
+#define STATE_SHM_MAGIC 0x53424D54u // "TBMS"
+#define STATE_SHM_VERSION 2
+#define STATE_SHM_MAX_MICE 128
+
+enum {
+    STATE_SHM_MODE_FUSED = 0,
+    STATE_SHM_MODE_INDIVIDUAL = 1
+};
+
+enum {
+    STATE_SHM_FLAG_TRUNCATED = 1u << 0   // total_mice > mouse_count
+};
+
+typedef struct {
+    uint32_t id;
+    int32_t x, y;
+    float weight;
+    int32_t display;            // index in the display layout, -1 if unknown
+    uint32_t reserved;
+    int64_t last_activity_ms;   // CLOCK_MONOTONIC
+} state_shm_mouse_t;
+
+// Payload guarded by the seqlock
+typedef struct {
+    uint64_t tick;              // fusion tick that produced this state
+    int64_t now_ms;             // CLOCK_MONOTONIC at publication
+    int32_t host_x, host_y;     // fused cursor
+    int32_t host_display;
+    uint32_t mode;              // STATE_SHM_MODE_*
+    uint32_t active_mouse;
+    uint32_t mouse_count;       // valid entries in mice
+    uint32_t total_mice;        // mice tracked by fusion, listed or not
+    uint32_t flags;             // STATE_SHM_FLAG_*
+    state_shm_mouse_t mice[STATE_SHM_MAX_MICE];
+} state_shm_state_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;              // sizeof(state_shm_t)
+    uint32_t writer_pid;
+    seqlock_t lock;
+    uint32_t reserved;
+    state_shm_state_t state;
+} state_shm_t;
+
+// Writer (main loop only)
+bool state_shm_open(void);
+void state_shm_close(void);
+// Name of the published object (valid after state_shm_open)
+const char* state_shm_name(void);
+// Payload to fill for this tick, or NULL when not published; the update
+// becomes visible to readers at state_shm_end
+state_shm_state_t* state_shm_begin(void);
+void state_shm_end(void);
+
+// Reader: copy a consistent state (only the used part of the mouse table).
+// False if the layout does not match or a write kept overlapping the copy,
+// e.g. because the writer died mid-update; retry on the next poll.
+static inline bool state_shm_read(const state_shm_t* shm, state_shm_state_t* out) {
+    if (shm->magic != STATE_SHM_MAGIC || shm->version != STATE_SHM_VERSION || shm->size != sizeof(state_shm_t)) return false;
+    for (int attempt = 0; attempt < 64; attempt++) {
+        uint32_t seq = atomic_load_explicit((_Atomic uint32_t*)&shm->lock.seq, memory_order_acquire);
+        if (seq & 1u) continue;
+        memcpy(out, &shm->state, offsetof(state_shm_state_t, mice));
+        uint32_t count = out->mouse_count > STATE_SHM_MAX_MICE ? STATE_SHM_MAX_MICE : out->mouse_count;
+        memcpy(out->mice, shm->state.mice, count * sizeof(state_shm_mouse_t));
+        if (!seqlock_read_retry(&shm->lock, seq)) {
+            out->mouse_count = count;
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,368 @@
+// accept4
+#define _GNU_SOURCE
+#include "state_stream.h"
+#include "fusion.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define HEADER_BYTES 32
+#define KEY_HOST_BYTES 24
+#define KEY_MOUSE_BYTES 16
+// Largest delta entry: id, mask and every field
+#define DELTA_MOUSE_BYTES 17
+#define KEY_MAX_BYTES (HEADER_BYTES + KEY_HOST_BYTES + FUSION_MAX_MICE * KEY_MOUSE_BYTES)
+// A delta never outgrows the keyframe it would replace (see publish)
+#define DELTA_MAX_BYTES (HEADER_BYTES + 1 + 17 + 4 + 2 * FUSION_MAX_MICE * DELTA_MOUSE_BYTES)
+// Room for a keyframe plus a burst of deltas; a subscriber that lets more
+// pile up skips deltas until it drains
+#define SUB_OUT_SIZE (2 * KEY_MAX_BYTES)
+
+typedef struct {
+    int fd;
+    bool need_key;           // no keyframe delivered since joining or since one was skipped
+    size_t out_len;
+    uint8_t* out;
+} subscriber_t;
+
+static int s_listen_fd = -1;
+static char s_path[sizeof(((struct sockaddr_un*)0)->sun_path)] = "";
+static subscriber_t s_subs[STATE_STREAM_MAX_SUBSCRIBERS];
+static int s_sub_count = 0;
+static int64_t s_interval_ms = 1000 / STATE_STREAM_DEFAULT_HZ;
+static int64_t s_next_ms = 0;
+static int s_key_interval = STATE_STREAM_DEFAULT_HZ;   // frames between forced keyframes
+
+static uint32_t s_seq = 0;
+static uint32_t s_key_seq = 0;
+static bool s_have_key = false;
+static uint8_t s_key[KEY_MAX_BYTES];
+static size_t s_key_len = 0;
+static state_stream_mouse_t s_key_mice[FUSION_MAX_MICE];
+static uint32_t s_key_mouse_count = 0;
+static state_stream_sample_t s_key_host;
+static uint8_t s_delta[DELTA_MAX_BYTES];
+
+static uint8_t* put_u16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); return p + 2; }
+static uint8_t* put_u32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i)); return p + 4; }
+static uint8_t* put_u64(uint8_t* p, uint64_t v) { for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i)); return p + 8; }
+
+void state_stream_default_path(char* out, size_t out_size) {
+    const char* env = getenv("THREEBLINDMICE_STREAM_SOCKET");
+    const char* runtime = getenv("XDG_RUNTIME_DIR");
+    if (env && env[0]) snprintf(out, out_size, "%s", env);
+    else if (runtime && runtime[0]) snprintf(out, out_size, "%s/threeblindmice-stream.sock", runtime);
+    else snprintf(out, out_size, "/run/threeblindmice-stream.sock");
+}
+
+bool state_stream_open(const char* path, int rate_hz) {
+    if (!path || s_listen_fd >= 0) return false;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) return false;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    // Same single-instance rule as the control socket: stale files go, live ones stay
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) return false;
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 && connect(probe, (const struct sockaddr*)&addr, sizeof(addr)) == 0;
+        if (probe >= 0) close(probe);
+        if (live || unlink(path) != 0) return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    mode_t old_mask = umask(077);
+    bool ok = bind(fd, (const struct sockaddr*)&addr, sizeof(addr)) == 0;
+    umask(old_mask);
+    if (!ok || listen(fd, STATE_STREAM_MAX_SUBSCRIBERS) != 0) {
+        close(fd);
+        return false;
+    }
+    if (rate_hz < 1) rate_hz = 1;
+    if (rate_hz > 1000) rate_hz = 1000;
+    s_interval_ms = 1000 / rate_hz;
+    s_key_interval = rate_hz;   // at least one keyframe a second
+    for (int i = 0; i < STATE_STREAM_MAX_SUBSCRIBERS; i++) s_subs[i] = (subscriber_t){ .fd = -1 };
+    s_sub_count = 0;
+    s_have_key = false;
+    s_listen_fd = fd;
+    snprintf(s_path, sizeof(s_path), "%s", path);
+    return true;
+}
+
+static void drop_subscriber(subscriber_t* s) {
+    if (s->fd < 0) return;
+    close(s->fd);
+    free(s->out);
+    *s = (subscriber_t){ .fd = -1 };
+    s_sub_count--;
+    metrics_gauge_set(METRIC_STREAM_SUBSCRIBERS, s_sub_count);
+}
+
+void state_stream_close(void) {
+    for (int i = 0; i < STATE_STREAM_MAX_SUBSCRIBERS; i++) drop_subscriber(&s_subs[i]);
+    if (s_listen_fd >= 0) {
+        close(s_listen_fd);
+        s_listen_fd = -1;
+        unlink(s_path);
+    }
+}
+
+int state_stream_subscriber_count(void) {
+    return s_sub_count;
+}
+
+bool state_stream_due(int64_t now_ms) {
+    if (s_sub_count == 0 || now_ms < s_next_ms) return false;
+    // Fixed cadence; after a stall, resume from now instead of bursting
+    s_next_ms = now_ms - s_next_ms < s_interval_ms ? s_next_ms + s_interval_ms : now_ms + s_interval_ms;
+    return true;
+}
+
+// Send what is buffered without blocking; false if the subscriber is gone
+static bool flush_subscriber(subscriber_t* s) {
+    size_t sent = 0;
+    while (sent < s->out_len) {
+        ssize_t n = send(s->fd, s->out + sent, s->out_len - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        sent += (size_t)n;
+    }
+    memmove(s->out, s->out + sent, s->out_len - sent);
+    s->out_len -= sent;
+    return true;
+}
+
+// Queue a whole frame or nothing; frames are never split across a skip
+static bool queue_frame(subscriber_t* s, const uint8_t* frame, size_t len) {
+    if (SUB_OUT_SIZE - s->out_len < len) {
+        metrics_count(METRIC_STREAM_SKIPPED, 1);
+        return false;
+    }
+    memcpy(s->out + s->out_len, frame, len);
+    s->out_len += len;
+    return true;
+}
+
+static void deliver(const uint8_t* frame, size_t len, bool keyframe) {
+    for (int i = 0; i < STATE_STREAM_MAX_SUBSCRIBERS; i++) {
+        subscriber_t* s = &s_subs[i];
+        if (s->fd < 0) continue;
+        bool queued;
+        if (keyframe) {
+            queued = queue_frame(s, frame, len);
+            s->need_key = !queued;
+        } else if (s->need_key) {
+            // Catch up with the keyframe the delta is based on first
+            queued = queue_frame(s, s_key, s_key_len);
+            if (queued) {
+                s->need_key = false;
+                queue_frame(s, frame, len);
+            }
+        } else {
+            queued = queue_frame(s, frame, len);
+        }
+        if (queued && !flush_subscriber(s)) drop_subscriber(s);
+    }
+}
+
+static uint8_t* put_header(uint8_t* p, uint8_t type, const state_stream_sample_t* sample) {
+    p = put_u32(p, 0);   // length, patched by finish_frame
+    *p++ = type;
+    *p++ = STATE_STREAM_VERSION;
+    p = put_u16(p, 0);
+    p = put_u32(p, s_seq);
+    p = put_u32(p, type == STATE_STREAM_KEYFRAME ? s_seq : s_key_seq);
+    p = put_u64(p, sample->tick);
+    return put_u64(p, (uint64_t)sample->now_ms);
+}
+
+static size_t finish_frame(uint8_t* frame, const uint8_t* end) {
+    size_t len = (size_t)(end - frame);
+    put_u32(frame, (uint32_t)(len - 4));
+    return len;
+}
+
+static uint8_t* put_mouse_fields(uint8_t* p, const state_stream_mouse_t* m, uint8_t mask) {
+    if (mask & STATE_STREAM_MOUSE_X) p = put_u32(p, (uint32_t)m->x);
+    if (mask & STATE_STREAM_MOUSE_Y) p = put_u32(p, (uint32_t)m->y);
+    if (mask & STATE_STREAM_MOUSE_WEIGHT) p = put_u16(p, m->weight);
+    if (mask & STATE_STREAM_MOUSE_DISPLAY) p = put_u16(p, (uint16_t)m->display);
+    return p;
+}
+
+static void encode_keyframe(const state_stream_sample_t* sample) {
+    uint8_t* p = put_header(s_key, STATE_STREAM_KEYFRAME, sample);
+    p = put_u32(p, (uint32_t)sample->host_x);
+    p = put_u32(p, (uint32_t)sample->host_y);
+    p = put_u32(p, (uint32_t)sample->host_display);
+    p = put_u32(p, sample->active_mouse);
+    *p++ = sample->mode;
+    *p++ = 0; *p++ = 0; *p++ = 0;
+    uint32_t count = sample->mouse_count > FUSION_MAX_MICE ? FUSION_MAX_MICE : sample->mouse_count;
+    p = put_u32(p, count);
+    for (uint32_t i = 0; i < count; i++) {
+        p = put_u32(p, sample->mice[i].id);
+        p = put_mouse_fields(p, &sample->mice[i], 0x0F);
+    }
+    s_key_len = finish_frame(s_key, p);
+    memcpy(s_key_mice, sample->mice, count * sizeof(state_stream_mouse_t));
+    s_key_mouse_count = count;
+    s_key_host = *sample;
+    s_key_seq = s_seq;
+    s_have_key = true;
+}
+
+static uint8_t mouse_diff(const state_stream_mouse_t* a, const state_stream_mouse_t* b) {
+    uint8_t mask = 0;
+    if (a->x != b->x) mask |= STATE_STREAM_MOUSE_X;
+    if (a->y != b->y) mask |= STATE_STREAM_MOUSE_Y;
+    if (a->weight != b->weight) mask |= STATE_STREAM_MOUSE_WEIGHT;
+    if (a->display != b->display) mask |= STATE_STREAM_MOUSE_DISPLAY;
+    return mask;
+}
+
+// Merge the id-sorted sample against the keyframe; returns the frame length
+static size_t encode_delta(const state_stream_sample_t* sample) {
+    const state_stream_sample_t* k = &s_key_host;
+    uint8_t* p = put_header(s_delta, STATE_STREAM_DELTA, sample);
+    uint8_t host_mask = 0;
+    if (sample->host_x != k->host_x) host_mask |= STATE_STREAM_HOST_X;
+    if (sample->host_y != k->host_y) host_mask |= STATE_STREAM_HOST_Y;
+    if (sample->host_display != k->host_display) host_mask |= STATE_STREAM_HOST_DISPLAY;
+    if (sample->active_mouse != k->active_mouse) host_mask |= STATE_STREAM_HOST_ACTIVE;
+    if (sample->mode != k->mode) host_mask |= STATE_STREAM_HOST_MODE;
+    *p++ = host_mask;
+    if (host_mask & STATE_STREAM_HOST_X) p = put_u32(p, (uint32_t)sample->host_x);
+    if (host_mask & STATE_STREAM_HOST_Y) p = put_u32(p, (uint32_t)sample->host_y);
+    if (host_mask & STATE_STREAM_HOST_DISPLAY) p = put_u32(p, (uint32_t)sample->host_display);
+    if (host_mask & STATE_STREAM_HOST_ACTIVE) p = put_u32(p, sample->active_mouse);
+    if (host_mask & STATE_STREAM_HOST_MODE) *p++ = sample->mode;
+
+    uint8_t* count_at = p;
+    p += 4;
+    uint32_t changes = 0;
+    uint32_t count = sample->mouse_count > FUSION_MAX_MICE ? FUSION_MAX_MICE : sample->mouse_count;
+    uint32_t i = 0, j = 0;
+    while (i < count || j < s_key_mouse_count) {
+        const state_stream_mouse_t* cur = i < count ? &sample->mice[i] : NULL;
+        const state_stream_mouse_t* key = j < s_key_mouse_count ? &s_key_mice[j] : NULL;
+        if (cur && (!key || cur->id < key->id)) {
+            p = put_u32(p, cur->id);
+            *p++ = 0x0F;
+            p = put_mouse_fields(p, cur, 0x0F);
+            changes++;
+            i++;
+        } else if (!cur || key->id < cur->id) {
+            p = put_u32(p, key->id);
+            *p++ = STATE_STREAM_MOUSE_REMOVED;
+            changes++;
+            j++;
+        } else {
+            uint8_t mask = mouse_diff(cur, key);
+            if (mask) {
+                p = put_u32(p, cur->id);
+                *p++ = mask;
+                p = put_mouse_fields(p, cur, mask);
+                changes++;
+            }
+            i++;
+            j++;
+        }
+    }
+    put_u32(count_at, changes);
+    return finish_frame(s_delta, p);
+}
+
+static int compare_id(const void* a, const void* b) {
+    uint32_t x = ((const state_stream_mouse_t*)a)->id, y = ((const state_stream_mouse_t*)b)->id;
+    return x < y ? -1 : x > y;
+}
+
+void state_stream_publish(state_stream_sample_t* sample) {
+    if (s_sub_count == 0) return;
+    if (sample->mouse_count > FUSION_MAX_MICE) sample->mouse_count = FUSION_MAX_MICE;
+    qsort(sample->mice, sample->mouse_count, sizeof(state_stream_mouse_t), compare_id);
+    s_seq++;
+    bool key = !s_have_key || s_seq - s_key_seq >= (uint32_t)s_key_interval;
+    size_t len = 0;
+    if (!key) {
+        len = encode_delta(sample);
+        // Once most of the state has changed a fresh keyframe is as cheap
+        key = len > s_key_len / 2 + HEADER_BYTES;
+    }
+    if (key) {
+        encode_keyframe(sample);
+        metrics_count(METRIC_STREAM_KEYFRAMES, 1);
+        metrics_count(METRIC_STREAM_BYTES, s_key_len);
+        deliver(s_key, s_key_len, true);
+    } else {
+        metrics_count(METRIC_STREAM_BYTES, len);
+        deliver(s_delta, len, false);
+    }
+    metrics_count(METRIC_STREAM_FRAMES, 1);
+}
+
+int state_stream_pollfds(struct pollfd* fds, int max_fds) {
+    int n = 0;
+    if (s_listen_fd < 0 || max_fds <= 0) return 0;
+    fds[n++] = (struct pollfd){ .fd = s_listen_fd, .events = POLLIN };
+    for (int i = 0; i < STATE_STREAM_MAX_SUBSCRIBERS && n < max_fds; i++) {
+        if (s_subs[i].fd < 0) continue;
+        short events = POLLIN;
+        if (s_subs[i].out_len > 0) events |= POLLOUT;
+        fds[n++] = (struct pollfd){ .fd = s_subs[i].fd, .events = events };
+    }
+    return n;
+}
+
+static void accept_subscribers(void) {
+    while (1) {
+        int fd = accept4(s_listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        subscriber_t* slot = NULL;
+        for (int i = 0; i < STATE_STREAM_MAX_SUBSCRIBERS && !slot; i++) if (s_subs[i].fd < 0) slot = &s_subs[i];
+        uint8_t* out = slot ? malloc(SUB_OUT_SIZE) : NULL;
+        if (!out) {
+            close(fd);
+            continue;
+        }
+        *slot = (subscriber_t){ .fd = fd, .need_key = true, .out = out };
+        s_sub_count++;
+        metrics_gauge_set(METRIC_STREAM_SUBSCRIBERS, s_sub_count);
+        // Start from the latest keyframe, or force one at the next sample when
+        // nobody was listening (nothing is encoded then)
+        if (s_have_key && s_sub_count > 1 && queue_frame(slot, s_key, s_key_len)) slot->need_key = false;
+        else s_have_key = false;
+        if (!flush_subscriber(slot)) drop_subscriber(slot);
+    }
+}
+
+void state_stream_dispatch(const struct pollfd* fds, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!fds[i].revents) continue;
+        if (fds[i].fd == s_listen_fd) { accept_subscribers(); continue; }
+        for (int k = 0; k < STATE_STREAM_MAX_SUBSCRIBERS; k++) {
+            subscriber_t* s = &s_subs[k];
+            if (s->fd != fds[i].fd) continue;
+            if (fds[i].revents & POLLOUT && !flush_subscriber(s)) { drop_subscriber(s); break; }
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char sink[256];
+                ssize_t n = recv(s->fd, sink, sizeof(sink), MSG_DONTWAIT);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) drop_subscriber(s);
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <poll.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fused and per-mouse state streamed to observers over a local stream socket.
+//
+// The main loop samples state at a fixed rate and encodes each sample once;
+// every subscriber gets the same bytes, so the cost per observer is one
+// nonblocking send. Samples are keyframes (full state) or deltas holding
+// only the fields that differ from the last keyframe. Because deltas never
+// depend on each other, a subscriber that falls behind just misses deltas;
+// it only has to receive keyframes. Late joiners start from the latest
+// keyframe. Nothing is encoded while nobody is subscribed.
+//
+// Frame layout (little endian):
+//
+//   u32 length        bytes that follow this field
+//   u8  type          STATE_STREAM_KEYFRAME or STATE_STREAM_DELTA
+//   u8  version       STATE_STREAM_VERSION
+//   u16 reserved
+//   u32 seq           frame number
+//   u32 key_seq       keyframe this frame is based on (== seq for keyframes)
+//   u64 tick          fusion tick sampled
+//   i64 now_ms        CLOCK_MONOTONIC at sampling
+//
+// Keyframe body:
+//   i32 host_x, i32 host_y, i32 host_display, u32 active_mouse, u8 mode,
+//   u8 reserved[3], u32 mouse_count, then mouse_count entries sorted by id:
+//   { u32 id, i32 x, i32 y, u16 weight (x 1/10000), i16 display }
+//
+// Delta body:
+//   u8 host_mask (STATE_STREAM_HOST_*), the changed host fields in keyframe
+//   order, u32 change_count, then change_count entries:
+//   { u32 id, u8 mask (STATE_STREAM_MOUSE_*), the changed fields in keyframe
+//   order }. A mouse missing from the keyframe has all field bits set; one
+//   that is gone has only STATE_STREAM_MOUSE_REMOVED.
+//
+// Subscribers only read; anything they send is discarded. Deltas whose
+// key_seq differs from the subscriber's keyframe are to be ignored.
+
+#define STATE_STREAM_VERSION 1
+#define STATE_STREAM_KEYFRAME 1
+#define STATE_STREAM_DELTA 2
+#define STATE_STREAM_MAX_SUBSCRIBERS 32
+#define STATE_STREAM_DEFAULT_HZ 30
+
+#define STATE_STREAM_HOST_X 0x01
+#define STATE_STREAM_HOST_Y 0x02
+#define STATE_STREAM_HOST_DISPLAY 0x04
+#define STATE_STREAM_HOST_ACTIVE 0x08
+#define STATE_STREAM_HOST_MODE 0x10
+
+#define STATE_STREAM_MOUSE_X 0x01
+#define STATE_STREAM_MOUSE_Y 0x02
+#define STATE_STREAM_MOUSE_WEIGHT 0x04
+#define STATE_STREAM_MOUSE_DISPLAY 0x08
+#define STATE_STREAM_MOUSE_REMOVED 0x80
+
+typedef struct {
+    uint32_t id;
+    int32_t x, y;
+    uint16_t weight;            // x 1/10000
+    int16_t display;
+} state_stream_mouse_t;
+
+typedef struct {
+    uint64_t tick;
+    int64_t now_ms;
+    int32_t host_x, host_y, host_display;
+    uint32_t active_mouse;
+    uint8_t mode;               // STATE_SHM_MODE_*
+    uint32_t mouse_count;
+    state_stream_mouse_t* mice; // caller-owned; sorted by id in place
+} state_stream_sample_t;
+
+// Path from $THREEBLINDMICE_STREAM_SOCKET, else $XDG_RUNTIME_DIR/threeblindmice-stream.sock,
+// else /run/threeblindmice-stream.sock
+void state_stream_default_path(char* out, size_t out_size);
+bool state_stream_open(const char* path, int rate_hz);
+void state_stream_close(void);
+
+// True when a sample is due and someone is listening; only then fill one
+bool state_stream_due(int64_t now_ms);
+void state_stream_publish(state_stream_sample_t* sample);
+
+// poll() integration, as for the control socket
+int state_stream_pollfds(struct pollfd* fds, int max_fds);
+void state_stream_dispatch(const struct pollfd* fds, int count);
+int state_stream_subscriber_count(void);
+
+#ifdef __cplusplus
+}
+#endif
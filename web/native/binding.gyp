@@ -0,0 +1,16 @@
+{
+  "targets": [
+    {
+      "target_name": "fusion",
+      "sources": [
+        "fusion_addon.c",
+        "../../linux/src/c/fusion.c",
+        "../../linux/src/c/display_layout.c",
+        "../../linux/src/c/display_index.c"
+      ],
+      "include_dirs": ["../../linux/src/c"],
+      "cflags_c": ["-std=gnu11", "-O2"],
+      "xcode_settings": { "OTHER_CFLAGS": ["-std=gnu11", "-O2"] }
+    }
+  ]
+}
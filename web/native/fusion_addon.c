@@ -0,0 +1,239 @@
+#include <node_api.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fusion.h"
+
+// Node binding for the C fusion engine (linux/src/c/fusion.c), so the web
+// bridge fuses exactly like the native daemon. One tick() call takes every
+// delta gathered since the previous tick as a flat Int32Array of
+// (mouseId, dx, dy) triples and returns the fused host position; the JS
+// thread never runs the per-event weighting itself.
+//
+// The browser clients share one virtual screen, modelled as a single
+// display layout with unit gain that setScreen() replaces.
+
+typedef struct {
+    fusion_t* fusion;
+    DisplayInfo display;
+    float gain;
+    DisplayLayout layout;
+} engine_t;
+
+#define CHECK(call) do { if ((call) != napi_ok) return NULL; } while (0)
+
+static void throw_error(napi_env env, const char* message) {
+    napi_throw_error(env, NULL, message);
+}
+
+// Rebuild the single-display layout; the engine is switched to it at once,
+// so the old index can be freed immediately
+static bool set_screen(engine_t* e, int32_t width, int32_t height) {
+    if (width <= 0 || height <= 0) return false;
+    DisplayRect rect = { 0, 0, width, height };
+    DisplayIndex index;
+    if (!display_index_build(&index, &rect, 1)) return false;
+    DisplayIndex old_index = e->layout.index;
+    memset(&e->display, 0, sizeof(e->display));
+    strcpy(e->display.id, "web");
+    strcpy(e->display.name, "Web clients");
+    e->display.width = width;
+    e->display.height = height;
+    e->display.isPrimary = true;
+    e->display.scaleFactor = 1.0f;
+    e->gain = 1.0f;
+    e->layout.generation++;
+    e->layout.count = 1;
+    e->layout.primary = 0;
+    e->layout.total_x = e->layout.total_y = 0;
+    e->layout.total_width = width;
+    e->layout.total_height = height;
+    e->layout.displays = &e->display;
+    e->layout.gains = &e->gain;
+    e->layout.index = index;
+    if (e->fusion) fusion_set_layout(e->fusion, &e->layout);
+    if (old_index.count > 0) display_index_free(&old_index);
+    return true;
+}
+
+static void engine_finalize(napi_env env, void* data, void* hint) {
+    (void)env;
+    (void)hint;
+    engine_t* e = data;
+    free(e->fusion);
+    if (e->layout.index.count > 0) display_index_free(&e->layout.index);
+    free(e);
+}
+
+static engine_t* unwrap(napi_env env, napi_callback_info info, size_t* argc, napi_value* argv) {
+    napi_value self;
+    void* data = NULL;
+    if (napi_get_cb_info(env, info, argc, argv, &self, NULL) != napi_ok) return NULL;
+    if (napi_unwrap(env, self, &data) != napi_ok) return NULL;
+    return data;
+}
+
+static int32_t int_arg(napi_env env, napi_value value, int32_t fallback) {
+    int32_t out;
+    return napi_get_value_int32(env, value, &out) == napi_ok ? out : fallback;
+}
+
+// new FusionEngine(width, height[, smoothing])
+static napi_value engine_new(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3], self;
+    CHECK(napi_get_cb_info(env, info, &argc, argv, &self, NULL));
+    int32_t width = argc > 0 ? int_arg(env, argv[0], 1920) : 1920;
+    int32_t height = argc > 1 ? int_arg(env, argv[1], 1080) : 1080;
+    engine_t* e = calloc(1, sizeof(*e));
+    if (!e || !set_screen(e, width, height) || !(e->fusion = malloc(sizeof(fusion_t)))) {
+        if (e && e->layout.index.count > 0) display_index_free(&e->layout.index);
+        free(e);
+        throw_error(env, "FusionEngine: out of memory or invalid screen size");
+        return NULL;
+    }
+    fusion_init(e->fusion, &e->layout);
+    double smoothing;
+    if (argc > 2 && napi_get_value_double(env, argv[2], &smoothing) == napi_ok) e->fusion->smoothing = smoothing;
+    if (napi_wrap(env, self, e, engine_finalize, NULL, NULL) != napi_ok) {
+        engine_finalize(env, e, NULL);
+        return NULL;
+    }
+    return self;
+}
+
+// tick(deltas: Int32Array of (id, dx, dy) triples, nowMs) -> [hostX, hostY, activeMouse]
+static napi_value engine_tick(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    engine_t* e = unwrap(env, info, &argc, argv);
+    if (!e || argc < 2) { throw_error(env, "tick(deltas, nowMs)"); return NULL; }
+    double now;
+    CHECK(napi_get_value_double(env, argv[1], &now));
+    bool is_typed;
+    CHECK(napi_is_typedarray(env, argv[0], &is_typed));
+    if (!is_typed) { throw_error(env, "tick: deltas must be an Int32Array"); return NULL; }
+    napi_typedarray_type type;
+    size_t length;
+    void* data;
+    CHECK(napi_get_typedarray_info(env, argv[0], &type, &length, &data, NULL, NULL));
+    if (type != napi_int32_array) { throw_error(env, "tick: deltas must be an Int32Array"); return NULL; }
+
+    const int32_t* d = data;
+    int64_t now_ms = (int64_t)now;
+    for (size_t i = 0; i + 2 < length; i += 3) fusion_input(e->fusion, (uint32_t)d[i], d[i + 1], d[i + 2], now_ms);
+    fusion_tick(e->fusion, now_ms);
+
+    napi_value out, v;
+    CHECK(napi_create_array_with_length(env, 3, &out));
+    CHECK(napi_create_int32(env, e->fusion->host_x, &v));
+    CHECK(napi_set_element(env, out, 0, v));
+    CHECK(napi_create_int32(env, e->fusion->host_y, &v));
+    CHECK(napi_set_element(env, out, 1, v));
+    CHECK(napi_create_uint32(env, e->fusion->active_mouse, &v));
+    CHECK(napi_set_element(env, out, 2, v));
+    return out;
+}
+
+// mice(out: Float64Array) -> count; fills (id, x, y, weight, lastActivityMs)
+// per mouse, as many as fit
+static napi_value engine_mice(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    engine_t* e = unwrap(env, info, &argc, argv);
+    if (!e || argc < 1) { throw_error(env, "mice(out)"); return NULL; }
+    napi_typedarray_type type;
+    size_t length;
+    void* data;
+    if (napi_get_typedarray_info(env, argv[0], &type, &length, &data, NULL, NULL) != napi_ok || type != napi_float64_array) {
+        throw_error(env, "mice: out must be a Float64Array");
+        return NULL;
+    }
+    double* out = data;
+    uint32_t n = 0;
+    for (int i = 0; i < e->fusion->slots && (size_t)(n + 1) * 5 <= length; i++) if (e->fusion->mice[i].present) {
+        const fusion_mouse_t* m = &e->fusion->mice[i];
+        double* row = out + (size_t)n++ * 5;
+        row[0] = m->id;
+        row[1] = m->pos_x;
+        row[2] = m->pos_y;
+        row[3] = m->weight;
+        row[4] = (double)m->last_activity_ms;
+    }
+    napi_value result;
+    CHECK(napi_create_uint32(env, n, &result));
+    return result;
+}
+
+static napi_value engine_set_individual(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    engine_t* e = unwrap(env, info, &argc, argv);
+    bool value;
+    if (!e || argc < 1 || napi_get_value_bool(env, argv[0], &value) != napi_ok) { throw_error(env, "setIndividual(bool)"); return NULL; }
+    e->fusion->individual = value;
+    return NULL;
+}
+
+static napi_value engine_set_physics(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    engine_t* e = unwrap(env, info, &argc, argv);
+    bool value;
+    if (!e || argc < 1 || napi_get_value_bool(env, argv[0], &value) != napi_ok) { throw_error(env, "setPhysics(bool)"); return NULL; }
+    e->fusion->physics = value;
+    e->fusion->velocity_x = e->fusion->velocity_y = 0.0;
+    return NULL;
+}
+
+static napi_value engine_set_screen(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    engine_t* e = unwrap(env, info, &argc, argv);
+    if (!e || argc < 2 || !set_screen(e, int_arg(env, argv[0], 0), int_arg(env, argv[1], 0))) {
+        throw_error(env, "setScreen(width, height)");
+    }
+    return NULL;
+}
+
+static napi_value engine_set_host(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    engine_t* e = unwrap(env, info, &argc, argv);
+    if (!e || argc < 2) { throw_error(env, "setHost(x, y)"); return NULL; }
+    e->fusion->host_x = int_arg(env, argv[0], e->fusion->host_x);
+    e->fusion->host_y = int_arg(env, argv[1], e->fusion->host_y);
+    e->fusion->host_display = display_manager_clamp_to_layout(&e->layout, &e->fusion->host_x, &e->fusion->host_y);
+    return NULL;
+}
+
+static napi_value engine_forget(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    engine_t* e = unwrap(env, info, &argc, argv);
+    uint32_t id;
+    if (!e || argc < 1 || napi_get_value_uint32(env, argv[0], &id) != napi_ok) { throw_error(env, "forget(id)"); return NULL; }
+    napi_value result;
+    CHECK(napi_get_boolean(env, fusion_forget_mouse(e->fusion, id), &result));
+    return result;
+}
+
+static napi_value init(napi_env env, napi_value exports) {
+    napi_property_descriptor methods[] = {
+        { "tick", NULL, engine_tick, NULL, NULL, NULL, napi_default, NULL },
+        { "mice", NULL, engine_mice, NULL, NULL, NULL, napi_default, NULL },
+        { "setIndividual", NULL, engine_set_individual, NULL, NULL, NULL, napi_default, NULL },
+        { "setPhysics", NULL, engine_set_physics, NULL, NULL, NULL, napi_default, NULL },
+        { "setScreen", NULL, engine_set_screen, NULL, NULL, NULL, napi_default, NULL },
+        { "setHost", NULL, engine_set_host, NULL, NULL, NULL, napi_default, NULL },
+        { "forget", NULL, engine_forget, NULL, NULL, NULL, napi_default, NULL },
+    };
+    napi_value cls;
+    CHECK(napi_define_class(env, "FusionEngine", NAPI_AUTO_LENGTH, engine_new, NULL,
+                            sizeof(methods) / sizeof(methods[0]), methods, &cls));
+    CHECK(napi_set_named_property(env, exports, "FusionEngine", cls));
+    CHECK(napi_create_uint32(env, FUSION_MAX_MICE, &cls));
+    CHECK(napi_set_named_property(env, exports, "MAX_MICE", cls));
+    return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, init)
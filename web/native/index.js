@@ -0,0 +1,4 @@
+// Native fusion engine built from linux/src/c (npm run build:native).
+// Throws when the addon has not been built; server.js then falls back to
+// its JavaScript fusion.
+module.exports = require('./build/Release/fusion.node');
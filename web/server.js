@@ -14,6 +14,17 @@ try {
     console.warn('   Install robotjs for host computer cursor control');
 }
 
+// Native fusion engine (npm run build:native): the same C code as the Linux
+// daemon. Without it the JavaScript fusion below is used.
+let nativeFusion = null;
+try {
+    const { FusionEngine } = require('./native');
+    nativeFusion = new FusionEngine(1920, 1080, 0.7);
+    console.log('⚡ Native fusion engine loaded');
+} catch (error) {
+    console.warn('⚠️  Native fusion engine not built - using JavaScript fusion');
+}
+
 const app = express();
 const server = http.createServer(app);
 const io = socketIo(server, {
@@ -57,6 +68,15 @@ let currentHostId = null;
 const eventQueue = new Map(); // Per-client event queue
 const lastEventTime = new Map(); // Per-client last event time
 const EVENT_THROTTLE_MS = 16; // ~60 FPS max
+// Native fusion: deltas are batched and fused once per tick, at the daemon's rate
+const NATIVE_TICK_MS = 5;
+let nativeDeltas = new Int32Array(3 * 1024); // (mouseId, dx, dy) triples
+let nativeDeltaCount = 0;
+let nativeMice = new Float64Array(5 * 64);   // (id, x, y, weight, lastActivity) rows
+let nativeLastBroadcast = 0;
+let nextNativeMouseId = 1;
+const nativeMouseIds = new Map();  // clientId -> native mouse id
+const nativeClientIds = new Map(); // native mouse id -> clientId
 // Dynamic screen dimensions and scaling
 let screenDimensions = { width: 1920, height: 1080 }; // Default, will be updated by clients
 // Socket.IO connection management
@@ -188,6 +208,14 @@ function processMouseMove(clientId, deltaX, deltaY) {
 
 // Clean up disconnected clients
 function cleanupClient(clientId) {
+    // Drop the client's mouse from the native engine
+    const nativeId = nativeMouseIds.get(clientId);
+    if (nativeFusion && nativeId !== undefined) {
+        nativeFusion.forget(nativeId);
+        nativeMouseIds.delete(clientId);
+        nativeClientIds.delete(nativeId);
+    }
+    
     // Remove from active mice
     activeMouseIds.delete(clientId);
     
@@ -326,6 +354,7 @@ io.on('connection', (socket) => {
     socket.on('screenDimensions', (data) => {
         const { width, height } = data;
         screenDimensions = { width, height };
+        if (nativeFusion && width > 0 && height > 0) nativeFusion.setScreen(width, height);
         coordinateScale.set(clientId, {
             scaleX: width / 1920,
             scaleY: height / 1080
@@ -338,6 +367,12 @@ io.on('connection', (socket) => {
         const { deltaX, deltaY, timestamp } = data;
         const currentTime = Date.now();
         
+        // Native fusion batches every delta into the next tick; no throttling needed
+        if (nativeFusion) {
+            queueNativeDelta(clientId, deltaX, deltaY, currentTime);
+            return;
+        }
+        
         // Throttle events to prevent spam
         const lastTime = lastEventTime.get(clientId) || 0;
         if (currentTime - lastTime < EVENT_THROTTLE_MS) {
@@ -371,6 +406,7 @@ io.on('connection', (socket) => {
     socket.on('toggleMode', () => {
         if (clientId === currentHostId) {
             useIndividualMode = !useIndividualMode;
+            if (nativeFusion) nativeFusion.setIndividual(useIndividualMode);
             // Clear active mice when switching modes
             activeMouseIds.clear();
             console.log(`🔄 Mode switched to: ${useIndividualMode ? 'Individual' : 'Fused'}`);
@@ -386,6 +422,7 @@ io.on('connection', (socket) => {
         if (clientId === currentHostId) {
             usePhysics = !usePhysics;
             hostVelocity = { x: 0, y: 0 };
+            if (nativeFusion) nativeFusion.setPhysics(usePhysics);
             console.log(`🪐 Physics ${usePhysics ? 'ENABLED' : 'DISABLED'}`);
             io.emit('physicsChanged', { physicsEnabled: usePhysics });
         }
@@ -396,6 +433,7 @@ io.on('connection', (socket) => {
         if (clientId === currentHostId && config.enableHostCursorControl && robot) {
             const { x, y } = data;
             hostCursorPosition = { x, y };
+            if (nativeFusion) nativeFusion.setHost(x, y);
             try {
                 robot.moveMouse(x, y);
                 console.log(`🎯 Host cursor moved to: (${x}, ${y})`);
@@ -564,6 +602,69 @@ function fuseAndMoveCursor() {
     for (const mouse of mouseData.values()) { mouse.deltaX = 0; mouse.deltaY = 0; }
 }
 
+// Native fusion: record one client delta for the next tick
+function queueNativeDelta(clientId, deltaX, deltaY, currentTime) {
+    const clientInfo = clients.get(clientId);
+    if (clientInfo) clientInfo.lastActivity = currentTime;
+    let nativeId = nativeMouseIds.get(clientId);
+    if (nativeId === undefined) {
+        nativeId = nextNativeMouseId++;
+        nativeMouseIds.set(clientId, nativeId);
+        nativeClientIds.set(nativeId, clientId);
+        mouseData.set(clientId, { deltaX: 0, deltaY: 0, timestamp: currentTime });
+    }
+    mouseActivity.set(clientId, currentTime);
+    if (nativeDeltaCount * 3 + 3 > nativeDeltas.length) {
+        const grown = new Int32Array(nativeDeltas.length * 2);
+        grown.set(nativeDeltas);
+        nativeDeltas = grown;
+    }
+    const at = nativeDeltaCount++ * 3;
+    nativeDeltas[at] = nativeId;
+    nativeDeltas[at + 1] = deltaX | 0;
+    nativeDeltas[at + 2] = deltaY | 0;
+}
+
+// Native fusion: one engine call per tick for every queued delta
+function nativeFusionTick() {
+    const currentTime = Date.now();
+    const received = nativeDeltaCount > 0;
+    const [x, y, active] = nativeFusion.tick(nativeDeltas.subarray(0, nativeDeltaCount * 3), currentTime);
+    nativeDeltaCount = 0;
+    // The engine keeps moving the cursor while its physics coasts, so a tick
+    // without new deltas still counts when the position changed
+    const previous = hostCursorPosition;
+    if (!received && x === previous.x && y === previous.y) return;
+    hostCursorPosition = { x, y };
+    if (useIndividualMode) {
+        activeMouseIds.clear();
+        const activeClient = nativeClientIds.get(active);
+        if (activeClient) activeMouseIds.add(activeClient);
+    }
+    if (config.enableHostCursorControl && robot && (x !== previous.x || y !== previous.y)) {
+        try { robot.moveMouse(x, y); } catch (e) {}
+    }
+    if (currentTime - nativeLastBroadcast >= EVENT_THROTTLE_MS) {
+        nativeLastBroadcast = currentTime;
+        readNativeMice();
+        broadcastMouseUpdate();
+    }
+}
+
+// Copy per-mouse positions and weights out of the engine for broadcasting
+function readNativeMice() {
+    if (nativeMice.length < nativeMouseIds.size * 5) nativeMice = new Float64Array(nativeMouseIds.size * 10);
+    const count = nativeFusion.mice(nativeMice);
+    for (let i = 0; i < count; i++) {
+        const clientId = nativeClientIds.get(nativeMice[i * 5]);
+        if (!clientId) continue;
+        mousePositions.set(clientId, { x: nativeMice[i * 5 + 1], y: nativeMice[i * 5 + 2] });
+        mouseWeights.set(clientId, nativeMice[i * 5 + 3]);
+    }
+}
+
+if (nativeFusion) setInterval(nativeFusionTick, NATIVE_TICK_MS);
+
 // Broadcast mouse data to all clients
 function broadcastMouseUpdate() {
     const mice = Array.from(mouseData.entries()).map(([id, data]) => ({